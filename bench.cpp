@@ -0,0 +1,622 @@
+#include <new>
+#include <set>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <numbers>
+#include <string_view>
+#include <unordered_map>
+
+#include <util/arx.hpp>
+#include <util/logger.hpp>
+#include <geometry/mesh_loader.hpp>
+#include <geometry/point_cloud_io.hpp>
+#include <geometry/synthetic_data.hpp>
+#include <graphics/gl_backends.hpp>
+#include <graphics/renderers/mesh_renderer.hpp>
+#include <graphics/renderers/mesh_line_renderer.hpp>
+#include <graphics/renderers/mesh_point_renderer.hpp>
+#include <graphics/renderers/point_cloud_renderer.hpp>
+
+
+using bench_arx = ztu::arx<
+	ztu::arx_flag<'\0', "points", unsigned int>,
+	ztu::arx_flag<'\0', "grid", unsigned int>,
+	ztu::arx_flag<'\0', "materials", unsigned int>,
+	ztu::arx_flag<'\0', "instances", unsigned int>,
+	ztu::arx_flag<'r', "repetitions", unsigned int>,
+	ztu::arx_flag<'t', "threads", unsigned int>,
+	ztu::arx_flag<'d', "directory", std::string>,
+	ztu::arx_flag<'f', "filter", std::string>
+>;
+
+// Has to match the mesh type the viewer loads obj files into.
+using bench_mesh = mesh<vertex_components::tex_coord, vertex_components::normal>;
+
+//----------------------[ Allocation Counting ]----------------------//
+
+// Every allocation of the process is counted, including those of the job system workers.
+static std::atomic<ztu::u64> s_num_allocations{ 0 };
+static std::atomic<ztu::u64> s_num_allocated_bytes{ 0 };
+
+void* operator new(const std::size_t size) {
+	s_num_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (const auto ptr = std::malloc(std::max(size, std::size_t{ 1 }))) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+	s_num_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	// 'aligned_alloc' only accepts multiples of the alignment.
+	const auto align = static_cast<std::size_t>(alignment);
+	const auto aligned_size = (std::max(size, std::size_t{ 1 }) + align - 1) / align * align;
+	if (const auto ptr = std::aligned_alloc(align, aligned_size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+// Not inlined, otherwise GCC warns about 'free' being called on memory from 'operator new'.
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t) noexcept {
+	std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+	std::free(ptr);
+}
+
+//----------------------[ Resident Set Size ]----------------------//
+
+// Both only work on Linux, elsewhere the peak is reported as zero.
+void reset_peak_rss() {
+	auto out = std::ofstream("/proc/self/clear_refs");
+	out << "5";
+}
+
+ztu::u64 peak_rss() {
+	auto in = std::ifstream("/proc/self/status");
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.starts_with("VmHWM:")) {
+			return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+		}
+	}
+	return 0;
+}
+
+//----------------------[ Measurement ]----------------------//
+
+struct workload {
+	ztu::u64 num_bytes;
+	ztu::u64 num_elements;
+	const char* element_name;
+};
+
+/**
+ * Runs the function 'repetitions' times and logs the median time with the throughput derived from it,
+ * the peak resident set size over all runs and the allocations of a single run.
+ * The median is also written to 'median_seconds' if given.
+ */
+std::error_code run_benchmark(
+	const std::string& name,
+	const workload& work,
+	const unsigned int repetitions,
+	const std::function<std::error_code()>& function,
+	double* median_seconds = nullptr
+) {
+	using clock = std::chrono::steady_clock;
+
+	std::vector<double> seconds;
+	seconds.reserve(repetitions);
+
+	ztu::u64 num_allocations = 0, num_allocated_bytes = 0;
+
+	reset_peak_rss();
+
+	for (unsigned int i = 0; i < repetitions; i++) {
+		const auto allocations_before = s_num_allocations.load(std::memory_order_relaxed);
+		const auto allocated_bytes_before = s_num_allocated_bytes.load(std::memory_order_relaxed);
+		const auto begin = clock::now();
+
+		if (const auto e = function(); e) {
+			error<"%: %">(name, e.message());
+			return e;
+		}
+
+		const auto end = clock::now();
+		num_allocations = s_num_allocations.load(std::memory_order_relaxed) - allocations_before;
+		num_allocated_bytes = s_num_allocated_bytes.load(std::memory_order_relaxed) - allocated_bytes_before;
+		seconds.push_back(std::chrono::duration<double>(end - begin).count());
+	}
+
+	std::sort(seconds.begin(), seconds.end());
+
+	static constexpr auto mebibyte = double(1 << 20);
+	const auto median = std::max(seconds[seconds.size() / 2], 1e-9);
+
+	info<"%: median % ms (min % ms), % MiB/s, % M%/s, peak RSS % MiB, % allocations (% MiB) per run">(
+		name,
+		median * 1000.0,
+		seconds.front() * 1000.0,
+		double(work.num_bytes) / mebibyte / median,
+		double(work.num_elements) / 1e6 / median,
+		work.element_name,
+		double(peak_rss()) / mebibyte,
+		num_allocations,
+		double(num_allocated_bytes) / mebibyte
+	);
+
+	if (median_seconds) {
+		*median_seconds = median;
+	}
+
+	return {};
+}
+
+int main(int num_args, char* args[]) {
+
+	//----------------------[ Argument Parsing ]----------------------//
+
+	bench_arx arguments(num_args, args);
+
+	if (arguments.num_positional() != 0) {
+		error<
+			"Usage: % [--points <n>] [--grid <n>] [--materials <n>] [--instances <n>] [-r <repetitions>] [-t <threads>] "
+			"[-d <directory>] [-f <filter>]"
+		>(args[0]);
+		return -1;
+	}
+
+	namespace fs = std::filesystem;
+
+	const auto num_points = arguments.get<"points">().value_or(1'000'000);
+	const auto grid_size = arguments.get<"grid">().value_or(512);
+	const auto num_materials = arguments.get<"materials">().value_or(10'000);
+	const auto num_instances = arguments.get<"instances">().value_or(100'000);
+	const auto repetitions = std::max(arguments.get<"repetitions">().value_or(5), 1u);
+	const auto num_threads = std::max(arguments.get<"threads">().value_or(1), 1u);
+	const auto directory = fs::path{
+		arguments.get<"directory">().value_or((fs::temp_directory_path() / "3d_bench").string())
+	};
+	const auto filter = arguments.get<"filter">();
+
+	if (std::error_code e; not fs::create_directories(directory, e) and e) {
+		error<"Cannot create directory %: %">(directory, e.message());
+		return -1;
+	}
+
+	const auto selected = [&](const std::string_view name) {
+		return not filter or name.find(*filter) != std::string_view::npos;
+	};
+
+	// Inputs are only generated for the selected benchmarks and removed again at the end.
+	std::set<fs::path> generated_files;
+
+	const auto generate = [&](const fs::path& filename, const auto& write) -> std::error_code {
+		if (generated_files.contains(filename)) {
+			return {};
+		}
+		info<"Generating %">(filename);
+		if (const auto e = write(); e) {
+			error<"Cannot generate %: %">(filename, e.message());
+			return e;
+		}
+		generated_files.insert(filename);
+		return {};
+	};
+
+	const auto generate_3dtk_scan = [&](const fs::path& base_filename, const bool reflectance, const bool hex) {
+		auto point_filename = base_filename, pose_filename = base_filename;
+		point_filename.replace_extension(".3d");
+		pose_filename.replace_extension(".pose");
+		generated_files.insert(pose_filename);
+		return generate(point_filename, [&]() {
+			return synthetic_data::write_3dtk_scan(base_filename, num_points, reflectance, hex);
+		});
+	};
+
+	const auto scan_filename = [&](const bool reflectance, const bool hex) {
+		return directory / (std::string("scan_") + (reflectance ? "reflectance" : "basic") + (hex ? "_hex" : "_decimal"));
+	};
+
+	auto num_failed = 0;
+
+	//----------------------[ 3dtk Scans ]----------------------//
+
+	const auto bench_analyze_3dtk = [&]() {
+		if (not selected("analyze_3dtk_file")) {
+			return;
+		}
+
+		ztu::u64 num_bytes = 0;
+		for (const auto reflectance : { false, true }) {
+			for (const auto hex : { false, true }) {
+				auto filename = scan_filename(reflectance, hex);
+				if (generate_3dtk_scan(filename, reflectance, hex)) {
+					num_failed++;
+					return;
+				}
+				filename.replace_extension(".3d");
+				num_bytes += fs::file_size(filename);
+			}
+		}
+
+		const auto work = workload{ .num_bytes = num_bytes, .num_elements = 4, .element_name = "files" };
+		num_failed += run_benchmark("analyze_3dtk_file", work, repetitions, [&]() -> std::error_code {
+			for (const auto reflectance : { false, true }) {
+				for (const auto hex : { false, true }) {
+					auto filename = scan_filename(reflectance, hex);
+					filename.replace_extension(".3d");
+
+					ztu::u32 num_floats{};
+					std::chars_format format{};
+					if (const auto e = point_cloud_loader::analyze_3dtk_file(filename, num_floats, format); e) {
+						return e;
+					}
+					if (num_floats != (reflectance ? 4 : 3) or (format == std::chars_format::hex) != hex) {
+						return std::make_error_code(std::errc::invalid_argument);
+					}
+				}
+			}
+			return {};
+		}) ? 1 : 0;
+	};
+
+	const auto bench_3dtk = [&]<bool Reflectance, bool Hex>() {
+		const auto name = std::string("load_from_3dtk_file<") +
+			(Reflectance ? "true" : "false") + ", " + (Hex ? "true" : "false") + ">";
+		if (not selected(name)) {
+			return;
+		}
+
+		const auto base_filename = scan_filename(Reflectance, Hex);
+		if (generate_3dtk_scan(base_filename, Reflectance, Hex)) {
+			num_failed++;
+			return;
+		}
+
+		auto point_filename = base_filename, pose_filename = base_filename;
+		point_filename.replace_extension(".3d");
+		pose_filename.replace_extension(".pose");
+
+		const auto work = workload{
+			.num_bytes = fs::file_size(point_filename) + fs::file_size(pose_filename),
+			.num_elements = num_points,
+			.element_name = "points"
+		};
+
+		num_failed += run_benchmark(name, work, repetitions, [&]() -> std::error_code {
+			std::vector<point_cloud_loader::basic_vertex> basic_points;
+			std::vector<point_cloud_loader::reflectance_vertex> reflectance_points;
+			auto pose = glm::identity<glm::mat4>();
+
+			if (const auto e = point_cloud_loader::load_from_3dtk_file<Reflectance, Hex>(
+				base_filename, basic_points, reflectance_points, pose, num_threads
+			); e) {
+				return e;
+			}
+			if ((Reflectance ? reflectance_points.size() : basic_points.size()) != num_points) {
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+			return {};
+		}) ? 1 : 0;
+	};
+
+	bench_analyze_3dtk();
+	bench_3dtk.template operator()<false, false>();
+	bench_3dtk.template operator()<false, true>();
+	bench_3dtk.template operator()<true, false>();
+	bench_3dtk.template operator()<true, true>();
+
+	//----------------------[ Version 1 c3d Files ]----------------------//
+
+	const auto bench_v1_c3d = [&]() {
+		if (not selected("write_v1_c3d_file") and not selected("load_v1_c3d_file")) {
+			return;
+		}
+
+		const auto filename = directory / "points_v1.c3d";
+
+		std::vector<point_cloud_loader::reflectance_vertex> points;
+		synthetic_data::generate_points(num_points, points);
+
+		if (generate(filename, [&]() { return point_cloud_loader::write_v1_c3d_file(filename, points); })) {
+			num_failed++;
+			return;
+		}
+
+		const auto work = workload{
+			.num_bytes = fs::file_size(filename),
+			.num_elements = num_points,
+			.element_name = "points"
+		};
+
+		if (selected("write_v1_c3d_file")) {
+			num_failed += run_benchmark("write_v1_c3d_file", work, repetitions, [&]() {
+				return point_cloud_loader::write_v1_c3d_file(filename, points);
+			}) ? 1 : 0;
+		}
+
+		if (selected("load_v1_c3d_file")) {
+			num_failed += run_benchmark("load_v1_c3d_file", work, repetitions, [&]() -> std::error_code {
+				std::vector<point_cloud_loader::reflectance_vertex> loaded_points;
+				if (const auto e = point_cloud_loader::load_v1_c3d_file(filename, loaded_points); e) {
+					return e;
+				}
+				if (loaded_points.size() != num_points) {
+					return std::make_error_code(std::errc::invalid_argument);
+				}
+				return {};
+			}) ? 1 : 0;
+		}
+	};
+
+	bench_v1_c3d();
+
+	//----------------------[ Meshes ]----------------------//
+
+	const auto bench_obj = [&](const bool with_attributes) {
+		const auto name = std::string(with_attributes ? "load_from_obj grid vt vn" : "load_from_obj grid");
+		if (not selected(name)) {
+			return;
+		}
+
+		const auto filename = directory / (with_attributes ? "grid_vt_vn.obj" : "grid.obj");
+		if (generate(filename, [&]() {
+			return synthetic_data::write_grid_obj(filename, grid_size, with_attributes, with_attributes);
+		})) {
+			num_failed++;
+			return;
+		}
+
+		const auto work = workload{
+			.num_bytes = fs::file_size(filename),
+			.num_elements = ztu::u64{ grid_size } * grid_size,
+			.element_name = "vertices"
+		};
+
+		num_failed += run_benchmark(name, work, repetitions, [&]() -> std::error_code {
+			std::vector<bench_mesh> meshes;
+			std::unordered_map<std::string, std::shared_ptr<material>> materials;
+			if (const auto e = mesh_loader::load_from_obj(filename, meshes, materials, true); e) {
+				return e;
+			}
+			if (meshes.empty()) {
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+			return {};
+		}) ? 1 : 0;
+	};
+
+	const auto bench_mtl = [&]() {
+		if (not selected("parse_mtl")) {
+			return;
+		}
+
+		const auto filename = directory / "materials.mtl";
+		if (generate(filename, [&]() { return synthetic_data::write_mtl(filename, num_materials); })) {
+			num_failed++;
+			return;
+		}
+
+		const auto work = workload{
+			.num_bytes = fs::file_size(filename),
+			.num_elements = num_materials,
+			.element_name = "materials"
+		};
+
+		num_failed += run_benchmark("parse_mtl", work, repetitions, [&]() -> std::error_code {
+			std::unordered_map<std::string, std::shared_ptr<material>> materials;
+			const auto errc = mesh_loader::parse_mtl(filename, materials, true);
+			if (errc != mesh_loader_error::codes::ok) {
+				return mesh_loader_error::make_error_code(errc);
+			}
+			if (materials.size() != num_materials) {
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+			return {};
+		}) ? 1 : 0;
+	};
+
+	bench_obj(false);
+	bench_obj(true);
+	bench_mtl();
+
+	//----------------------[ Draw Submission ]----------------------//
+
+	// The renderers submit to the null backend, so only their own CPU cost is measured.
+	const auto bench_draws = [&]() {
+		gl_api::use(null_gl_backend::api);
+
+		const auto color = std::make_shared<renderable_attributes::color>(glm::vec4{ 0.8f, 0.8f, 0.8f, 1.0f });
+		const auto point_size = std::make_shared<renderable_attributes::point_size>(2.0f);
+
+		// Same attributes the viewer gives its instances.
+		std::vector<mesh_instance> meshes(num_instances);
+		std::vector<point_cloud_instance> point_clouds(num_instances);
+		for (ztu::u32 i = 0; i < num_instances; i++) {
+			const auto transform = glm::translate(
+				glm::identity<glm::mat4>(),
+				glm::vec3{ i % 100, i / 100 % 100, i / 10'000 }
+			);
+
+			auto& mesh = meshes[i];
+			mesh.vba = i + 1;
+			mesh.num_indices = 36;
+			mesh.transform = transform;
+			mesh.attributes.emplace_back(color);
+			mesh.attributes.emplace_back(point_size);
+
+			auto& point_cloud = point_clouds[i];
+			point_cloud.vba = i + 1;
+			point_cloud.num_points = 1024;
+			point_cloud.transform = transform;
+			point_cloud.attributes.emplace_back(point_size);
+			point_cloud.attributes.emplace_back(color);
+		}
+
+		const auto proj_matrix = glm::perspective(std::numbers::pi_v<float> / 2.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+		const auto view_matrix = glm::lookAt(glm::vec3{ -10, 10, -10 }, glm::vec3{ 50, 0, 50 }, glm::vec3{ 0, 1, 0 });
+
+		const auto bench_renderer = [&](const std::string& name, auto& renderer, auto& instances) {
+			if (not selected(name)) {
+				return;
+			}
+
+			const auto work = workload{ .num_bytes = 0, .num_elements = num_instances, .element_name = "draws" };
+
+			auto median = 0.0;
+			if (run_benchmark(name, work, repetitions, [&]() -> std::error_code {
+				null_gl_backend::reset();
+				renderer.render(instances, proj_matrix, view_matrix);
+				return {};
+			}, &median)) {
+				num_failed++;
+				return;
+			}
+
+			const auto num_draws = std::max(null_gl_backend::num_draw_calls(), ztu::u64{ 1 });
+			info<"%: % ns per draw, % GL calls per draw">(
+				name,
+				median * 1e9 / double(num_draws),
+				double(null_gl_backend::num_calls()) / double(num_draws)
+			);
+		};
+
+		// Programs are never linked, the null backend hands out the uniform locations.
+		shaders::meshes mesh_shader;
+		shaders::mesh_lines line_shader;
+		shaders::mesh_points mesh_point_shader;
+		shaders::points point_shader;
+		mesh_shader.init(1);
+		line_shader.init(2);
+		mesh_point_shader.init(3);
+		point_shader.init(4);
+
+		auto mesh_pass = mesh_renderer(&mesh_shader);
+		auto line_pass = mesh_line_renderer(&line_shader);
+		auto mesh_point_pass = mesh_point_renderer(&mesh_point_shader);
+		auto point_pass = point_cloud_renderer(&point_shader);
+
+		bench_renderer("mesh_renderer::render", mesh_pass, meshes);
+		bench_renderer("mesh_line_renderer::render", line_pass, meshes);
+		bench_renderer("mesh_point_renderer::render", mesh_point_pass, meshes);
+		bench_renderer("point_cloud_renderer::render", point_pass, point_clouds);
+
+		// Drawing within a budget relies on the permutation buffer owned by the renderer, the recording backend
+		// checks that it is created once, used as the index buffer of every chunk and deleted with the renderer.
+		const auto check_budget_calls = [&]() {
+			const auto name = std::string("point_cloud_renderer::render_budget");
+			if (not selected(name)) {
+				return;
+			}
+
+			gl_api::use(recording_gl_backend::api);
+			recording_gl_backend::clear();
+			{
+				auto renderer = point_cloud_renderer(&point_shader);
+				auto point_cloud = point_cloud_instance{
+					.vba = 1,
+					.num_points = 2 * point_cloud_chunk::max_points,
+					.transform = glm::identity<glm::mat4>()
+				};
+				renderer.render_budget({ &point_cloud, 1 }, proj_matrix, view_matrix, point_cloud_chunk::max_points);
+			}
+			gl_api::use(null_gl_backend::api);
+
+			std::vector<recording_gl_backend::call> calls;
+			std::ranges::copy_if(
+				recording_gl_backend::calls(), std::back_inserter(calls), [](const auto& call) {
+					return std::string_view(call.function).find("Buffer") != std::string_view::npos or
+						std::string_view(call.function).starts_with("glDraw");
+				}
+			);
+
+			const auto buffer = calls.empty() or calls.front().arguments.size() != 2 ? 0 : calls.front().arguments[1];
+			const auto first_share = point_cloud_chunk::max_points / 2;
+
+			struct expected_call {
+				std::string_view function;
+				// Only these leading arguments are compared, which leaves out the address of the uploaded data.
+				std::vector<ztu::i64> arguments;
+			};
+			const auto expected_calls = std::array{
+				expected_call{ "glGenBuffers", { 1, buffer } },
+				expected_call{ "glBindBuffer", { GL_COPY_WRITE_BUFFER, buffer } },
+				expected_call{ "glBufferData", { GL_COPY_WRITE_BUFFER, point_cloud_chunk::max_points * 2 } },
+				expected_call{ "glBindBuffer", { GL_COPY_WRITE_BUFFER, 0 } },
+				expected_call{ "glBindBuffer", { GL_ELEMENT_ARRAY_BUFFER, buffer } },
+				expected_call{ "glDrawElementsBaseVertex", { GL_POINTS, first_share, GL_UNSIGNED_SHORT, 0, 0 } },
+				expected_call{ "glDrawElementsBaseVertex", {
+					GL_POINTS, point_cloud_chunk::max_points - first_share, GL_UNSIGNED_SHORT, 0, point_cloud_chunk::max_points
+				} },
+				expected_call{ "glDeleteBuffers", { 1, buffer } }
+			};
+
+			const auto describe = [](const std::string_view function, const std::span<const ztu::i64> arguments) {
+				auto text = std::string(function) + "(";
+				for (ztu::usize i = 0; i != arguments.size(); ++i) {
+					text += (i == 0 ? "" : ", ") + std::to_string(arguments[i]);
+				}
+				return text + ")";
+			};
+
+			for (ztu::usize i = 0; i != std::max(calls.size(), expected_calls.size()); ++i) {
+				if (i == calls.size() or i == expected_calls.size()) {
+					error<"%: recorded % buffer and draw calls instead of %">(name, calls.size(), expected_calls.size());
+					num_failed++;
+					return;
+				}
+				const auto& call = calls[i];
+				const auto& expected = expected_calls[i];
+				if (
+					call.function != expected.function or
+					call.arguments.size() < expected.arguments.size() or
+					not std::equal(expected.arguments.begin(), expected.arguments.end(), call.arguments.begin())
+				) {
+					error<"%: call % is %, expected %">(
+						name, i, describe(call.function, call.arguments), describe(expected.function, expected.arguments)
+					);
+					num_failed++;
+					return;
+				}
+			}
+
+			info<"%: recorded buffer and draw calls match">(name);
+		};
+
+		check_budget_calls();
+	};
+
+	bench_draws();
+	// After the shaders are gone, they delete their programs through the current backend.
+	gl_api::use(gl_api::driver);
+
+	//----------------------[ Cleanup ]----------------------//
+
+	for (const auto& filename : generated_files) {
+		std::error_code e;
+		fs::remove(filename, e);
+	}
+
+	return num_failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,277 @@
+#include <map>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include <util/arx.hpp>
+#include <util/logger.hpp>
+#include <util/job_system.hpp>
+#include <geometry/mesh_io.hpp>
+#include <geometry/point_cloud_io.hpp>
+
+
+// Has to match the mesh type the viewer loads '.cobj' files into.
+using cobj_mesh_data = mesh_data<vertex_components::tex_coord, vertex_components::normal>;
+
+using converter_arx = ztu::arx<
+	ztu::arx_flag<'o', "output", std::string>,
+	ztu::arx_flag<'c', "compress">,
+	ztu::arx_flag<'p', "pedantic">
+>;
+
+struct conversion {
+	std::filesystem::path input;
+	std::filesystem::path output;
+	std::error_code error{};
+	ztu::u64 input_size{ 0 };
+	ztu::u64 output_size{ 0 };
+	ztu::u64 num_elements{ 0 };
+	const char* element_name{ "points" };
+	double seconds{ 0 };
+};
+
+template<vertex_component... Cs>
+std::error_code write_c3d(
+	const std::filesystem::path& filename,
+	std::vector<point_cloud_vertex<Cs...>>& points,
+	const glm::mat4& pose,
+	const c3d::codec codec
+) {
+	const auto chunks = sort_into_chunks(points);
+	return point_cloud_loader::write_v2_c3d_file<Cs...>(filename, points, chunks, pose, codec);
+}
+
+int main(int num_args, char* args[]) {
+
+	//----------------------[ Argument Parsing ]----------------------//
+
+	converter_arx arguments(num_args, args);
+
+	const auto output_directory = arguments.get<"output">();
+	const auto codec = arguments.get<"compress">().value() ? c3d::codec::delta_varint : c3d::codec::none;
+	const auto pedantic_enabled = arguments.get<"pedantic">().value();
+
+	if (arguments.num_positional() == 0) {
+		error<"Usage: % [-o <output directory>] [--compress] [--pedantic] <3dtk directory | .obj | .c3d>...">(args[0]);
+		return -1;
+	}
+
+	namespace fs = std::filesystem;
+
+	//----------------------[ Collect Inputs ]----------------------//
+
+	// 3dtk directories are expanded into their scans, so every scan is converted as a job of its own.
+	std::vector<conversion> conversions;
+
+	const auto add_conversion = [&](const fs::path& input, const char* extension) {
+		auto output = output_directory ? fs::path(*output_directory) / input.filename() : input;
+		output.replace_extension(extension);
+		conversions.push_back({ .input = input, .output = std::move(output) });
+	};
+
+	for (ztu::isize i = 0; i < arguments.num_positional(); i++) {
+		const auto path = fs::path{ arguments.get(i).value() };
+		if (fs::is_directory(path)) {
+			std::vector<fs::path> scans;
+			for (const auto& entry : fs::directory_iterator{ path }) {
+				if (entry.path().extension() == ".3d") {
+					scans.push_back(entry.path());
+				}
+			}
+			std::sort(scans.begin(), scans.end());
+			for (const auto& scan : scans) {
+				add_conversion(scan, ".c3d");
+			}
+		} else if (path.extension() == ".obj") {
+			add_conversion(path, ".cobj");
+		} else if (path.extension() == ".c3d") {
+			add_conversion(path, ".c3d");
+		} else {
+			warn<"Skipping %">(path);
+		}
+	}
+
+	// Scans of different directories share their names, they would be written to the same output at the same time.
+	std::map<fs::path, const fs::path*> inputs_by_output;
+	for (const auto& job : conversions) {
+		const auto [it, inserted] = inputs_by_output.emplace(job.output.lexically_normal(), &job.input);
+		if (not inserted) {
+			error<"Both % and % would be converted to %">(*it->second, job.input, job.output);
+			return -1;
+		}
+	}
+
+	if (output_directory) {
+		std::error_code e;
+		fs::create_directories(*output_directory, e);
+		if (e) {
+			error<"Cannot create output directory %: %">(*output_directory, e.message());
+			return -1;
+		}
+	}
+
+	//----------------------[ Conversion ]----------------------//
+
+	const auto convert = [codec, pedantic_enabled](conversion& job) {
+		const auto& input = job.input;
+		// Written next to the target and renamed once complete, so converting in place never truncates the input.
+		const auto output = fs::path(job.output) += ".tmp";
+		auto& error = job.error;
+		auto& jobs = ztu::job_system::shared();
+
+		// Throwing would abort the whole batch, so a file that cannot be read afterwards only fails its own job.
+		const auto add_input_size = [&](const fs::path& filename) {
+			const auto size = fs::file_size(filename, error);
+			job.input_size += error ? 0 : size;
+			return not error;
+		};
+
+		if (input.extension() == ".3d") {
+			std::vector<point_cloud_loader::basic_vertex> basic_points;
+			std::vector<point_cloud_loader::reflectance_vertex> reflectance_points;
+			auto pose = glm::identity<glm::mat4>();
+
+			if ((error = point_cloud_loader::load_3dtk_scan(
+				input, basic_points, reflectance_points, pose, jobs.num_workers()
+			))) {
+				return;
+			}
+
+			auto pose_filename = input;
+			pose_filename.replace_extension(".pose");
+			if (not add_input_size(input) or not add_input_size(pose_filename)) {
+				return;
+			}
+
+			if (not basic_points.empty()) {
+				job.num_elements = basic_points.size();
+				error = write_c3d<>(output, basic_points, pose, codec);
+			} else {
+				job.num_elements = reflectance_points.size();
+				error = write_c3d<vertex_components::reflectance>(output, reflectance_points, pose, codec);
+			}
+		} else if (input.extension() == ".c3d") {
+			const auto recode = [&]<vertex_component... Cs>() {
+				std::vector<point_cloud_vertex<Cs...>> points;
+				std::vector<point_cloud_chunk> chunks;
+				auto pose = glm::identity<glm::mat4>();
+
+				if ((error = point_cloud_loader::load_c3d_file<Cs...>(input, points, chunks, pose))) {
+					return;
+				}
+
+				if (not add_input_size(input)) {
+					return;
+				}
+				job.num_elements = points.size();
+
+				// Version 1 files are unsorted, already chunked files keep their order.
+				if (chunks.empty()) {
+					chunks = sort_into_chunks(points);
+				}
+				error = point_cloud_loader::write_v2_c3d_file<Cs...>(output, points, chunks, pose, codec);
+			};
+
+			c3d::header header;
+			if ((error = point_cloud_loader::read_c3d_header(input, header))) {
+				return;
+			}
+			if (point_cloud_loader::has_c3d_schema<>(header)) {
+				recode.template operator()<>();
+			} else {
+				recode.template operator()<vertex_components::reflectance>();
+			}
+		} else {
+			std::vector<cobj_mesh_data> meshes;
+			std::vector<fs::path> material_libraries;
+
+			if ((error = mesh_loader::parse_obj(input, meshes, material_libraries, pedantic_enabled))) {
+				return;
+			}
+
+			if (not add_input_size(input)) {
+				return;
+			}
+			job.element_name = "vertices";
+			for (const auto& mesh : meshes) {
+				job.num_elements += mesh.vertices.size();
+			}
+
+			error = mesh_loader::write_cobj_file(output, meshes, material_libraries);
+		}
+
+		if (not error) {
+			fs::rename(output, job.output, error);
+		}
+		if (error) {
+			std::error_code e;
+			fs::remove(output, e);
+		} else {
+			job.output_size = fs::file_size(job.output, error);
+		}
+	};
+
+	auto& jobs = ztu::job_system::shared();
+	const auto begin = std::chrono::steady_clock::now();
+
+	std::vector<std::future<void>> pending_conversions;
+	pending_conversions.reserve(conversions.size());
+
+	for (auto& job : conversions) {
+		pending_conversions.push_back(jobs.submit(
+			[&convert, &job]() {
+				const auto job_begin = std::chrono::steady_clock::now();
+				convert(job);
+				job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job_begin).count();
+			}
+		));
+	}
+
+	//----------------------[ Report ]----------------------//
+
+	static constexpr auto mebibyte = double(1 << 20);
+
+	auto num_failed = 0;
+	ztu::u64 total_input_size = 0, total_output_size = 0;
+
+	for (ztu::usize i = 0; i < conversions.size(); i++) {
+		jobs.wait(pending_conversions[i]);
+
+		const auto& job = conversions[i];
+		if (job.error) {
+			error<"Cannot convert %: %">(job.input.c_str(), job.error.message());
+			num_failed++;
+			continue;
+		}
+
+		total_input_size += job.input_size;
+		total_output_size += job.output_size;
+
+		info<"% -> %: % %, % MiB -> % MiB in %s (% MiB/s)">(
+			job.input.c_str(),
+			job.output.c_str(),
+			job.num_elements,
+			job.element_name,
+			double(job.input_size) / mebibyte,
+			double(job.output_size) / mebibyte,
+			job.seconds,
+			double(job.input_size) / mebibyte / std::max(job.seconds, 1e-9)
+		);
+	}
+
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	info<"Converted % of % files, % MiB -> % MiB in %s (% MiB/s)">(
+		conversions.size() - num_failed,
+		conversions.size(),
+		double(total_input_size) / mebibyte,
+		double(total_output_size) / mebibyte,
+		seconds,
+		double(total_input_size) / mebibyte / std::max(seconds, 1e-9)
+	);
+
+	return num_failed == 0 ? 0 : -1;
+}
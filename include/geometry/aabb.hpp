@@ -1,7 +1,8 @@
 #pragma once
 
+#include <cfloat>
 #include <glm/vec3.hpp>
-#include <span>
+#include <glm/mat4x4.hpp>
 
 
 struct aabb {
@@ -17,27 +18,19 @@ struct aabb {
 		max = glm::max(max, other.max);
 	}
 
-	static inline std::pair<glm::vec3, glm::vec3> calc_min_max(std::span<const glm::vec3> vertices) {
-		auto min = glm::vec3{ FLT_MAX, FLT_MAX, FLT_MAX };
-		auto max = glm::vec3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
-		for (const auto& vertex : vertices) {
-			min = glm::min(min, vertex);
-			max = glm::max(max, vertex);
-		}
-		return { min, max };
-	}
-
+	/**
+	 * Bounds of the transformed box, taken per axis from the matrix columns
+	 * instead of transforming all eight corners.
+	 */
 	void transform(const glm::mat4x4& matrix) {
-		const auto vertices = {
-			glm::vec3{ matrix * glm::vec4{ min.x, min.y, min.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ min.x, min.y, max.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ min.x, max.y, min.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ min.x, max.y, max.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ max.x, min.y, min.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ max.x, min.y, max.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ max.x, max.y, min.z, 1 } },
-			glm::vec3{ matrix * glm::vec4{ max.x, max.y, max.z, 1 } }
-		};
-		std::tie(min, max) = calc_min_max(vertices);
+		auto new_min = glm::vec3{ matrix[3] }, new_max = new_min;
+		for (int i = 0; i < 3; i++) {
+			const auto a = glm::vec3{ matrix[i] } * min[i];
+			const auto b = glm::vec3{ matrix[i] } * max[i];
+			new_min += glm::min(a, b);
+			new_max += glm::max(a, b);
+		}
+		min = new_min;
+		max = new_max;
 	}
 };
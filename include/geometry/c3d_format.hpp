@@ -0,0 +1,124 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <system_error>
+#include "util/uix.hpp"
+
+
+/**
+ * Layout of version 2 '.c3d' files:
+ *
+ *   header | chunk table (header.num_chunks entries) | chunk payloads
+ *
+ * All values are stored little endian. Points are written in the order of the chunks,
+ * every chunk payload holds its points as packed floats in the order of the component schema,
+ * optionally compressed with the codec given in the header.
+ */
+namespace c3d {
+
+static_assert(std::endian::native == std::endian::little, "'.c3d' files are read and written in native byte order");
+
+static constexpr auto magic_bytes = std::array{ '3', 'd' };
+static constexpr ztu::u8 version_1 = 1;
+static constexpr ztu::u8 version_2 = 2;
+static constexpr auto max_components = 7;
+
+enum class codec : ztu::u8 {
+	none = 0,
+	// Per float lane delta of the bit patterns, zigzag and LEB128 varint encoded.
+	delta_varint = 1
+};
+
+struct header {
+	std::array<char, 2> magic{ magic_bytes };
+	ztu::u8 version{ version_2 };
+	c3d::codec codec{ codec::none };
+	ztu::u8 num_components{ 0 };
+	// 'uuid' of every vertex component, starting with the position.
+	std::array<ztu::u8, max_components> component_uuids{};
+	ztu::u32 num_chunks{ 0 };
+	ztu::u64 num_points{ 0 };
+	std::array<float, 3> bounds_min{};
+	std::array<float, 3> bounds_max{};
+	// Column major scan pose
+	std::array<float, 16> pose{};
+	ztu::u64 chunk_table_offset{ 0 };
+};
+
+static_assert(sizeof(header) == 120 and std::is_trivially_copyable_v<header>);
+
+struct chunk_entry {
+	ztu::u64 payload_offset;
+	ztu::u64 payload_size;
+	ztu::u32 num_points;
+	std::array<float, 3> bounds_min;
+	std::array<float, 3> bounds_max;
+	ztu::u32 reserved;
+};
+
+static_assert(sizeof(chunk_entry) == 48 and std::is_trivially_copyable_v<chunk_entry>);
+
+
+inline void encode_delta_varint(
+	std::span<const float> floats,
+	const ztu::usize stride,
+	std::vector<ztu::u8>& dst
+) {
+	const auto num_points = floats.size() / stride;
+	for (ztu::usize lane = 0; lane < stride; lane++) {
+		auto prev = ztu::u32{ 0 };
+		for (ztu::usize i = 0; i < num_points; i++) {
+			const auto bits = std::bit_cast<ztu::u32>(floats[i * stride + lane]);
+			const auto delta = static_cast<ztu::i32>(bits - prev);
+			auto zigzag = static_cast<ztu::u32>(delta) << 1 ^ static_cast<ztu::u32>(delta >> 31);
+			prev = bits;
+			while (zigzag >= 0x80) {
+				dst.push_back(static_cast<ztu::u8>(zigzag | 0x80));
+				zigzag >>= 7;
+			}
+			dst.push_back(static_cast<ztu::u8>(zigzag));
+		}
+	}
+}
+
+[[nodiscard]] inline std::error_code decode_delta_varint(
+	std::span<const ztu::u8> bytes,
+	const ztu::usize stride,
+	std::span<float> floats
+) {
+	const auto num_points = floats.size() / stride;
+	auto it = bytes.begin();
+	for (ztu::usize lane = 0; lane < stride; lane++) {
+		auto prev = ztu::u32{ 0 };
+		for (ztu::usize i = 0; i < num_points; i++) {
+			auto zigzag = ztu::u32{ 0 };
+			for (int shift = 0;; shift += 7) {
+				if (it == bytes.end() or shift > 28) [[unlikely]] {
+					return std::make_error_code(std::errc::illegal_byte_sequence);
+				}
+				const auto byte = *it++;
+				// The fifth byte only has room for the top four bits.
+				if (shift == 28 and (byte & 0xf0)) [[unlikely]] {
+					return std::make_error_code(std::errc::illegal_byte_sequence);
+				}
+				zigzag |= static_cast<ztu::u32>(byte & 0x7f) << shift;
+				if (not (byte & 0x80)) {
+					break;
+				}
+			}
+			const auto delta = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+			prev += delta;
+			floats[i * stride + lane] = std::bit_cast<float>(prev);
+		}
+	}
+	if (it != bytes.end()) [[unlikely]] {
+		return std::make_error_code(std::errc::illegal_byte_sequence);
+	}
+	return {};
+}
+
+} // namespace c3d
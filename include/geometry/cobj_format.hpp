@@ -0,0 +1,49 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <type_traits>
+#include "util/uix.hpp"
+
+
+/**
+ * Layout of '.cobj' files, a binary cache of parsed obj geometry:
+ *
+ *   header | material library paths (header.num_material_libraries) | meshes (header.num_meshes)
+ *
+ * Every material library path is stored as a 'u32' byte count followed by the path,
+ * relative to the directory of the '.cobj' file if possible.
+ * Every mesh is stored as a 'mesh_header' followed by the material name, the vertices as packed floats
+ * in the order of the component schema and finally the 'u32' indices.
+ * All values are stored little endian.
+ */
+namespace cobj {
+
+static_assert(std::endian::native == std::endian::little, "'.cobj' files are read and written in native byte order");
+
+static constexpr auto magic_bytes = std::array{ 'o', 'b' };
+static constexpr ztu::u8 version_1 = 1;
+static constexpr auto max_components = 7;
+
+struct header {
+	std::array<char, 2> magic{ magic_bytes };
+	ztu::u8 version{ version_1 };
+	ztu::u8 num_components{ 0 };
+	// 'uuid' of every vertex component, starting with the position.
+	std::array<ztu::u8, max_components> component_uuids{};
+	ztu::u8 reserved{ 0 };
+	ztu::u32 num_meshes{ 0 };
+	ztu::u32 num_material_libraries{ 0 };
+};
+
+static_assert(sizeof(header) == 20 and std::is_trivially_copyable_v<header>);
+
+struct mesh_header {
+	ztu::u32 material_name_size;
+	ztu::u32 num_vertices;
+	ztu::u32 num_indices;
+};
+
+static_assert(sizeof(mesh_header) == 12 and std::is_trivially_copyable_v<mesh_header>);
+
+} // namespace cobj
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include "geometry/aabb.hpp"
+
+
+/**
+ * View frustum given by the six clipping planes of a projection matrix.
+ * When constructed from a full model-view-projection matrix the planes are in model space,
+ * so boxes can be tested without transforming them first.
+ */
+struct frustum {
+	std::array<glm::vec4, 6> planes;
+
+	explicit frustum(const glm::mat4x4& matrix) {
+		const auto row = [&matrix](const int i) {
+			return glm::vec4{ matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i] };
+		};
+		const auto w = row(3);
+		for (int i = 0; i < 3; i++) {
+			planes[2 * i + 0] = w + row(i);
+			planes[2 * i + 1] = w - row(i);
+		}
+	}
+
+	[[nodiscard]] bool intersects(const aabb& box) const {
+		for (const auto& plane : planes) {
+			// Only the box corner furthest along the plane normal needs to be tested.
+			const auto corner = glm::vec3{
+				plane.x < 0 ? box.min.x : box.max.x,
+				plane.y < 0 ? box.min.y : box.max.y,
+				plane.z < 0 ? box.min.z : box.max.z
+			};
+			if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
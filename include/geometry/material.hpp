@@ -3,6 +3,7 @@
 #include <memory>
 #include <graphics/texture.hpp>
 #include <util/rgba_color.hpp>
+#include <util/memory_stats.hpp>
 
 #include <graphics/renderable_attributes/texture_attribute.hpp>
 #include <graphics/renderable_attributes/color_attribute.hpp>
@@ -17,20 +18,27 @@ struct material {
 
 	material(material&& other) noexcept :
 		m_color(std::move(other.m_color)),
-		m_tex(std::move(other.m_tex)) {
+		m_tex(std::move(other.m_tex)),
+		m_tex_memory(std::move(other.m_tex_memory)) {
 	}
 
-	void init_attributes() {
+	void set_texture(texture&& tex) {
+		m_tex_memory.set(static_cast<ztu::usize>(tex.width() * tex.height()) * sizeof(texture_color));
+		m_tex = std::make_unique<texture>(std::move(tex));
+	}
+
+	void init_attributes(upload_scheduler& uploads) {
 		if (m_color and not m_color_attribute) {
 			m_color_attribute = std::make_shared<color_attribute>(*m_color);
 		}
 		if (m_tex and not m_texture_attribute) {
-			m_texture_attribute = std::make_shared<texture_attribute>(*m_tex);
+			m_texture_attribute = std::make_shared<texture_attribute>(*m_tex, uploads);
 		}
 	}
 
 	std::unique_ptr<rgba_color> m_color{};
 	std::unique_ptr<texture> m_tex{};
+	ztu::memory_stats::counter m_tex_memory{ ztu::memory_stats::category::cpu_textures };
 
 	std::shared_ptr<color_attribute> m_color_attribute{};
 	std::shared_ptr<texture_attribute> m_texture_attribute{};
@@ -2,11 +2,16 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
+#include <system_error>
 #include <glm/mat4x4.hpp>
 #include "util/uix.hpp"
+#include "util/memory_stats.hpp"
 #include "geometry/vertex_component.hpp"
 #include "graphics/renderables/mesh_instance.hpp"
+#include "graphics/upload_scheduler.hpp"
 #include "geometry/aabb.hpp"
+#include "geometry/position_bounds.hpp"
 #include "geometry/material.hpp"
 
 
@@ -16,6 +21,11 @@ public:
 	using vertex = std::tuple<vertex_components::position, Cs...>;
 	using vertex_t = std::tuple<vertex_components::position::type, typename Cs::type...>;
 
+	/**
+	 * Reproduces the vertices and indices exactly as they are stored in the mesh.
+	 */
+	using geometry_source = std::function<std::error_code(std::vector<vertex_t>& vertices, std::vector<ztu::u32>& indices)>;
+
 public:
 	mesh(
 		std::vector<typename mesh<Cs...>::vertex_t>&& vertexBuffer,
@@ -37,25 +47,62 @@ public:
 
 	~mesh();
 
-	void init_vao();
+	/**
+	 * Creates the vertex array and its buffers, the vertex data is uploaded by the scheduler.
+	 */
+	void init_vao(upload_scheduler& uploads);
 
+	/**
+	 * Empty after 'release_cpu_data', until 'fetch_cpu_data' is called.
+	 */
 	[[nodiscard]] const std::vector<vertex_t>& vertex_buffer() const;
 
-	[[nodiscard]] std::vector<vertex_t>& vertex_buffer();
-
 	[[nodiscard]] const std::vector<ztu::u32>& index_buffer() const;
 
-	[[nodiscard]] std::vector<ztu::u32>& index_buffer();
+	[[nodiscard]] ztu::usize num_vertices() const;
+
+	[[nodiscard]] ztu::usize num_indices() const;
+
+	void set_source(geometry_source source);
+
+	/**
+	 * Frees the vertices and indices on the heap if they can be fetched again from the source.
+	 * Bounds and sizes stay available. The buffers must not be in use by a pending upload.
+	 */
+	bool release_cpu_data();
+
+	[[nodiscard]] std::error_code fetch_cpu_data();
+
+	[[nodiscard]] bool has_cpu_data() const;
+
+	/**
+	 * Bytes currently held by the vertices and indices on the heap and by the GL buffers.
+	 */
+	[[nodiscard]] ztu::usize cpu_bytes() const;
+
+	[[nodiscard]] ztu::usize gpu_bytes() const;
 
 	[[nodiscard]] std::optional<mesh_instance> create_instance(
 		const glm::mat4x4& model_matrix = glm::identity<glm::mat4x4>()
 	) const;
 
-	[[nodiscard]] aabb calc_bounding_box() const;
+	/**
+	 * Bounds of all vertices, calculated once on construction.
+	 */
+	[[nodiscard]] const aabb& bounding_box() const;
+
+protected:
+	void update_cpu_memory();
 
 protected:
 	std::vector<vertex_t> m_vertices;
 	std::vector<ztu::u32> m_indices;
+	ztu::usize m_num_vertices;
+	ztu::usize m_num_indices;
+	geometry_source m_source;
+	aabb m_bounds;
+	ztu::memory_stats::counter m_cpu_memory{ ztu::memory_stats::category::cpu_geometry };
+	ztu::memory_stats::counter m_gpu_memory{ ztu::memory_stats::category::gpu_buffers };
 
 	ztu::u32 m_vertex_buffer_id{ 0 };
 	ztu::u32 m_index_buffer_id{ 0 };
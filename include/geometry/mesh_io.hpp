@@ -0,0 +1,85 @@
+#pragma once
+
+#include <span>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include "util/uix.hpp"
+#include "geometry/cobj_format.hpp"
+#include "geometry/vertex_component.hpp"
+
+
+// Same as 'mesh<Cs...>::vertex_t', but usable without OpenGL (for example in the converter).
+template<vertex_component... Cs>
+using mesh_vertex = std::tuple<vertex_components::position::type, typename Cs::type...>;
+
+/**
+ * Geometry of a single mesh, its material is only referenced by name.
+ */
+template<vertex_component... Cs>
+struct mesh_data {
+	std::vector<mesh_vertex<Cs...>> vertices;
+	std::vector<ztu::u32> indices;
+	std::string material_name;
+};
+
+namespace mesh_loader_error {
+
+enum class codes {
+	ok = 0,
+	obj_cannot_open_file,
+	obj_malformed_vertex,
+	obj_malformed_texture_coordinate,
+	obj_malformed_normal,
+	obj_malformed_face,
+	obj_face_index_out_of_range,
+	obj_unknown_line_begin,
+	mtl_cannot_open_file,
+	mtl_cannot_open_texture,
+	mtl_malformed_color,
+	mtl_malformed_color_alpha,
+	mlt_unknown_line_begin
+};
+
+} // namespace mesh_loader_error
+
+namespace mesh_loader {
+
+/**
+ * Parses the geometry of an obj file into one 'mesh_data' per object without loading any materials.
+ * The paths of all referenced material libraries are appended to 'material_libraries'.
+ */
+template<vertex_component... Cs>
+std::error_code parse_obj(
+	const std::filesystem::path& filename,
+	std::vector<mesh_data<Cs...>>& meshes,
+	std::vector<std::filesystem::path>& material_libraries,
+	bool pedantic = false
+);
+
+/**
+ * Writes the meshes as a '.cobj' file (see 'cobj_format.hpp').
+ */
+template<vertex_component... Cs>
+std::error_code write_cobj_file(
+	const std::filesystem::path& filename,
+	const std::vector<mesh_data<Cs...>>& meshes,
+	const std::vector<std::filesystem::path>& material_libraries
+);
+
+template<vertex_component... Cs>
+std::error_code load_cobj_file(
+	const std::filesystem::path& filename,
+	std::vector<mesh_data<Cs...>>& meshes,
+	std::vector<std::filesystem::path>& material_libraries
+);
+
+} // namespace mesh_loader
+
+#define INCLUDE_MESH_IO_IMPLEMENTATION
+#include "geometry/mesh_io.ipp"
+
+
+#undef INCLUDE_MESH_IO_IMPLEMENTATION
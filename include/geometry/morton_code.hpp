@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cfloat>
+#include <algorithm>
+#include <glm/vec3.hpp>
+#include "util/uix.hpp"
+#include "geometry/aabb.hpp"
+
+
+namespace morton_code {
+
+static constexpr auto bits_per_axis = 21;
+static constexpr auto num_bits = 3 * bits_per_axis;
+
+/**
+ * Spreads the lowest 21 bits of the given value so that two zero bits follow every bit.
+ */
+[[nodiscard]] constexpr ztu::u64 spread_bits(ztu::u64 value) {
+	value &= 0x1fffff;
+	value = (value | value << 32) & 0x1f00000000ffff;
+	value = (value | value << 16) & 0x1f0000ff0000ff;
+	value = (value | value << 8) & 0x100f00f00f00f00f;
+	value = (value | value << 4) & 0x10c30c30c30c30c3;
+	value = (value | value << 2) & 0x1249249249249249;
+	return value;
+}
+
+[[nodiscard]] constexpr ztu::u64 encode(ztu::u32 x, ztu::u32 y, ztu::u32 z) {
+	return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+}
+
+/**
+ * Quantizes the position to a 21 bit grid spanning the given bounds and interleaves the coordinates.
+ */
+[[nodiscard]] inline ztu::u64 encode(const glm::vec3& position, const aabb& bounds) {
+	static constexpr auto max_cell = static_cast<float>((1 << bits_per_axis) - 1);
+	const auto extent = glm::max(bounds.size(), glm::vec3{ FLT_MIN, FLT_MIN, FLT_MIN });
+	const auto cell = (position - bounds.min) / extent * max_cell;
+	const auto quantize = [](const float value) {
+		return static_cast<ztu::u32>(std::clamp(value, 0.0f, max_cell));
+	};
+	return encode(quantize(cell.x), quantize(cell.y), quantize(cell.z));
+}
+
+} // namespace morton_code
@@ -2,11 +2,17 @@
 
 #include <memory>
 #include <vector>
+#include <functional>
+#include <system_error>
 #include <glm/mat4x4.hpp>
 #include "util/uix.hpp"
+#include "util/memory_stats.hpp"
+#include "util/mapped_file.hpp"
 #include "geometry/aabb.hpp"
+#include "geometry/point_cloud_chunk.hpp"
 #include "geometry/vertex_component.hpp"
 #include "graphics/renderables/point_cloud_instance.hpp"
+#include "graphics/upload_scheduler.hpp"
 
 
 template<vertex_component... Cs>
@@ -15,13 +21,42 @@ public:
 	using vertex = std::tuple<vertex_components::position, Cs...>;
 	using vertex_t = std::tuple<vertex_components::position::type, typename Cs::type...>;
 
+	/**
+	 * Reproduces the points exactly as they are stored in the point cloud, including their order.
+	 */
+	using point_source = std::function<std::error_code(std::vector<vertex_t>& points)>;
+
 public:
 	explicit point_cloud(
-		std::vector<typename point_cloud<Cs...>::vertex_t>&& points
+		std::vector<typename point_cloud<Cs...>::vertex_t>&& points,
+		const glm::mat4x4& pose = glm::identity<glm::mat4x4>()
 	);
 
 	explicit point_cloud(
-		const std::vector<typename point_cloud<Cs...>::vertex_t>& points
+		const std::vector<typename point_cloud<Cs...>::vertex_t>& points,
+		const glm::mat4x4& pose = glm::identity<glm::mat4x4>()
+	);
+
+	/**
+	 * Takes points that are already sorted into the given chunks (for example read from a '.c3d' file).
+	 * If no chunks are given the points are sorted as usual.
+	 */
+	point_cloud(
+		std::vector<typename point_cloud<Cs...>::vertex_t>&& points,
+		std::vector<point_cloud_chunk>&& chunks,
+		const glm::mat4x4& pose
+	);
+
+	/**
+	 * Vertices stay in the mapped file and are streamed to the GPU from there, without a copy on the heap.
+	 * They have to be stored as packed floats in component order, starting at 'offset'.
+	 */
+	point_cloud(
+		std::shared_ptr<const ztu::mapped_file> file,
+		ztu::usize offset,
+		ztu::usize num_points,
+		std::vector<point_cloud_chunk>&& chunks,
+		const glm::mat4x4& pose
 	);
 
 	point_cloud(const point_cloud<Cs...>& other);
@@ -34,19 +69,82 @@ public:
 
 	~point_cloud();
 
-	void init_vao();
+	/**
+	 * Creates the vertex array and its buffer, the points are uploaded by the scheduler.
+	 * Points of mapped files are released from memory once they are uploaded.
+	 */
+	void init_vao(upload_scheduler& uploads);
 
+	/**
+	 * Empty for point clouds backed by a mapped file and after 'release_cpu_data', until 'fetch_cpu_data' is called.
+	 */
 	[[nodiscard]] const std::vector<vertex_t>& points() const;
 
+	void set_source(point_source source);
+
+	/**
+	 * Frees the points on the heap if they can be fetched again, from the source or the mapped file.
+	 * Bounds, chunks and the number of points stay available. The points must not be in use by a pending upload.
+	 */
+	bool release_cpu_data();
+
+	/**
+	 * Makes the points available again after 'release_cpu_data', for mapped files also the first time.
+	 */
+	[[nodiscard]] std::error_code fetch_cpu_data();
+
+	[[nodiscard]] bool has_cpu_data() const;
+
+	/**
+	 * Bytes currently held by the points on the heap and by the GL buffer.
+	 * Pages of mapped files are not counted, they are released as the upload progresses.
+	 */
+	[[nodiscard]] ztu::usize cpu_bytes() const;
+
+	[[nodiscard]] ztu::usize gpu_bytes() const;
+
+	[[nodiscard]] ztu::usize num_points() const;
+
+	[[nodiscard]] const std::vector<point_cloud_chunk>& chunks() const;
+
+	/**
+	 * Transformation from the point cloud's local frame (for example the scanner frame) into the world.
+	 * It is applied on the GPU as part of the model matrix of every instance.
+	 */
+	[[nodiscard]] const glm::mat4x4& pose() const;
+
+	void set_pose(const glm::mat4x4& pose);
+
 	[[nodiscard]] std::optional<point_cloud_instance> create_instance(
 		const glm::mat4x4& model_matrix = glm::identity<glm::mat4x4>()
 	) const;
 
-	[[nodiscard]] aabb calc_bounding_box() const;
+	/**
+	 * Bounds in the world, i.e. the local bounds transformed by the pose.
+	 */
+	[[nodiscard]] aabb bounding_box() const;
+
+	/**
+	 * Bounds in the local frame, calculated once on construction.
+	 */
+	[[nodiscard]] const aabb& local_bounding_box() const;
+
+protected:
+	void update_local_bounding_box();
 
+	void update_cpu_memory();
 
 protected:
 	std::vector<vertex_t> m_points;
+	point_source m_source;
+	std::shared_ptr<const ztu::mapped_file> m_mapped_file;
+	ztu::usize m_mapped_offset{ 0 };
+	ztu::usize m_num_points{ 0 };
+	std::vector<point_cloud_chunk> m_chunks;
+	aabb m_local_bounds;
+	glm::mat4x4 m_pose;
+	ztu::memory_stats::counter m_cpu_memory{ ztu::memory_stats::category::cpu_geometry };
+	ztu::memory_stats::counter m_gpu_memory{ ztu::memory_stats::category::gpu_buffers };
 
 	GLuint m_vertex_buffer_id{ 0 };
 	GLuint m_vao_id{ 0 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include "util/uix.hpp"
+#include "util/radix_sort.hpp"
+#include "util/memory_stats.hpp"
+#include "util/scratch_arena.hpp"
+#include "util/trace.hpp"
+#include "geometry/aabb.hpp"
+#include "geometry/position_bounds.hpp"
+#include "geometry/morton_code.hpp"
+
+
+/**
+ * Contiguous range of points inside a point cloud's vertex buffer.
+ */
+struct point_cloud_chunk {
+	// Chunks are at most 'u16_max' points so every chunk can be drawn with a single call.
+	static constexpr ztu::isize max_points = ztu::u16_max;
+
+	ztu::isize offset;
+	ztu::isize num_points;
+	aabb bounds;
+};
+
+/**
+ * Sorts points along a z-order curve, so spatially close points also end up close in memory.
+ * This keeps vertex fetches coherent and turns every contiguous range of points into a compact
+ * region of space that can be culled as a whole. The position is expected to be the first component.
+ */
+template<typename Vertex>
+[[nodiscard]] inline std::vector<point_cloud_chunk> sort_into_chunks(std::vector<Vertex>& points) {
+	const auto zone = ztu::trace::zone("sort_into_chunks");
+	const auto sort_phase = ztu::memory_stats::phase_scope(ztu::memory_stats::phase::sort);
+
+	if (points.size() > 1 and points.size() <= ztu::u32_max) {
+		const auto bounds = position_bounds::calc_parallel(points.data(), points.size());
+
+		const auto scratch = ztu::scratch_arena::scope();
+		std::pmr::vector<std::pair<ztu::u64, ztu::u32>> order(scratch.resource());
+		order.reserve(points.size());
+		for (const auto& point : points) {
+			order.emplace_back(morton_code::encode(std::get<0>(point), bounds), order.size());
+		}
+
+		ztu::parallel_radix_sort<morton_code::num_bits>(order);
+
+		std::vector<Vertex> sorted_points;
+		sorted_points.reserve(points.size());
+
+		// The sorted copy replaces the points, until then it is an additional temporary.
+		const auto sorted_points_memory = ztu::memory_stats::counter(
+			ztu::memory_stats::category::loader_temporaries,
+			sorted_points.capacity() * sizeof(Vertex)
+		);
+		for (const auto& [code, index] : order) {
+			sorted_points.push_back(points[index]);
+		}
+		points = std::move(sorted_points);
+	}
+
+	std::vector<point_cloud_chunk> chunks;
+	chunks.reserve((points.size() + point_cloud_chunk::max_points - 1) / point_cloud_chunk::max_points);
+
+	const auto num_points = static_cast<ztu::isize>(points.size());
+	for (ztu::isize offset = 0; offset < num_points; offset += point_cloud_chunk::max_points) {
+		chunks.emplace_back(offset, std::min(point_cloud_chunk::max_points, num_points - offset));
+	}
+
+	ztu::job_system::shared().parallel_for(
+		chunks.size(), [&](const ztu::usize i) {
+			auto& chunk = chunks[i];
+			chunk.bounds = position_bounds::calc(&points[chunk.offset], static_cast<ztu::usize>(chunk.num_points));
+		}
+	);
+
+	return chunks;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <span>
+#include <tuple>
+#include <vector>
+#include <charconv>
+#include <filesystem>
+#include <system_error>
+#include <glm/mat4x4.hpp>
+#include "util/uix.hpp"
+#include "geometry/c3d_format.hpp"
+#include "geometry/point_cloud_chunk.hpp"
+#include "geometry/vertex_component.hpp"
+
+
+// Same as 'point_cloud<Cs...>::vertex_t', but usable without OpenGL (for example in the converter).
+template<vertex_component... Cs>
+using point_cloud_vertex = std::tuple<vertex_components::position::type, typename Cs::type...>;
+
+namespace point_cloud_loader {
+
+using basic_vertex = point_cloud_vertex<>;
+using reflectance_vertex = point_cloud_vertex<vertex_components::reflectance>;
+
+[[nodiscard]] inline std::error_code analyze_3dtk_file(
+	const std::filesystem::path& filename,
+	ztu::u32& num_floats,
+	std::chars_format& format
+);
+
+
+/**
+ * Reads the scan position and euler angles (in degrees) of a '.pose' file into a model matrix.
+ */
+[[nodiscard]] inline std::error_code read_3dtk_pose(
+	const std::filesystem::path& pose_filename,
+	glm::mat4& pose
+);
+
+/**
+ * Detects the format of the given '.3d' file and loads it together with its '.pose' file.
+ * Depending on the number of floats per line the points end up in 'basic_points' or 'reflectance_points'.
+ */
+[[nodiscard]] inline std::error_code load_3dtk_scan(
+	const std::filesystem::path& filename,
+	std::vector<basic_vertex>& basic_points,
+	std::vector<reflectance_vertex>& reflectance_points,
+	glm::mat4& pose,
+	ztu::usize num_threads = 1
+);
+
+/**
+ * Points are kept in the scanner's local frame, the scan's pose is written to 'pose'.
+ * With 'num_threads' > 1 the '.3d' file is memory mapped and parsed in parallel on the shared job system.
+ */
+template<bool Reflectance, bool Hex>
+[[nodiscard]] inline std::error_code load_from_3dtk_file(
+	const std::filesystem::path& base_filename,
+	std::vector<basic_vertex>& basic_points,
+	std::vector<reflectance_vertex>& points,
+	glm::mat4& pose,
+	ztu::usize num_threads = 1
+);
+
+
+[[nodiscard]] inline std::error_code write_v1_c3d_file(
+	const std::filesystem::path& filename,
+	/*const glm::vec3& position,
+	const glm::vec3& direction,*/
+	const std::vector<reflectance_vertex>& points
+);
+
+[[nodiscard]] inline std::error_code load_v1_c3d_file(
+	const std::filesystem::path& filename,
+	std::vector<reflectance_vertex>& points
+);
+
+
+/**
+ * Writes the points of the given chunks as a version 2 '.c3d' file (see 'c3d_format.hpp').
+ * Chunk payloads are encoded in parallel on the shared job system.
+ */
+template<vertex_component... Cs>
+[[nodiscard]] inline std::error_code write_v2_c3d_file(
+	const std::filesystem::path& filename,
+	const std::vector<point_cloud_vertex<Cs...>>& points,
+	std::span<const point_cloud_chunk> chunks,
+	const glm::mat4& pose,
+	c3d::codec codec = c3d::codec::delta_varint
+);
+
+[[nodiscard]] inline std::error_code read_c3d_header(
+	const std::filesystem::path& filename,
+	c3d::header& header
+);
+
+/**
+ * True if the vertex components in the header are exactly 'Cs', so the file loads as 'point_cloud_vertex<Cs...>'.
+ */
+template<vertex_component... Cs>
+[[nodiscard]] inline bool has_c3d_schema(const c3d::header& header);
+
+/**
+ * Memory maps a '.c3d' file and only decodes the chunks whose bounds satisfy 'select'.
+ * The loaded chunks are appended to 'chunks' with offsets into 'points'.
+ * Version 1 files have neither chunks nor a pose, so all points are loaded and 'pose' is set to identity.
+ */
+template<vertex_component... Cs, typename Select>
+[[nodiscard]] inline std::error_code load_c3d_chunks(
+	const std::filesystem::path& filename,
+	const Select& select,
+	std::vector<point_cloud_vertex<Cs...>>& points,
+	std::vector<point_cloud_chunk>& chunks,
+	glm::mat4& pose
+);
+
+template<vertex_component... Cs>
+[[nodiscard]] inline std::error_code load_c3d_file(
+	const std::filesystem::path& filename,
+	std::vector<point_cloud_vertex<Cs...>>& points,
+	std::vector<point_cloud_chunk>& chunks,
+	glm::mat4& pose
+);
+
+} // namespace point_cloud_loader
+
+
+#define INCLUDE_POINT_CLOUD_IO_IMPLEMENTATION
+#include <geometry/point_cloud_io.ipp>
+
+
+#undef INCLUDE_POINT_CLOUD_IO_IMPLEMENTATION
@@ -3,6 +3,7 @@
 #include <vector>
 #include <system_error>
 #include "geometry/point_cloud.hpp"
+#include "geometry/point_cloud_io.hpp"
 #include "geometry/vertex_component.hpp"
 
 
@@ -11,8 +12,8 @@ using reflectance_point_cloud = point_cloud<vertex_components::reflectance>;
 
 namespace point_cloud_loader {
 
-using basic_vertex = basic_point_cloud::vertex_t;
-using reflectance_vertex = reflectance_point_cloud::vertex_t;
+static_assert(std::is_same_v<basic_point_cloud::vertex_t, basic_vertex>);
+static_assert(std::is_same_v<reflectance_point_cloud::vertex_t, reflectance_vertex>);
 
 [[nodiscard]] inline std::error_code load_from_3dtk_directory(
 	const std::filesystem::path& directory,
@@ -20,31 +21,27 @@ using reflectance_vertex = reflectance_point_cloud::vertex_t;
 	std::vector<reflectance_point_cloud>& reflectance_point_cloud
 );
 
-[[nodiscard]] inline std::error_code analyze_3dtk_file(
-	const std::filesystem::path& filename,
-	ztu::u32& num_floats,
-	std::chars_format& format
-);
-
-
-template<bool Reflectance, bool Hex>
-[[nodiscard]] inline std::error_code load_from_3dtk_file(
-	const std::filesystem::path& base_filename,
-	std::vector<basic_vertex>& basic_points,
-	std::vector<reflectance_vertex>& points
-);
-
-
-[[nodiscard]] inline std::error_code write_v1_c3d_file(
-	const std::filesystem::path& filename,
-	/*const glm::vec3& position,
-	const glm::vec3& direction,*/
-	const std::vector<reflectance_vertex>& points
+/**
+ * Hands every point cloud of the directory to 'sink' as soon as its scan is parsed, instead of
+ * collecting them first. 'sink' is called from the job system's threads in no particular order,
+ * with either a 'basic_point_cloud&&' or a 'reflectance_point_cloud&&'.
+ * Returns once all scans are done.
+ */
+template<typename Sink>
+[[nodiscard]] inline std::error_code load_from_3dtk_directory(
+	const std::filesystem::path& directory,
+	Sink&& sink
 );
 
-[[nodiscard]] inline std::error_code load_v1_c3d_file(
+/**
+ * Loads a whole '.c3d' file without copying its points to the heap.
+ * The point cloud keeps the file mapped and 'init_vao' streams the points straight to the GPU.
+ * Compressed files cannot be uploaded as they are and get decoded instead.
+ */
+template<vertex_component... Cs>
+[[nodiscard]] inline std::error_code load_c3d_point_cloud(
 	const std::filesystem::path& filename,
-	std::vector<reflectance_vertex>& points
+	std::vector<point_cloud<Cs...>>& point_clouds
 );
 
 } // namespace point_cloud_loader
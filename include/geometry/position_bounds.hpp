@@ -0,0 +1,152 @@
+#pragma once
+
+#include <tuple>
+#include <cfloat>
+#include <vector>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <glm/vec3.hpp>
+#include "util/uix.hpp"
+#include "util/job_system.hpp"
+#include "geometry/aabb.hpp"
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+namespace position_bounds_internal {
+
+/**
+ * Min/max over 'count' positions, the first at 'first' and every following one 'stride' bytes further.
+ * Every position is loaded as four floats, so the fourth lane reads into whatever follows the position.
+ * That is fine inside the buffer, only the last position is copied out to not read past its end.
+ */
+inline void min_max(const char* first, const ztu::usize count, const ztu::usize stride, aabb& box) {
+	if (count == 0) {
+		return;
+	}
+
+	const auto num_loaded = count - 1;
+
+	float last[4]{};
+	std::memcpy(last, first + num_loaded * stride, sizeof(glm::vec3));
+
+	float min[4], max[4];
+
+#if defined(__SSE__)
+	auto min4 = _mm_loadu_ps(last), max4 = min4;
+	ztu::usize i = 0;
+
+#ifdef __AVX__
+	// Two positions per register.
+	auto min8 = _mm256_set1_ps(FLT_MAX), max8 = _mm256_set1_ps(-FLT_MAX);
+	for (; i + 2 <= num_loaded; i += 2) {
+		const auto p = first + i * stride;
+		const auto v = _mm256_insertf128_ps(
+			_mm256_castps128_ps256(_mm_loadu_ps(reinterpret_cast<const float*>(p))),
+			_mm_loadu_ps(reinterpret_cast<const float*>(p + stride)),
+			1
+		);
+		min8 = _mm256_min_ps(min8, v);
+		max8 = _mm256_max_ps(max8, v);
+	}
+	min4 = _mm_min_ps(min4, _mm_min_ps(_mm256_castps256_ps128(min8), _mm256_extractf128_ps(min8, 1)));
+	max4 = _mm_max_ps(max4, _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1)));
+#endif
+
+	for (; i < num_loaded; i++) {
+		const auto v = _mm_loadu_ps(reinterpret_cast<const float*>(first + i * stride));
+		min4 = _mm_min_ps(min4, v);
+		max4 = _mm_max_ps(max4, v);
+	}
+
+	_mm_storeu_ps(min, min4);
+	_mm_storeu_ps(max, max4);
+
+#elif defined(__ARM_NEON)
+	auto min4 = vld1q_f32(last), max4 = min4;
+	for (ztu::usize i = 0; i < num_loaded; i++) {
+		const auto v = vld1q_f32(reinterpret_cast<const float*>(first + i * stride));
+		min4 = vminq_f32(min4, v);
+		max4 = vmaxq_f32(max4, v);
+	}
+	vst1q_f32(min, min4);
+	vst1q_f32(max, max4);
+
+#else
+	std::copy_n(last, 3, min);
+	std::copy_n(last, 3, max);
+	for (ztu::usize i = 0; i < num_loaded; i++) {
+		float v[3];
+		std::memcpy(v, first + i * stride, sizeof(v));
+		for (int j = 0; j < 3; j++) {
+			min[j] = std::min(min[j], v[j]);
+			max[j] = std::max(max[j], v[j]);
+		}
+	}
+#endif
+
+	box.join({ { min[0], min[1], min[2] }, { max[0], max[1], max[2] } });
+}
+
+} // namespace position_bounds_internal
+
+
+/**
+ * Bounds of the positions of a vertex buffer, read straight from the raw vertex stream.
+ * The position is expected to be the first component of every vertex.
+ */
+namespace position_bounds {
+
+template<typename Vertex>
+[[nodiscard]] inline aabb calc(const Vertex* vertices, const ztu::usize num_vertices) {
+	static_assert(std::is_same_v<std::remove_cvref_t<decltype(std::get<0>(*vertices))>, glm::vec3>);
+
+	aabb box;
+	if (num_vertices == 0) {
+		return box;
+	}
+
+	// The tuple layout is up to the standard library, so the position is not necessarily at the front.
+	const auto first = reinterpret_cast<const char*>(&std::get<0>(*vertices));
+	position_bounds_internal::min_max(first, num_vertices, sizeof(Vertex), box);
+
+	return box;
+}
+
+/**
+ * Splits the vertices into slices whose bounds are calculated in parallel on the job system.
+ */
+template<typename Vertex>
+[[nodiscard]] inline aabb calc_parallel(
+	const Vertex* vertices,
+	const ztu::usize num_vertices,
+	ztu::job_system& jobs = ztu::job_system::shared()
+) {
+	static constexpr ztu::usize min_vertices_per_slice = 1 << 16;
+
+	const auto num_slices = std::min(jobs.num_workers() + 1, num_vertices / min_vertices_per_slice + 1);
+	if (num_slices == 1) {
+		return calc(vertices, num_vertices);
+	}
+
+	std::vector<aabb> slice_boxes(num_slices);
+	jobs.parallel_for(
+		num_slices, [&](const ztu::usize t) {
+			const auto begin = num_vertices * t / num_slices, end = num_vertices * (t + 1) / num_slices;
+			slice_boxes[t] = calc(vertices + begin, end - begin);
+		}
+	);
+
+	aabb box;
+	for (const auto& slice_box : slice_boxes) {
+		box.join(slice_box);
+	}
+	return box;
+}
+
+} // namespace position_bounds
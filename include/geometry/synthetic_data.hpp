@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include "util/uix.hpp"
+#include "geometry/point_cloud_io.hpp"
+
+
+/**
+ * Deterministic generators for benchmark inputs of configurable size.
+ * The same arguments always produce the same files, so results of different runs stay comparable.
+ */
+namespace synthetic_data {
+
+/**
+ * Writes a height field of 'grid_size' x 'grid_size' vertices as quads into a single object.
+ * Texture coordinates and normals are written as separate 'vt'/'vn' lists and referenced by the faces.
+ */
+[[nodiscard]] std::error_code write_grid_obj(
+	const std::filesystem::path& filename,
+	ztu::u32 grid_size,
+	bool tex_coords,
+	bool normals
+);
+
+/**
+ * Writes a material library of colored and partly transparent materials.
+ */
+[[nodiscard]] std::error_code write_mtl(
+	const std::filesystem::path& filename,
+	ztu::u32 num_materials
+);
+
+/**
+ * Writes a '.3d' scan with three or, with 'reflectance', four floats per line and its '.pose' file.
+ * The floats are written as decimals or, with 'hex', as hexadecimal floats as 3dtk does.
+ */
+[[nodiscard]] std::error_code write_3dtk_scan(
+	const std::filesystem::path& base_filename,
+	ztu::u64 num_points,
+	bool reflectance,
+	bool hex,
+	ztu::u32 seed = 0
+);
+
+/**
+ * Points on a noisy sphere around the origin with reflectance in [0, 1].
+ */
+void generate_points(
+	ztu::u64 num_points,
+	std::vector<point_cloud_loader::reflectance_vertex>& points,
+	ztu::u32 seed = 0
+);
+
+} // namespace synthetic_data
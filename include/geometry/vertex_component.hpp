@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <tuple>
+#include <algorithm>
 #include <util/uix.hpp>
 
 #include <glm/vec3.hpp>
@@ -33,3 +36,35 @@ using color = vertex_component_internal::base_vertex_component<3, float, 3>;
 using reflectance = vertex_component_internal::base_vertex_component<1, float, 4>;
 
 } // namespace vertex_components
+
+/**
+ * 'uuid' of every component, as stored in the headers of binary geometry files.
+ */
+template<vertex_component... Cs>
+inline constexpr auto vertex_component_uuids = std::array{ static_cast<ztu::u8>(Cs::uuid)... };
+
+/**
+ * Copies the components of a vertex as packed values in component order.
+ * This keeps file layouts independent of how the tuple is laid out in memory.
+ */
+template<typename Vertex, typename T>
+inline T* pack_vertex(const Vertex& vertex, T* dst) {
+	std::apply(
+		[&dst](const auto&... components) {
+			((dst = std::copy_n(&components[0], components.length(), dst)), ...);
+		},
+		vertex
+	);
+	return dst;
+}
+
+template<typename Vertex, typename T>
+inline const T* unpack_vertex(const T* src, Vertex& vertex) {
+	std::apply(
+		[&src](auto&... components) {
+			((std::copy_n(src, components.length(), &components[0]), src += components.length()), ...);
+		},
+		vertex
+	);
+	return src;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <system_error>
+#include "util/uix.hpp"
+
+
+/**
+ * Offscreen color and depth buffer that keeps its contents across frames, so an image can be built up over
+ * several frames and shown after each of them. It has the sample count of the window's framebuffer,
+ * so showing it is a single blit.
+ */
+class accumulation_buffer {
+public:
+	accumulation_buffer() = default;
+
+	accumulation_buffer(const accumulation_buffer&) = delete;
+
+	accumulation_buffer& operator=(const accumulation_buffer&) = delete;
+
+	~accumulation_buffer();
+
+	/**
+	 * (Re)creates the buffers in the given size, the default framebuffer has to be bound.
+	 * Fails if the result cannot be blitted to the default framebuffer.
+	 */
+	[[nodiscard]] static std::error_code create(ztu::u32 width, ztu::u32 height, accumulation_buffer& dst);
+
+	/**
+	 * Directs the following draws into the buffer.
+	 */
+	void bind() const;
+
+	/**
+	 * Copies the color into the default framebuffer and binds it again.
+	 */
+	void present() const;
+
+private:
+	void release();
+
+private:
+	GLuint m_framebuffer{ 0 };
+	GLuint m_color_buffer{ 0 };
+	GLuint m_depth_buffer{ 0 };
+	ztu::u32 m_width{ 0 };
+	ztu::u32 m_height{ 0 };
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include <glm/glm.hpp>
+#include "graphics/flying_camera.hpp"
+
+
+/**
+ * Camera movement recorded as the inputs of consecutive fixed time step updates of a 'flying_camera'.
+ * Replaying them from the same spawn with the same time step reproduces the exact same views.
+ * The file is plain text, a header line with the time step in milliseconds and the spawn position
+ * followed by one 'dx dy keys' line per update, lines starting with '#' are ignored.
+ */
+struct camera_path {
+	float delta_time{ 1000.0f / 60.0f };
+	glm::vec3 spawn{ 0, 0, 0 };
+	std::vector<flying_camera::input> inputs;
+
+	[[nodiscard]] static std::error_code load(const std::filesystem::path& filename, camera_path& dst);
+
+	[[nodiscard]] std::error_code save(const std::filesystem::path& filename) const;
+};
@@ -1,11 +1,47 @@
 #pragma once
 
 #include "graphics/camera.hpp"
+#include "util/uix.hpp"
 
 
 class flying_camera : public camera {
 public:
+	/**
+	 * Everything a single update depends on, so camera movement can be recorded and replayed.
+	 */
+	struct input {
+		enum key : ztu::u8 {
+			forward = 1 << 0,
+			backward = 1 << 1,
+			right = 1 << 2,
+			left = 1 << 3,
+			up = 1 << 4,
+			down = 1 << 5,
+			boost = 1 << 6
+		};
+
+		int dx{ 0 }, dy{ 0 };
+		ztu::u8 keys{ 0 };
+
+		/**
+		 * True if neither the mouse moved nor a movement key is pressed.
+		 */
+		[[nodiscard]] bool empty() const;
+	};
+
 	flying_camera(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& world_up);
 
+	/**
+	 * Reads the pressed movement keys.
+	 */
+	[[nodiscard]] static input poll_input(int dx, int dy);
+
 	void update(float deltaT, int dx, int dy) override;
+
+	void update(float deltaT, const input& current);
+
+	/**
+	 * True once the camera stopped drifting, it only moves again on new input.
+	 */
+	[[nodiscard]] bool at_rest() const;
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <SFML/OpenGL.hpp>
+
+#include <array>
+#include <chrono>
+#include "util/uix.hpp"
+#include "util/perf_stats.hpp"
+
+
+/**
+ * Bounds the number of frames queued in the driver and estimates the time from sampling input until its frame is done.
+ * A fence is inserted after every frame, before the next frame samples input 'wait' blocks until fewer than
+ * 'max_frames_in_flight' frames are unfinished, so the input is not sampled long before the GPU gets to it.
+ * The latency ends when the fence is seen signaled, so it excludes scan out and is an upper bound if the
+ * fence was signaled before it was checked. At most 'max_pending' frames are tracked, older ones are dropped.
+ */
+class frame_latency {
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr ztu::usize max_pending = 8;
+
+	/**
+	 * A 'max_frames_in_flight' of zero only measures and never blocks.
+	 */
+	frame_latency(ztu::perf_stats::samples& target, ztu::usize max_frames_in_flight);
+
+	frame_latency(const frame_latency&) = delete;
+
+	frame_latency& operator=(const frame_latency&) = delete;
+
+	~frame_latency();
+
+	/**
+	 * Blocks until fewer than 'max_frames_in_flight' frames are unfinished.
+	 */
+	void wait();
+
+	/**
+	 * Blocks until all frames are finished, for example before the loop goes idle.
+	 */
+	void finish();
+
+	/**
+	 * Marks the time the input of the current frame was sampled.
+	 */
+	void input_sampled();
+
+	/**
+	 * Inserts the fence of the current frame, to be called after its last command.
+	 */
+	void frame_submitted();
+
+	/**
+	 * Reads all finished frames, without waiting for the others.
+	 */
+	void collect();
+
+	[[nodiscard]] ztu::usize num_dropped() const;
+
+private:
+	struct pending_frame {
+		GLsync fence;
+		clock::time_point input_time;
+	};
+
+	/**
+	 * Waits for the oldest frame, adds its latency to the samples and removes it.
+	 */
+	void wait_oldest();
+
+	void pop_oldest();
+
+private:
+	ztu::perf_stats::samples& m_target;
+	ztu::usize m_max_frames_in_flight;
+	std::array<pending_frame, max_pending> m_pending{};
+	ztu::usize m_first{ 0 };
+	ztu::usize m_size{ 0 };
+	clock::time_point m_input_time{ clock::now() };
+	ztu::usize m_num_dropped{ 0 };
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <GL/glew.h>
+
+
+/**
+ * Table of the GL entry points used to submit draws. Renderers, shaders and attributes call GL through it,
+ * so it can be swapped for a backend without a GPU (see 'gl_backends.hpp') to measure their CPU cost.
+ * Apart from the buffers the renderers own, resource creation and uploads still call GL directly.
+ */
+struct gl_api {
+	void (*use_program)(GLuint program);
+	void (*delete_program)(GLuint program);
+	GLint (*get_uniform_location)(GLuint program, const GLchar* name);
+	void (*uniform_matrix4fv)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+	void (*uniform_matrix3fv)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+	void (*uniform4fv)(GLint location, GLsizei count, const GLfloat* value);
+	void (*uniform3fv)(GLint location, GLsizei count, const GLfloat* value);
+	void (*uniform2fv)(GLint location, GLsizei count, const GLfloat* value);
+	void (*uniform1f)(GLint location, GLfloat value);
+	void (*uniform1i)(GLint location, GLint value);
+	void (*active_texture)(GLenum texture);
+	void (*bind_texture)(GLenum target, GLuint texture);
+	void (*bind_vertex_array)(GLuint array);
+	void (*bind_buffer)(GLenum target, GLuint buffer);
+	void (*gen_buffers)(GLsizei count, GLuint* buffers);
+	void (*delete_buffers)(GLsizei count, const GLuint* buffers);
+	void (*buffer_data)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+	void (*enable)(GLenum capability);
+	void (*polygon_mode)(GLenum face, GLenum mode);
+	void (*draw_arrays)(GLenum mode, GLint first, GLsizei count);
+	void (*draw_elements)(GLenum mode, GLsizei count, GLenum type, const void* indices);
+	void (*draw_elements_base_vertex)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base_vertex);
+
+	/**
+	 * Forwards to the driver, GLEW's entry points are looked up at the time of the call,
+	 * so the table is valid before 'glewInit'.
+	 */
+	static const gl_api driver;
+
+	[[nodiscard]] inline static const gl_api& current();
+
+	/**
+	 * Routes all following calls through the given table, it has to stay alive until it is replaced.
+	 */
+	inline static void use(const gl_api& api);
+
+private:
+	inline static const gl_api* s_current{ &driver };
+};
+
+
+inline constexpr gl_api gl_api::driver{
+	.use_program = [](const GLuint program) { glUseProgram(program); },
+	.delete_program = [](const GLuint program) { glDeleteProgram(program); },
+	.get_uniform_location = [](const GLuint program, const GLchar* name) {
+		return glGetUniformLocation(program, name);
+	},
+	.uniform_matrix4fv = [](const GLint location, const GLsizei count, const GLboolean transpose, const GLfloat* value) {
+		glUniformMatrix4fv(location, count, transpose, value);
+	},
+	.uniform_matrix3fv = [](const GLint location, const GLsizei count, const GLboolean transpose, const GLfloat* value) {
+		glUniformMatrix3fv(location, count, transpose, value);
+	},
+	.uniform4fv = [](const GLint location, const GLsizei count, const GLfloat* value) {
+		glUniform4fv(location, count, value);
+	},
+	.uniform3fv = [](const GLint location, const GLsizei count, const GLfloat* value) {
+		glUniform3fv(location, count, value);
+	},
+	.uniform2fv = [](const GLint location, const GLsizei count, const GLfloat* value) {
+		glUniform2fv(location, count, value);
+	},
+	.uniform1f = [](const GLint location, const GLfloat value) { glUniform1f(location, value); },
+	.uniform1i = [](const GLint location, const GLint value) { glUniform1i(location, value); },
+	.active_texture = [](const GLenum texture) { glActiveTexture(texture); },
+	.bind_texture = [](const GLenum target, const GLuint texture) { glBindTexture(target, texture); },
+	.bind_vertex_array = [](const GLuint array) { glBindVertexArray(array); },
+	.bind_buffer = [](const GLenum target, const GLuint buffer) { glBindBuffer(target, buffer); },
+	.gen_buffers = [](const GLsizei count, GLuint* buffers) { glGenBuffers(count, buffers); },
+	.delete_buffers = [](const GLsizei count, const GLuint* buffers) { glDeleteBuffers(count, buffers); },
+	.buffer_data = [](const GLenum target, const GLsizeiptr size, const void* data, const GLenum usage) {
+		glBufferData(target, size, data, usage);
+	},
+	.enable = [](const GLenum capability) { glEnable(capability); },
+	.polygon_mode = [](const GLenum face, const GLenum mode) { glPolygonMode(face, mode); },
+	.draw_arrays = [](const GLenum mode, const GLint first, const GLsizei count) {
+		glDrawArrays(mode, first, count);
+	},
+	.draw_elements = [](const GLenum mode, const GLsizei count, const GLenum type, const void* indices) {
+		glDrawElements(mode, count, type, indices);
+	},
+	.draw_elements_base_vertex = [](
+		const GLenum mode, const GLsizei count, const GLenum type, const void* indices, const GLint base_vertex
+	) {
+		glDrawElementsBaseVertex(mode, count, type, indices, base_vertex);
+	}
+};
+
+const gl_api& gl_api::current() {
+	return *s_current;
+}
+
+void gl_api::use(const gl_api& api) {
+	s_current = &api;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include "util/uix.hpp"
+#include "util/string_literal.hpp"
+#include "graphics/gl_api.hpp"
+
+
+/**
+ * Does nothing but count the calls, uniform locations are all zero and generated names count up from one.
+ * Like the context it stands in for, it must only be used from one thread.
+ */
+class null_gl_backend {
+public:
+	static const gl_api api;
+
+	[[nodiscard]] inline static ztu::u64 num_calls();
+
+	[[nodiscard]] inline static ztu::u64 num_draw_calls();
+
+	inline static void reset();
+
+private:
+	template<typename... Args>
+	static void ignore(Args...) {
+		s_num_calls++;
+	}
+
+	template<typename... Args>
+	static GLint ignore_location(Args...) {
+		s_num_calls++;
+		return 0;
+	}
+
+	template<typename... Args>
+	static void ignore_draw(Args...) {
+		s_num_calls++;
+		s_num_draw_calls++;
+	}
+
+	static void generate_names(const GLsizei count, GLuint* names) {
+		s_num_calls++;
+		for (GLsizei i = 0; i < count; i++) {
+			names[i] = ++s_last_name;
+		}
+	}
+
+	inline static ztu::u64 s_num_calls{ 0 };
+	inline static ztu::u64 s_num_draw_calls{ 0 };
+	inline static GLuint s_last_name{ 0 };
+};
+
+/**
+ * Keeps every call with its arguments, for example to check which state a renderer sets per draw.
+ * Uniform locations are all zero and generated names count up from one.
+ * Like the context it stands in for, it must only be used from one thread.
+ */
+class recording_gl_backend {
+public:
+	struct call {
+		const char* function;
+		// Integer, enum and pointer arguments in order.
+		std::vector<ztu::i64> arguments;
+		// Float arguments and the floats behind uniform pointers.
+		std::vector<float> values;
+		// Names passed as strings, like uniform names.
+		std::string text;
+	};
+
+	static const gl_api api;
+
+	[[nodiscard]] inline static const std::vector<call>& calls();
+
+	inline static void clear();
+
+private:
+	/**
+	 * 'NumFloats' is the number of floats read from float pointer arguments, only the first element is recorded.
+	 */
+	template<ztu::string_literal Function, ztu::usize NumFloats = 0, typename... Args>
+	static void record(Args... args);
+
+	template<ztu::string_literal Function, typename... Args>
+	static GLint record_location(Args... args) {
+		record<Function>(args...);
+		return 0;
+	}
+
+	/**
+	 * Records the count followed by the names, which are generated first if 'Names' is not const.
+	 */
+	template<ztu::string_literal Function, typename Names>
+	static void record_names(GLsizei count, Names* names);
+
+	inline static std::vector<call> s_calls;
+	inline static GLuint s_last_name{ 0 };
+};
+
+
+inline constexpr gl_api null_gl_backend::api{
+	.use_program = ignore,
+	.delete_program = ignore,
+	.get_uniform_location = ignore_location,
+	.uniform_matrix4fv = ignore,
+	.uniform_matrix3fv = ignore,
+	.uniform4fv = ignore,
+	.uniform3fv = ignore,
+	.uniform2fv = ignore,
+	.uniform1f = ignore,
+	.uniform1i = ignore,
+	.active_texture = ignore,
+	.bind_texture = ignore,
+	.bind_vertex_array = ignore,
+	.bind_buffer = ignore,
+	.gen_buffers = generate_names,
+	.delete_buffers = ignore,
+	.buffer_data = ignore,
+	.enable = ignore,
+	.polygon_mode = ignore,
+	.draw_arrays = ignore_draw,
+	.draw_elements = ignore_draw,
+	.draw_elements_base_vertex = ignore_draw
+};
+
+ztu::u64 null_gl_backend::num_calls() {
+	return s_num_calls;
+}
+
+ztu::u64 null_gl_backend::num_draw_calls() {
+	return s_num_draw_calls;
+}
+
+void null_gl_backend::reset() {
+	s_num_calls = 0;
+	s_num_draw_calls = 0;
+}
+
+
+inline constexpr gl_api recording_gl_backend::api{
+	.use_program = record<"glUseProgram">,
+	.delete_program = record<"glDeleteProgram">,
+	.get_uniform_location = record_location<"glGetUniformLocation">,
+	.uniform_matrix4fv = record<"glUniformMatrix4fv", 16>,
+	.uniform_matrix3fv = record<"glUniformMatrix3fv", 9>,
+	.uniform4fv = record<"glUniform4fv", 4>,
+	.uniform3fv = record<"glUniform3fv", 3>,
+	.uniform2fv = record<"glUniform2fv", 2>,
+	.uniform1f = record<"glUniform1f">,
+	.uniform1i = record<"glUniform1i">,
+	.active_texture = record<"glActiveTexture">,
+	.bind_texture = record<"glBindTexture">,
+	.bind_vertex_array = record<"glBindVertexArray">,
+	.bind_buffer = record<"glBindBuffer">,
+	.gen_buffers = record_names<"glGenBuffers">,
+	.delete_buffers = record_names<"glDeleteBuffers">,
+	.buffer_data = record<"glBufferData">,
+	.enable = record<"glEnable">,
+	.polygon_mode = record<"glPolygonMode">,
+	.draw_arrays = record<"glDrawArrays">,
+	.draw_elements = record<"glDrawElements">,
+	.draw_elements_base_vertex = record<"glDrawElementsBaseVertex">
+};
+
+const std::vector<recording_gl_backend::call>& recording_gl_backend::calls() {
+	return s_calls;
+}
+
+void recording_gl_backend::clear() {
+	s_calls.clear();
+}
+
+template<ztu::string_literal Function, ztu::usize NumFloats, typename... Args>
+void recording_gl_backend::record(Args... args) {
+	auto& current = s_calls.emplace_back();
+	current.function = Function.c_str();
+
+	const auto add = [&]<typename Arg>(const Arg arg) {
+		if constexpr (std::is_same_v<Arg, const GLchar*>) {
+			current.text = arg;
+		} else if constexpr (std::is_same_v<Arg, const GLfloat*>) {
+			current.values.insert(current.values.end(), arg, arg + NumFloats);
+		} else if constexpr (std::is_pointer_v<Arg>) {
+			current.arguments.push_back(static_cast<ztu::i64>(reinterpret_cast<std::intptr_t>(arg)));
+		} else if constexpr (std::is_floating_point_v<Arg>) {
+			current.values.push_back(arg);
+		} else {
+			current.arguments.push_back(static_cast<ztu::i64>(arg));
+		}
+	};
+
+	(add(args), ...);
+}
+
+template<ztu::string_literal Function, typename Names>
+void recording_gl_backend::record_names(const GLsizei count, Names* names) {
+	auto& current = s_calls.emplace_back();
+	current.function = Function.c_str();
+	current.arguments.push_back(count);
+
+	for (GLsizei i = 0; i < count; i++) {
+		if constexpr (not std::is_const_v<Names>) {
+			names[i] = ++s_last_name;
+		}
+		current.arguments.push_back(names[i]);
+	}
+}
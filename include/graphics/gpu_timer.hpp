@@ -0,0 +1,66 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <SFML/OpenGL.hpp>
+
+#include <array>
+#include "util/uix.hpp"
+#include "util/perf_stats.hpp"
+
+
+/**
+ * Measures the GPU time of a range of commands with 'GL_TIME_ELAPSED' queries.
+ * The queries are double buffered, the result of a frame is read when its query is reused two frames later,
+ * so reading it does not stall the pipeline. Results that are still not available by then are dropped.
+ * Timers cannot overlap, as only one time elapsed query may be active at a time.
+ */
+class gpu_timer {
+public:
+	static constexpr ztu::usize num_buffers = 2;
+
+	class scope {
+	public:
+		explicit scope(gpu_timer& timer);
+
+		scope(const scope&) = delete;
+
+		scope& operator=(const scope&) = delete;
+
+		~scope();
+
+	private:
+		gpu_timer& m_timer;
+	};
+
+	explicit gpu_timer(ztu::perf_stats::samples& target);
+
+	gpu_timer(const gpu_timer&) = delete;
+
+	gpu_timer& operator=(const gpu_timer&) = delete;
+
+	~gpu_timer();
+
+	void begin();
+
+	void end();
+
+	/**
+	 * Reads the results of all ended queries that are available, without waiting for the others.
+	 */
+	void collect();
+
+	[[nodiscard]] ztu::usize num_dropped() const;
+
+private:
+	/**
+	 * Adds the result of the query to the samples if it is pending and available.
+	 */
+	bool read_result(ztu::usize index);
+
+private:
+	ztu::perf_stats::samples& m_target;
+	std::array<GLuint, num_buffers> m_queries{};
+	std::array<bool, num_buffers> m_pending{};
+	ztu::usize m_index{ 0 };
+	ztu::usize m_num_dropped{ 0 };
+};
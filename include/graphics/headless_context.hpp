@@ -0,0 +1,47 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <system_error>
+#include "util/uix.hpp"
+
+
+/**
+ * OpenGL context without a window that renders into an offscreen framebuffer.
+ * It is created on the surfaceless platform of Mesa's EGL, so it works without a display server
+ * and, with llvmpipe, without a GPU.
+ */
+class headless_context {
+public:
+	headless_context() = default;
+
+	headless_context(const headless_context&) = delete;
+
+	headless_context& operator=(const headless_context&) = delete;
+
+	~headless_context();
+
+	/**
+	 * Creates the context, makes it current on the calling thread and binds a framebuffer of the given size.
+	 */
+	[[nodiscard]] static std::error_code create(ztu::u32 width, ztu::u32 height, headless_context& dst);
+
+	[[nodiscard]] ztu::u32 width() const;
+
+	[[nodiscard]] ztu::u32 height() const;
+
+private:
+	/**
+	 * Deletes whatever 'create' got to, so it also cleans up after a failed 'create'.
+	 */
+	void release();
+
+private:
+	// 'EGLDisplay' and 'EGLContext', kept opaque so EGL stays out of this header.
+	void* m_display{ nullptr };
+	void* m_context{ nullptr };
+	GLuint m_framebuffer{ 0 };
+	GLuint m_color_buffer{ 0 };
+	GLuint m_depth_buffer{ 0 };
+	ztu::u32 m_width{ 0 };
+	ztu::u32 m_height{ 0 };
+};
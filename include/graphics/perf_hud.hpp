@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/RenderWindow.hpp>
+#include "util/perf_stats.hpp"
+
+
+/**
+ * Overlay listing the CPU and GPU timings of all sections in the top left corner of the window.
+ */
+class perf_hud {
+public:
+	// Rebuilding the text every frame would make the numbers unreadable and show up in the timings.
+	static constexpr auto refresh_interval = std::chrono::milliseconds(250);
+
+	explicit perf_hud(const sf::Font& font);
+
+	void toggle();
+
+	[[nodiscard]] bool visible() const;
+
+	/**
+	 * Draws the overlay if it is visible, the GL state of the renderers is saved and restored around it.
+	 */
+	void draw(sf::RenderWindow& window, const ztu::perf_stats& stats);
+
+private:
+	void update_text(const ztu::perf_stats& stats);
+
+private:
+	sf::Text m_text;
+	sf::RectangleShape m_background;
+	ztu::perf_stats::clock::time_point m_last_update{};
+	bool m_visible{ false };
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "util/uix.hpp"
+
+
+/**
+ * Number of points drawn per frame, adapted so the measured time of the draws stays at a target.
+ * The cost per point is assumed to be constant, so every measurement moves the budget part of the way
+ * to the number of points that would have taken exactly the target time.
+ */
+class point_budget {
+public:
+	/**
+	 * Starts at 'max_points' and never exceeds it.
+	 */
+	point_budget(ztu::usize max_points, float target_ms);
+
+	[[nodiscard]] ztu::usize points() const;
+
+	/**
+	 * Adjusts the budget to a frame that took 'points_ms' to draw 'num_drawn' points and 'other_ms' for the rest,
+	 * the points get whatever the rest leaves of the target. Frames that drew fewer points than the budget
+	 * only lower it if even those took too long.
+	 */
+	void update(ztu::usize num_drawn, float points_ms, float other_ms);
+
+private:
+	ztu::usize m_max_points;
+	ztu::usize m_min_points;
+	float m_target_ms;
+	double m_points;
+};
@@ -3,12 +3,19 @@
 #include <SFML/OpenGL.hpp>
 #include "graphics/renderable_attribute.hpp"
 #include "graphics/texture.hpp"
+#include "graphics/gl_api.hpp"
+#include "graphics/upload_scheduler.hpp"
+#include "util/memory_stats.hpp"
 
 
 struct texture_attribute : public renderable_attribute_internal::base_renderable_attribute<"color_merge"> {
 	GLuint m_texture_id{ 0 };
+	ztu::memory_stats::counter m_gpu_memory{ ztu::memory_stats::category::gpu_textures };
 
-	texture_attribute(const texture& tex) {
+	/**
+	 * Only allocates the texture, the pixels are uploaded by the scheduler.
+	 */
+	texture_attribute(const texture& tex, upload_scheduler& uploads) {
 		glGenTextures(1, &m_texture_id);
 		glBindTexture(GL_TEXTURE_2D, m_texture_id);
 
@@ -19,9 +26,15 @@ struct texture_attribute : public renderable_attribute_internal::base_renderable
 
 		glTexImage2D(
 			GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<int>(tex.width()), static_cast<int>(tex.height()), 0, GL_RGBA,
-			GL_UNSIGNED_BYTE, tex.data()
+			GL_UNSIGNED_BYTE, nullptr
 		);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// The mipmap chain adds another third of the level 0 size.
+		const auto level_size = static_cast<ztu::usize>(tex.width() * tex.height()) * 4;
+		m_gpu_memory.set(level_size + level_size / 3);
+
+		uploads.enqueue_texture(m_texture_id, tex.width(), tex.height(), tex.data());
 	}
 
 	texture_attribute(const texture_attribute&) = delete;
@@ -34,13 +47,13 @@ struct texture_attribute : public renderable_attribute_internal::base_renderable
 
 	template<ztu::string_literal... Parameters>
 	inline void pre_render(shader<Parameters...>& s) const {
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, m_texture_id);
+		gl_api::current().active_texture(GL_TEXTURE0);
+		gl_api::current().bind_texture(GL_TEXTURE_2D, m_texture_id);
 	}
 
 	template<ztu::string_literal... Parameters>
 	inline void post_render(shader<Parameters...>& s) const {
-		glBindTexture(GL_TEXTURE_2D, 0);
+		gl_api::current().bind_texture(GL_TEXTURE_2D, 0);
 	}
 };
 
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <span>
 #include "util/uix.hpp"
+#include "geometry/point_cloud_chunk.hpp"
 #include "graphics/renderable_attributes.hpp"
 #include "graphics/dynamic_renderable_attribute.hpp"
 
@@ -16,4 +18,5 @@ struct point_cloud_instance {
 	ztu::isize num_points;
 	glm::mat4x4 transform;
 	std::vector<point_cloud_attributes> attributes;
+	std::span<const point_cloud_chunk> chunks;
 };
\ No newline at end of file
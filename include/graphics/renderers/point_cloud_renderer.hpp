@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "renderer.hpp"
 #include "graphics/renderables/point_cloud_instance.hpp"
 #include <graphics/shaders.hpp>
@@ -14,14 +15,79 @@ public:
 		m_point_shader{ n_point_shader } {
 	};
 
+	point_cloud_renderer(const point_cloud_renderer&) = delete;
+
+	point_cloud_renderer& operator=(const point_cloud_renderer&) = delete;
+
+	~point_cloud_renderer();
+
 	void render(
 		std::span<point_cloud_instance> point_clouds,
 		const glm::mat4& proj_matrix,
 		const glm::mat4& view_matrix
 	);
 
+	/**
+	 * Splits every chunk into 'num_slices' random subsets of about the same size, so any number of slices
+	 * gives an evenly thinned out version of the point cloud. Creates the index buffer holding the
+	 * random permutation shared by all chunks, so it requires a current context.
+	 */
+	void enable_slices(ztu::u32 num_slices);
+
+	[[nodiscard]] ztu::u32 num_slices() const;
+
+	/**
+	 * Draws the slices ['first_slice', 'first_slice' + 'count') of every visible chunk, slices must be enabled.
+	 * Chunks smaller than 'point_cloud_chunk::max_points' only occur at the end of a point cloud, they are not
+	 * permuted and drawn completely with the first slice.
+	 */
+	void render_slices(
+		std::span<point_cloud_instance> point_clouds,
+		const glm::mat4& proj_matrix,
+		const glm::mat4& view_matrix,
+		ztu::u32 first_slice,
+		ztu::u32 count
+	);
+
+	/**
+	 * Draws about 'max_points' points, split across the visible chunks of all point clouds by their projected size.
+	 * Every chunk draws the first points of the random permutation, so fewer points thin it out evenly.
+	 * Chunks smaller than 'point_cloud_chunk::max_points' are drawn completely if they get at least half of their points.
+	 * Creates the permutation on first use, returns the number of points drawn.
+	 */
+	ztu::usize render_budget(
+		std::span<point_cloud_instance> point_clouds,
+		const glm::mat4& proj_matrix,
+		const glm::mat4& view_matrix,
+		ztu::usize max_points
+	);
+
+private:
+	struct budget_chunk {
+		ztu::usize point_cloud;
+		ztu::isize offset;
+		ztu::isize num_points;
+		float weight;
+		ztu::isize num_drawn;
+	};
+
+	void create_permutation();
+
+	template<typename DrawVisible>
+	void render_visible(
+		std::span<point_cloud_instance> point_clouds,
+		const glm::mat4& proj_matrix,
+		const glm::mat4& view_matrix,
+		const DrawVisible& draw_visible
+	);
+
 private:
 	point_shader_t* m_point_shader;
+	ztu::u32 m_num_slices{ 0 };
+	GLuint m_permutation{ 0 };
+	// Kept between frames to not allocate while drawing.
+	std::vector<budget_chunk> m_budget_chunks;
+	std::vector<ztu::u32> m_budget_order;
 };
 
-static_assert(renderer<point_cloud_renderer, point_cloud_instance>);
\ No newline at end of file
+static_assert(renderer<point_cloud_renderer, point_cloud_instance>);
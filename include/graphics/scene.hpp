@@ -0,0 +1,136 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <variant>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "util/uix.hpp"
+#include "util/handoff_queue.hpp"
+#include "util/memory_stats.hpp"
+#include "geometry/aabb.hpp"
+#include "geometry/mesh.hpp"
+#include "geometry/point_cloud_loader.hpp"
+#include "geometry/material.hpp"
+#include "graphics/upload_scheduler.hpp"
+#include "graphics/renderable_attributes.hpp"
+
+
+using default_mesh = mesh<vertex_components::tex_coord, vertex_components::normal>;
+
+/**
+ * Assets loaded from the given inputs together with their instances.
+ * Inputs are parsed on the job system and handed to the thread owning the GL context,
+ * which uploads them with 'stream'. Instances only appear once all of their data is resident.
+ */
+class scene {
+public:
+	struct options {
+		bool pedantic{ false };
+		// Otherwise the CPU copies of the geometry are dropped once uploaded and fetched again from their files on demand.
+		bool keep_geometry{ false };
+		// The loaded assets are scaled to fit into this box.
+		glm::vec3 outer_box{ 100, 100, 100 };
+	};
+
+	explicit scene(const options& opts);
+
+	scene(const scene&) = delete;
+
+	scene& operator=(const scene&) = delete;
+
+	/**
+	 * Waits for the loader jobs, as they still reference the scene.
+	 */
+	~scene();
+
+	void load(const std::vector<std::filesystem::path>& inputs);
+
+	/**
+	 * Takes over the assets that have been parsed so far and uploads them within the given budget.
+	 * Returns true once all inputs are loaded and uploaded.
+	 */
+	bool stream(const upload_scheduler::budget& frame_budget);
+
+	/**
+	 * Blocks until all inputs are loaded and uploaded.
+	 */
+	void finish_loading();
+
+	[[nodiscard]] bool loaded() const;
+
+	[[nodiscard]] ztu::usize num_inputs() const;
+
+	[[nodiscard]] ztu::usize num_inputs_left() const;
+
+	[[nodiscard]] ztu::usize num_pending_upload_bytes() const;
+
+	[[nodiscard]] std::span<mesh_instance> mesh_instances();
+
+	[[nodiscard]] std::span<point_cloud_instance> point_cloud_instances();
+
+	/**
+	 * Scales the assets into the outer box, it is applied on top of the view matrix so it can follow the loaded assets.
+	 */
+	[[nodiscard]] const glm::mat4& model_transform() const;
+
+	void log_asset_memory() const;
+
+private:
+	struct mesh_asset {
+		std::vector<default_mesh> meshes;
+		std::unordered_map<std::string, std::shared_ptr<material>> materials;
+	};
+
+	using loaded_asset = std::variant<mesh_asset, basic_point_cloud, reflectance_point_cloud>;
+
+	void load_input(const std::filesystem::path& path);
+
+	void add_mesh_asset(mesh_asset& asset);
+
+	template<class PointCloud>
+	void add_point_cloud(std::deque<PointCloud>& point_clouds, PointCloud&& loaded_point_cloud);
+
+	void update_model_transform();
+
+private:
+	options m_options;
+
+	// Loader jobs hand their CPU side assets over through this queue.
+	ztu::handoff_queue<loaded_asset> m_loaded_assets;
+	std::vector<loaded_asset> m_arrived_assets;
+	std::vector<std::future<void>> m_pending_inputs;
+	ztu::usize m_num_inputs{ 0 };
+	std::atomic<ztu::usize> m_num_inputs_left{ 0 };
+	bool m_loaded{ false };
+
+	upload_scheduler m_uploads;
+	// Active from the first arrived asset until everything is uploaded.
+	std::optional<ztu::memory_stats::phase_scope> m_upload_phase;
+
+	// Deques keep the assets in place, instances point into their chunks.
+	std::deque<default_mesh> m_meshes;
+	// Materials stay scoped to the file that defined them, meshes only hold weak references.
+	std::vector<std::unordered_map<std::string, std::shared_ptr<material>>> m_materials;
+	std::deque<basic_point_cloud> m_basic_point_clouds;
+	std::deque<reflectance_point_cloud> m_reflectance_point_clouds;
+
+	std::vector<mesh_instance> m_mesh_instances;
+	std::vector<point_cloud_instance> m_point_cloud_instances;
+
+	std::shared_ptr<renderable_attributes::color> m_fallback_color_attr;
+	std::shared_ptr<renderable_attributes::point_size> m_fallback_point_size_attr;
+	std::array<std::shared_ptr<renderable_attributes::color>, 20> m_colors{};
+
+	aabb m_model_box;
+	glm::mat4 m_model_transform{ 1.0f };
+	ztu::u64 m_num_points{ 0 }, m_num_vertices{ 0 };
+};
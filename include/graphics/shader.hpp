@@ -8,6 +8,8 @@
 #include <glm/glm.hpp>
 #include "util/string_literal.hpp"
 #include "util/string_indexer.hpp"
+#include "graphics/gl_api.hpp"
+#include "graphics/shader_program.hpp"
 
 
 template<ztu::string_literal... Parameters>
@@ -17,8 +19,6 @@ private:
 
 	[[nodiscard]] inline static std::error_code load_source(const std::filesystem::path& filename, std::string& source);
 
-	[[nodiscard]] inline static std::error_code compile(GLenum type, const std::string& source, GLuint& shader_id);
-
 public:
 	[[nodiscard]] inline static std::error_code from_files(
 		const std::filesystem::path& vertex_file,
@@ -34,6 +34,19 @@ public:
 		shader& dst
 	);
 
+	/**
+	 * Starts building the program without waiting for the driver, so several programs can compile at once.
+	 * The shader is usable once 'finish' returned successfully.
+	 */
+	[[nodiscard]] inline static pending_program begin_from_files(
+		const std::filesystem::path& vertex_file,
+		const std::filesystem::path& geometry_file,
+		const std::filesystem::path& fragment_file,
+		const program_binary_cache* cache = nullptr
+	);
+
+	[[nodiscard]] inline std::error_code finish(pending_program& program, const program_binary_cache* cache = nullptr);
+
 	inline shader() = default;
 
 	inline shader(shader<Parameters...>&& other);
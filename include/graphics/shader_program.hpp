@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <filesystem>
+#include <system_error>
+#include <GL/glew.h>
+#include <SFML/OpenGL.hpp>
+
+
+/**
+ * Stores linked program binaries in a directory, keyed by a hash of the sources and the driver.
+ * The cache is disabled if the driver offers no binary formats or the directory cannot be created.
+ */
+class program_binary_cache {
+public:
+	explicit program_binary_cache(std::filesystem::path directory);
+
+	[[nodiscard]] bool enabled() const;
+
+	[[nodiscard]] std::string key(const std::array<std::string, 3>& sources) const;
+
+	/**
+	 * Hands the cached binary to the program, whether it is accepted is only known after querying the link status.
+	 */
+	[[nodiscard]] bool load(const std::string& key, GLuint program_id) const;
+
+	void store(const std::string& key, GLuint program_id) const;
+
+private:
+	std::filesystem::path m_directory;
+	std::string m_driver;
+	bool m_enabled{ false };
+};
+
+
+/**
+ * Program whose shaders are handed to the driver but whose status has not been queried yet.
+ * Drivers with 'KHR_parallel_shader_compile' keep compiling in the background until then.
+ */
+struct pending_program {
+	std::array<std::string, 3> sources;
+	std::array<GLuint, 3> shader_ids{};
+	GLuint program_id{ 0 };
+	std::string cache_key;
+	bool from_cache{ false };
+};
+
+
+namespace shader_program {
+
+/**
+ * Lets the driver compile and link on as many threads as it likes, if it supports that at all.
+ */
+void enable_parallel_compile();
+
+/**
+ * Loads the program from the cache or issues the compile and link commands, without waiting for either.
+ * Sources are given in vertex, geometry, fragment order, empty stages fall back to the default.
+ */
+[[nodiscard]] pending_program begin(std::array<std::string, 3> sources, const program_binary_cache* cache = nullptr);
+
+/**
+ * Waits for the program and stores its binary in the cache if it was compiled.
+ * Stages that failed to compile are dropped and the program is linked again without them.
+ */
+[[nodiscard]] std::error_code finish(
+	pending_program& program,
+	GLuint& program_id,
+	const program_binary_cache* cache = nullptr
+);
+
+} // namespace shader_program
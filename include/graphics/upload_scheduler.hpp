@@ -0,0 +1,83 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <SFML/OpenGL.hpp>
+
+#include <deque>
+#include <chrono>
+#include <functional>
+#include "util/uix.hpp"
+
+
+/**
+ * Spreads buffer and texture uploads over several frames.
+ * Uploads are split into slices and run in the order they were enqueued, until the per frame budget is used up.
+ * Callbacks are queued in the same order, so a callback only runs once everything enqueued before it is resident.
+ * The source data has to stay valid until its upload is done.
+ */
+class upload_scheduler {
+public:
+	struct budget {
+		ztu::usize max_bytes;
+		std::chrono::microseconds max_time;
+	};
+
+	// Called with every uploaded slice of the source data, for example to release it.
+	using slice_callback = std::function<void(const char* data, ztu::usize size)>;
+
+	static constexpr ztu::usize slice_size = ztu::usize{ 4 } << 20;
+
+	/**
+	 * Uploads 'size' bytes to the start of 'buffer', which must already have storage for them.
+	 */
+	void enqueue_buffer(GLuint buffer, const void* data, ztu::usize size, slice_callback on_slice_uploaded = {});
+
+	/**
+	 * Uploads RGBA8 pixels to the level 0 of 'texture', which must already have storage for them.
+	 * Mipmaps are generated once the last row is uploaded.
+	 */
+	void enqueue_texture(GLuint texture, ztu::usize width, ztu::usize height, const void* data);
+
+	void enqueue_callback(std::function<void()> callback);
+
+	/**
+	 * Uploads slices until the byte or the time budget is used up, at least one slice is always uploaded.
+	 */
+	void run(const budget& frame_budget);
+
+	/**
+	 * Uploads everything that is enqueued, regardless of any budget.
+	 */
+	void flush();
+
+	[[nodiscard]] bool idle() const;
+
+	[[nodiscard]] ztu::usize num_pending_bytes() const;
+
+private:
+	enum class task_type {
+		buffer,
+		texture,
+		callback
+	};
+
+	struct task {
+		task_type type;
+		GLuint id;
+		const char* data;
+		ztu::usize size;
+		ztu::usize row_size;
+		ztu::usize offset;
+		slice_callback on_slice_uploaded;
+		std::function<void()> callback;
+	};
+
+	/**
+	 * Uploads the next slice of the front task and returns the number of uploaded bytes.
+	 */
+	ztu::usize upload_slice();
+
+private:
+	std::deque<task> m_tasks;
+	ztu::usize m_num_pending_bytes{ 0 };
+};
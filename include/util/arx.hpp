@@ -133,7 +133,8 @@ template<std::floating_point Type, std::chars_format Format>
 } // namespace arx_parsers
 
 template<class... Flags>
-arx<Flags...>::arx(int num_args, const char* const* args) : m_arguments(std::max(num_args - 1, 0)) {
+arx<Flags...>::arx(int num_args, const char* const* args) {
+	m_arguments.reserve(std::max(num_args - 1, 0));
 	for (int i = 1; i < num_args; i++) {
 		const auto argument = std::string_view{ args[i] };
 
@@ -168,7 +169,8 @@ arx<Flags...>::arx(int num_args, const char* const* args) : m_arguments(std::max
 		}
 	}
 
-	std::sort(
+	// Stable, so positional arguments keep their order and the last of repeated flags wins.
+	std::stable_sort(
 		m_arguments.begin(), m_arguments.end(), [](const auto& a, const auto& b) -> bool {
 			return a.first < b.first;
 		}
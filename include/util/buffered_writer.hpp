@@ -0,0 +1,236 @@
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+#include <type_traits>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include "util/uix.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace ztu {
+
+/**
+ * Write only file that collects small writes in a large buffer and passes them on in few big 'write' calls.
+ * The first error sticks, so a sequence of writes only needs to be checked once at the end with 'close'.
+ */
+class buffered_writer {
+public:
+	static constexpr usize default_buffer_size = usize{ 4 } << 20;
+
+	[[nodiscard]] inline static std::error_code open(
+		const std::filesystem::path& filename,
+		buffered_writer& dst,
+		usize buffer_size = default_buffer_size
+	);
+
+	buffered_writer() = default;
+
+	buffered_writer(const buffered_writer&) = delete;
+
+	inline buffered_writer(buffered_writer&& other) noexcept;
+
+	buffered_writer& operator=(const buffered_writer&) = delete;
+
+	inline buffered_writer& operator=(buffered_writer&& other) noexcept;
+
+	inline ~buffered_writer();
+
+	inline void write(const void* data, usize size);
+
+	template<typename T>
+	requires std::is_trivially_copyable_v<T>
+	inline void write(const T& value);
+
+	inline void flush();
+
+	/**
+	 * Flushes and closes the file, returns the first error of all previous writes.
+	 */
+	[[nodiscard]] inline std::error_code close();
+
+	[[nodiscard]] inline std::error_code error() const;
+
+	[[nodiscard]] inline usize bytes_written() const;
+
+private:
+	inline void write_through(const char* data, usize size);
+
+private:
+#ifdef __linux__
+	int m_fd{ -1 };
+#else
+	std::ofstream m_out;
+#endif
+	std::vector<char> m_buffer;
+	usize m_buffered{ 0 };
+	usize m_bytes_written{ 0 };
+	std::error_code m_error;
+};
+
+
+std::error_code buffered_writer::open(
+	const std::filesystem::path& filename,
+	buffered_writer& dst,
+	const usize buffer_size
+) {
+	if (const auto e = dst.close(); e) {
+		return e;
+	}
+
+#ifdef __linux__
+	dst.m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (dst.m_fd == -1) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+#else
+	dst.m_out = std::ofstream(filename, std::ios::binary);
+	if (not dst.m_out.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+#endif
+
+	dst.m_buffer.resize(buffer_size);
+	dst.m_buffered = 0;
+	dst.m_bytes_written = 0;
+	dst.m_error = {};
+
+	return {};
+}
+
+buffered_writer::buffered_writer(buffered_writer&& other) noexcept :
+#ifdef __linux__
+	m_fd{ other.m_fd },
+#else
+	m_out{ std::move(other.m_out) },
+#endif
+	m_buffer{ std::move(other.m_buffer) },
+	m_buffered{ other.m_buffered },
+	m_bytes_written{ other.m_bytes_written },
+	m_error{ other.m_error } {
+#ifdef __linux__
+	other.m_fd = -1;
+#endif
+	other.m_buffered = 0;
+}
+
+buffered_writer& buffered_writer::operator=(buffered_writer&& other) noexcept {
+	if (&other != this) {
+		(void) close();
+#ifdef __linux__
+		m_fd = other.m_fd;
+		other.m_fd = -1;
+#else
+		m_out = std::move(other.m_out);
+#endif
+		m_buffer = std::move(other.m_buffer);
+		m_buffered = other.m_buffered;
+		m_bytes_written = other.m_bytes_written;
+		m_error = other.m_error;
+		other.m_buffered = 0;
+	}
+	return *this;
+}
+
+buffered_writer::~buffered_writer() {
+	(void) close();
+}
+
+void buffered_writer::write(const void* data, const usize size) {
+	const auto bytes = static_cast<const char*>(data);
+	if (m_buffered + size <= m_buffer.size()) {
+		std::memcpy(m_buffer.data() + m_buffered, bytes, size);
+		m_buffered += size;
+	} else {
+		flush();
+		// Writes that would fill most of the buffer anyway are passed on directly.
+		if (size >= m_buffer.size() / 2) {
+			write_through(bytes, size);
+		} else {
+			std::memcpy(m_buffer.data(), bytes, size);
+			m_buffered = size;
+		}
+	}
+	m_bytes_written += size;
+}
+
+template<typename T>
+requires std::is_trivially_copyable_v<T>
+void buffered_writer::write(const T& value) {
+	write(&value, sizeof(T));
+}
+
+void buffered_writer::flush() {
+	write_through(m_buffer.data(), m_buffered);
+	m_buffered = 0;
+}
+
+void buffered_writer::write_through(const char* data, usize size) {
+	if (m_error or size == 0) {
+		return;
+	}
+#ifdef __linux__
+	while (size != 0) {
+		const auto num_written = ::write(m_fd, data, size);
+		if (num_written == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			m_error = std::make_error_code(static_cast<std::errc>(errno));
+			return;
+		}
+		data += num_written;
+		size -= static_cast<usize>(num_written);
+	}
+#else
+	if (not m_out.write(data, static_cast<std::streamsize>(size))) {
+		m_error = std::make_error_code(std::errc::io_error);
+	}
+#endif
+}
+
+std::error_code buffered_writer::close() {
+#ifdef __linux__
+	const auto is_open = m_fd != -1;
+#else
+	const auto is_open = m_out.is_open();
+#endif
+	if (not is_open) {
+		return m_error;
+	}
+
+	flush();
+
+#ifdef __linux__
+	if (::close(m_fd) != 0 and not m_error) {
+		m_error = std::make_error_code(static_cast<std::errc>(errno));
+	}
+	m_fd = -1;
+#else
+	m_out.close();
+	if (m_out.fail() and not m_error) {
+		m_error = std::make_error_code(std::errc::io_error);
+	}
+#endif
+
+	m_buffer.clear();
+	m_buffer.shrink_to_fit();
+
+	return m_error;
+}
+
+std::error_code buffered_writer::error() const {
+	return m_error;
+}
+
+usize buffered_writer::bytes_written() const {
+	return m_bytes_written;
+}
+
+} // namespace ztu
@@ -3,6 +3,8 @@
 #include <string_view>
 #include <optional>
 #include <charconv>
+#include <concepts>
+#include <limits>
 #include <glm/glm.hpp>
 
 namespace extra_arx_parsers {
@@ -25,4 +27,41 @@ namespace extra_arx_parsers {
 		return vec;
 	}
 
+	/**
+	 * Parses counts like "20M" with an optional decimal 'k', 'M' or 'G' suffix.
+	 */
+	template<std::integral T>
+	[[nodiscard]] inline std::optional<T> count(const std::string_view& str) {
+		T value{};
+		const auto [ptr, ec] = std::from_chars(str.cbegin(), str.cend(), value);
+		if (ec != std::errc()) {
+			return std::nullopt;
+		}
+		if (ptr == str.cend()) {
+			return value;
+		}
+		if (ptr + 1 != str.cend()) {
+			return std::nullopt;
+		}
+
+		T factor;
+		switch (*ptr) {
+		case 'k':
+			factor = 1'000;
+			break;
+		case 'M':
+			factor = 1'000'000;
+			break;
+		case 'G':
+			factor = 1'000'000'000;
+			break;
+		default:
+			return std::nullopt;
+		}
+		if (value > std::numeric_limits<T>::max() / factor) {
+			return std::nullopt;
+		}
+		return value * factor;
+	}
+
 }
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <cstdio>
+#include "util/uix.hpp"
+#include "util/logger.hpp"
+#include "util/buffered_writer.hpp"
+
+
+namespace ztu {
+
+/**
+ * Ends frames on a fixed schedule and measures the time that actually passed between them.
+ * 'sleep_until' alone wakes up late by the scheduler's granularity, so the pacer sleeps until
+ * shortly before the deadline and spins for the rest. The time it sleeps short adapts to the
+ * oversleeping observed so far. A frame that overruns its deadline is counted as missed and the
+ * schedule restarts from there instead of rushing the following frames to catch up.
+ */
+class frame_pacer {
+public:
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * Counts the frame intervals of the whole run in buckets of 'bucket_width_ms',
+	 * intervals beyond the last bucket are counted in it.
+	 */
+	class histogram {
+	public:
+		static constexpr float bucket_width_ms = 0.1f;
+		static constexpr usize num_buckets = 2000;
+
+		inline void add(float milliseconds);
+
+		[[nodiscard]] inline u64 size() const;
+
+		/**
+		 * Upper bound of the bucket holding the given percentile, zero if there are no samples.
+		 */
+		[[nodiscard]] inline float percentile(float percent) const;
+
+		[[nodiscard]] inline float max() const;
+
+		/**
+		 * Writes one 'upper_bound_ms,count' line per non empty bucket.
+		 */
+		[[nodiscard]] inline std::error_code write_csv(const std::filesystem::path& filename) const;
+
+	private:
+		std::array<u64, num_buckets> m_counts{};
+		u64 m_size{ 0 };
+		float m_max{ 0.0f };
+	};
+
+	explicit inline frame_pacer(clock::duration interval);
+
+	/**
+	 * Blocks until the current frame's deadline and returns the time since the previous frame ended.
+	 */
+	inline clock::duration wait();
+
+	/**
+	 * Starts a new schedule from now, for example after the loop blocked on something else.
+	 * The gap is neither measured nor counted as a missed deadline.
+	 */
+	inline void restart();
+
+	[[nodiscard]] inline clock::duration interval() const;
+
+	[[nodiscard]] inline u64 num_frames() const;
+
+	[[nodiscard]] inline u64 num_missed() const;
+
+	[[nodiscard]] inline const histogram& intervals() const;
+
+	template<logger::level Level>
+	inline void log_report() const;
+
+private:
+	static constexpr auto min_slack = std::chrono::microseconds(100);
+	static constexpr auto max_slack = std::chrono::milliseconds(4);
+
+	clock::duration m_interval;
+	clock::time_point m_deadline;
+	clock::time_point m_last_frame;
+	clock::duration m_sleep_slack{ std::chrono::milliseconds(1) };
+	u64 m_num_frames{ 0 };
+	u64 m_num_missed{ 0 };
+	histogram m_intervals;
+};
+
+
+void frame_pacer::histogram::add(const float milliseconds) {
+	const auto bucket = static_cast<usize>(std::max(milliseconds, 0.0f) / bucket_width_ms);
+	m_counts[std::min(bucket, num_buckets - 1)]++;
+	m_size++;
+	m_max = std::max(m_max, milliseconds);
+}
+
+u64 frame_pacer::histogram::size() const {
+	return m_size;
+}
+
+float frame_pacer::histogram::percentile(const float percent) const {
+	if (m_size == 0) {
+		return 0.0f;
+	}
+
+	// Nearest rank, as in 'perf_stats'.
+	const auto rank = std::max(static_cast<u64>(percent / 100.0f * static_cast<float>(m_size) + 0.99f), u64{ 1 });
+
+	auto count = u64{ 0 };
+	for (usize i = 0; i != num_buckets; ++i) {
+		count += m_counts[i];
+		if (count >= rank) {
+			return std::min(static_cast<float>(i + 1) * bucket_width_ms, m_max);
+		}
+	}
+
+	return m_max;
+}
+
+float frame_pacer::histogram::max() const {
+	return m_max;
+}
+
+std::error_code frame_pacer::histogram::write_csv(const std::filesystem::path& filename) const {
+	buffered_writer out;
+	if (const auto e = buffered_writer::open(filename, out, usize{ 64 } << 10); e) {
+		return e;
+	}
+
+	static constexpr char header[] = "upper_bound_ms,count\n";
+	out.write(header, sizeof(header) - 1);
+
+	char line[64];
+	for (usize i = 0; i != num_buckets; ++i) {
+		if (m_counts[i] == 0) {
+			continue;
+		}
+		const auto length = std::snprintf(
+			line, sizeof(line), "%.1f,%llu\n",
+			static_cast<double>(i + 1) * bucket_width_ms, static_cast<unsigned long long>(m_counts[i])
+		);
+		out.write(line, static_cast<usize>(length));
+	}
+
+	return out.close();
+}
+
+
+frame_pacer::frame_pacer(const clock::duration interval) : m_interval{ interval } {
+	restart();
+}
+
+frame_pacer::clock::duration frame_pacer::wait() {
+	auto now = clock::now();
+
+	if (now > m_deadline) {
+		m_num_missed++;
+		m_deadline = now;
+	} else {
+		const auto wake_up = m_deadline - m_sleep_slack;
+		if (now < wake_up) {
+			std::this_thread::sleep_until(wake_up);
+			// Grows right away but shrinks slowly, a single punctual wake up says little about the next one.
+			const auto overslept = clock::now() - wake_up;
+			m_sleep_slack = std::clamp<clock::duration>(
+				overslept > m_sleep_slack ? overslept : m_sleep_slack - (m_sleep_slack - overslept) / 16,
+				min_slack, max_slack
+			);
+		}
+		while ((now = clock::now()) < m_deadline) {
+			std::this_thread::yield();
+		}
+	}
+
+	const auto elapsed = now - m_last_frame;
+	m_last_frame = now;
+	m_deadline += m_interval;
+
+	m_num_frames++;
+	m_intervals.add(std::chrono::duration<float, std::milli>(elapsed).count());
+
+	return elapsed;
+}
+
+void frame_pacer::restart() {
+	m_last_frame = clock::now();
+	m_deadline = m_last_frame + m_interval;
+}
+
+frame_pacer::clock::duration frame_pacer::interval() const {
+	return m_interval;
+}
+
+u64 frame_pacer::num_frames() const {
+	return m_num_frames;
+}
+
+u64 frame_pacer::num_missed() const {
+	return m_num_missed;
+}
+
+const frame_pacer::histogram& frame_pacer::intervals() const {
+	return m_intervals;
+}
+
+template<logger::level Level>
+void frame_pacer::log_report() const {
+	logger::constexpr_println<Level, "pacing: % frames, % missed, target % ms, p50 % ms, p95 % ms, p99 % ms, max % ms">(
+		std::cout, logger::global_level,
+		m_num_frames, m_num_missed,
+		std::chrono::duration<float, std::milli>(m_interval).count(),
+		m_intervals.percentile(50), m_intervals.percentile(95), m_intervals.percentile(99), m_intervals.max()
+	);
+}
+
+} // namespace ztu
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <utility>
+
+
+namespace ztu {
+
+/**
+ * Lock free queue for handing values from any number of producer threads to a single consumer.
+ * Producers push onto an intrusive stack with a single compare exchange, the consumer
+ * detaches the whole stack at once and restores the push order, so no node is ever
+ * popped concurrently and the stack is free of ABA problems.
+ */
+template<typename T>
+class handoff_queue {
+public:
+	handoff_queue() = default;
+
+	handoff_queue(const handoff_queue&) = delete;
+
+	handoff_queue& operator=(const handoff_queue&) = delete;
+
+	inline ~handoff_queue();
+
+	inline void push(T&& value);
+
+	/**
+	 * Moves all values pushed so far to the back of 'dst', oldest first.
+	 * May only be called by one thread at a time.
+	 */
+	inline void take_all(std::vector<T>& dst);
+
+	[[nodiscard]] inline bool empty() const;
+
+private:
+	struct node {
+		T value;
+		node* next;
+	};
+
+	std::atomic<node*> m_head{ nullptr };
+};
+
+
+template<typename T>
+handoff_queue<T>::~handoff_queue() {
+	auto it = m_head.exchange(nullptr, std::memory_order_acquire);
+	while (it) {
+		delete std::exchange(it, it->next);
+	}
+}
+
+template<typename T>
+void handoff_queue<T>::push(T&& value) {
+	auto new_node = new node{ std::move(value), m_head.load(std::memory_order_relaxed) };
+	while (not m_head.compare_exchange_weak(
+		new_node->next, new_node,
+		std::memory_order_release,
+		std::memory_order_relaxed
+	));
+}
+
+template<typename T>
+void handoff_queue<T>::take_all(std::vector<T>& dst) {
+	auto it = m_head.exchange(nullptr, std::memory_order_acquire);
+
+	node* reversed = nullptr;
+	while (it) {
+		reversed = std::exchange(it, std::exchange(it->next, reversed));
+	}
+
+	while (reversed) {
+		dst.push_back(std::move(reversed->value));
+		delete std::exchange(reversed, reversed->next);
+	}
+}
+
+template<typename T>
+bool handoff_queue<T>::empty() const {
+	return m_head.load(std::memory_order_relaxed) == nullptr;
+}
+
+} // namespace ztu
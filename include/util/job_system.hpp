@@ -0,0 +1,242 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <future>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+#include "util/uix.hpp"
+#include "util/trace.hpp"
+
+
+namespace ztu {
+
+/**
+ * Thread pool where every worker owns a job queue.
+ * Workers take their newest job first and, once their own queue is empty,
+ * steal the oldest jobs from the other workers.
+ * Waiting on a job from inside another job runs pending jobs in the meantime,
+ * so nested parallelism cannot starve the pool.
+ */
+class job_system {
+public:
+	using job = std::function<void()>;
+
+	inline explicit job_system(usize num_workers = std::thread::hardware_concurrency());
+
+	job_system(const job_system&) = delete;
+
+	job_system& operator=(const job_system&) = delete;
+
+	inline ~job_system();
+
+	[[nodiscard]] inline static job_system& shared();
+
+	template<typename F>
+	[[nodiscard]] inline std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f);
+
+	template<typename T>
+	inline T wait(std::future<T>& future);
+
+	/**
+	 * Calls 'f(index)' for every index in [0, num_tasks) and returns once all calls are done.
+	 * The calling thread takes part in the work.
+	 */
+	template<typename F>
+	inline void parallel_for(usize num_tasks, const F& f);
+
+	inline bool run_pending();
+
+	[[nodiscard]] inline usize num_workers() const;
+
+private:
+	struct job_queue {
+		std::mutex mutex;
+		std::deque<job> jobs;
+	};
+
+	inline void push(job&& j);
+
+	inline bool pop(usize queue_index, job& dst);
+
+	inline void worker_loop(usize index);
+
+private:
+	std::vector<std::unique_ptr<job_queue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	std::atomic<usize> m_num_queued{ 0 };
+	std::atomic<usize> m_next_queue{ 0 };
+	std::atomic<bool> m_stop{ false };
+	std::mutex m_sleep_mutex;
+	std::condition_variable m_wake;
+
+	inline static thread_local job_system* t_owner{ nullptr };
+	inline static thread_local usize t_queue_index{ 0 };
+};
+
+
+job_system::job_system(usize num_workers) {
+	num_workers = std::max(num_workers, usize{ 1 });
+	m_queues.reserve(num_workers);
+	for (usize i = 0; i < num_workers; i++) {
+		m_queues.push_back(std::make_unique<job_queue>());
+	}
+	m_workers.reserve(num_workers);
+	for (usize i = 0; i < num_workers; i++) {
+		m_workers.emplace_back(&job_system::worker_loop, this, i);
+	}
+}
+
+job_system::~job_system() {
+	{
+		std::lock_guard lock(m_sleep_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+job_system& job_system::shared() {
+	static job_system instance;
+	return instance;
+}
+
+usize job_system::num_workers() const {
+	return m_workers.size();
+}
+
+template<typename F>
+std::future<std::invoke_result_t<std::decay_t<F>>> job_system::submit(F&& f) {
+	using result_t = std::invoke_result_t<std::decay_t<F>>;
+	// std::function needs copyable targets, so the task is shared instead of moved.
+	auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(f));
+	auto future = task->get_future();
+	push([task = std::move(task)]() { (*task)(); });
+	return future;
+}
+
+template<typename T>
+T job_system::wait(std::future<T>& future) {
+	using namespace std::chrono_literals;
+	while (future.wait_for(0s) != std::future_status::ready) {
+		if (not run_pending()) {
+			// Every queue is empty, so the job already runs on another thread and there is nothing left to help with.
+			future.wait();
+		}
+	}
+	return future.get();
+}
+
+template<typename F>
+void job_system::parallel_for(const usize num_tasks, const F& f) {
+	auto next_task = std::atomic<usize>{ 0 };
+	const auto run_tasks = [&]() {
+		for (auto task = next_task++; task < num_tasks; task = next_task++) {
+			f(task);
+		}
+	};
+
+	if (num_tasks == 0) {
+		return;
+	}
+
+	const auto num_helpers = std::min(num_tasks, num_workers() + 1) - 1;
+	std::vector<std::future<void>> helpers;
+	helpers.reserve(num_helpers);
+	for (usize i = 0; i < num_helpers; i++) {
+		helpers.push_back(submit(run_tasks));
+	}
+
+	run_tasks();
+
+	for (auto& helper : helpers) {
+		wait(helper);
+	}
+}
+
+bool job_system::run_pending() {
+	const auto index = t_owner == this ? t_queue_index : m_next_queue++ % m_queues.size();
+	job j;
+	if (pop(index, j)) {
+		j();
+		return true;
+	}
+	return false;
+}
+
+void job_system::push(job&& j) {
+	// Workers push to their own queue to keep nested jobs local, other threads distribute round-robin.
+	const auto index = t_owner == this ? t_queue_index : m_next_queue++ % m_queues.size();
+	{
+		auto& queue = *m_queues[index];
+		std::lock_guard lock(queue.mutex);
+		queue.jobs.push_back(std::move(j));
+	}
+	m_num_queued++;
+	{
+		// Synchronize with sleeping workers, so the notification cannot get lost.
+		std::lock_guard lock(m_sleep_mutex);
+	}
+	m_wake.notify_one();
+}
+
+bool job_system::pop(const usize queue_index, job& dst) {
+	if (m_num_queued == 0) {
+		return false;
+	}
+
+	{
+		auto& own_queue = *m_queues[queue_index];
+		std::lock_guard lock(own_queue.mutex);
+		if (not own_queue.jobs.empty()) {
+			dst = std::move(own_queue.jobs.back());
+			own_queue.jobs.pop_back();
+			m_num_queued--;
+			return true;
+		}
+	}
+
+	for (usize offset = 1; offset < m_queues.size(); offset++) {
+		auto& victim = *m_queues[(queue_index + offset) % m_queues.size()];
+		std::lock_guard lock(victim.mutex);
+		if (not victim.jobs.empty()) {
+			dst = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			m_num_queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void job_system::worker_loop(const usize index) {
+	t_owner = this;
+	t_queue_index = index;
+	trace::set_thread_name("worker " + std::to_string(index));
+
+	job j;
+	while (true) {
+		if (pop(index, j)) {
+			j();
+			j = nullptr;
+			continue;
+		}
+
+		std::unique_lock lock(m_sleep_mutex);
+		m_wake.wait(lock, [&]() { return m_stop or m_num_queued != 0; });
+		if (m_stop) {
+			break;
+		}
+	}
+}
+
+} // namespace ztu
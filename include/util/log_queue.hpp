@@ -0,0 +1,156 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <sstream>
+#include <utility>
+#include <iostream>
+#include <type_traits>
+#include "util/uix.hpp"
+
+
+namespace ztu {
+
+/**
+ * Bounded lock free queue that moves log records from any number of threads to a background writer.
+ * A record is a consume function together with its raw arguments, the function formats them
+ * on the writer thread into a batch for stdout or stderr, which is written and flushed once the
+ * queue runs empty. Producers only spin if the queue is full, so no record is ever dropped.
+ * The slots follow Dmitry Vyukov's bounded queue, every slot carries the position it is ready for.
+ */
+class log_queue {
+public:
+	static constexpr usize capacity = 1024;
+	static constexpr usize max_payload_size = 192;
+
+	// Formats the payload into the stream and destroys it.
+	using consume_fn = void (*)(std::ostream& out, std::byte* payload);
+
+	inline log_queue();
+
+	log_queue(const log_queue&) = delete;
+
+	log_queue& operator=(const log_queue&) = delete;
+
+	/**
+	 * Writes all pending records before returning.
+	 */
+	inline ~log_queue();
+
+	template<typename Payload>
+	inline void push(bool to_stderr, consume_fn consume, Payload&& payload);
+
+private:
+	struct slot {
+		std::atomic<usize> sequence;
+		bool to_stderr;
+		consume_fn consume;
+		alignas(std::max_align_t) std::byte payload[max_payload_size];
+	};
+
+	inline void writer_loop();
+
+private:
+	std::unique_ptr<slot[]> m_slots;
+	alignas(64) std::atomic<usize> m_enqueue_pos{ 0 };
+	alignas(64) std::atomic<u32> m_signal{ 0 };
+	std::atomic<bool> m_stop{ false };
+	std::thread m_writer;
+};
+
+
+log_queue::log_queue() : m_slots{ std::make_unique<slot[]>(capacity) } {
+	for (usize i = 0; i < capacity; i++) {
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	m_writer = std::thread(&log_queue::writer_loop, this);
+}
+
+log_queue::~log_queue() {
+	m_stop.store(true);
+	m_signal.fetch_add(1, std::memory_order_release);
+	m_signal.notify_one();
+	m_writer.join();
+}
+
+template<typename Payload>
+void log_queue::push(const bool to_stderr, const consume_fn consume, Payload&& payload) {
+	using payload_t = std::remove_cvref_t<Payload>;
+	static_assert(sizeof(payload_t) <= max_payload_size and alignof(payload_t) <= alignof(std::max_align_t));
+
+	auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+	slot* target;
+	while (true) {
+		target = &m_slots[pos % capacity];
+		const auto sequence = target->sequence.load(std::memory_order_acquire);
+		const auto diff = static_cast<isize>(sequence) - static_cast<isize>(pos);
+		if (diff == 0) {
+			if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// The writer has not caught up yet.
+			std::this_thread::yield();
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		} else {
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	target->to_stderr = to_stderr;
+	target->consume = consume;
+	new(target->payload) payload_t(std::forward<Payload>(payload));
+	target->sequence.store(pos + 1, std::memory_order_release);
+
+	m_signal.fetch_add(1, std::memory_order_release);
+	m_signal.notify_one();
+}
+
+void log_queue::writer_loop() {
+	static constexpr std::streamoff max_batch_size = 64 << 10;
+
+	std::ostringstream out_batch, err_batch;
+
+	const auto write_batches = [&]() {
+		// Errors go first, like they would with an unbuffered stderr.
+		for (auto [batch, stream] : { std::pair{ &err_batch, &std::cerr }, std::pair{ &out_batch, &std::cout } }) {
+			if (batch->tellp() > 0) {
+				*stream << batch->view();
+				stream->flush();
+				batch->str({});
+			}
+		}
+	};
+
+	usize dequeue_pos = 0;
+	while (true) {
+		const auto signal = m_signal.load(std::memory_order_acquire);
+
+		auto& current = m_slots[dequeue_pos % capacity];
+		if (current.sequence.load(std::memory_order_acquire) == dequeue_pos + 1) {
+			current.consume(current.to_stderr ? err_batch : out_batch, current.payload);
+			current.sequence.store(dequeue_pos + capacity, std::memory_order_release);
+			dequeue_pos++;
+			if (out_batch.tellp() + err_batch.tellp() >= max_batch_size) {
+				write_batches();
+			}
+			continue;
+		}
+
+		write_batches();
+
+		if (m_enqueue_pos.load(std::memory_order_relaxed) != dequeue_pos) {
+			// A producer claimed the slot but has not filled it yet.
+			std::this_thread::yield();
+		} else if (m_stop.load()) {
+			break;
+		} else {
+			m_signal.wait(signal, std::memory_order_acquire);
+		}
+	}
+}
+
+} // namespace ztu
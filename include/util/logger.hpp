@@ -1,12 +1,34 @@
 #pragma once
 
 #include <array>
+#include <tuple>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <string_view>
+#include <type_traits>
 
 #include "util/uix.hpp"
 #include "util/string_literal.hpp"
+#include "util/log_queue.hpp"
+
+
+// Lines above this level are removed at compile time, calls to them compile to nothing.
+#ifndef LOGGER_MAX_LEVEL
+#define LOGGER_MAX_LEVEL 4
+#endif
+
+// Debug lines are removed from release builds unless this is defined as 0.
+#ifndef LOGGER_STRIP_DEBUG
+#ifdef NDEBUG
+#define LOGGER_STRIP_DEBUG 1
+#else
+#define LOGGER_STRIP_DEBUG 0
+#endif
+#endif
 
 
 template<typename... Args>
@@ -59,6 +81,14 @@ public:
 
 	inline static void set_global_log_level(level n_level);
 
+	/**
+	 * From now on lines are only queued on the calling thread, they are formatted and written
+	 * in batches by a background thread. All queued lines are written before the program exits.
+	 */
+	inline static void enable_async();
+
+	[[nodiscard]] inline static constexpr bool is_compiled_in(level n_level);
+
 	inline void set_log_level(level n_level);
 
 
@@ -156,6 +186,24 @@ public:
 
 	template<logger::colors Color, ztu::string_literal Name>
 	[[nodiscard]] static constexpr auto create_prefix();
+
+	template<level Level, typename... Args>
+	inline static void write_line(std::ostream& out, const std::string_view& format, Args&& ... args);
+
+	template<level Level, ztu::string_literal Format, typename... Args>
+	inline static void constexpr_write_line(std::ostream& out, Args&& ... args);
+
+	template<level Level, ztu::string_literal Format, typename Payload>
+	inline static void consume_line(std::ostream& out, std::byte* payload);
+
+	inline static void consume_text(std::ostream& out, std::byte* payload);
+
+	/**
+	 * The queue lines to 'out' are pushed to in async mode, only 'std::cout' and 'std::cerr' are written asynchronously.
+	 */
+	[[nodiscard]] inline static ztu::log_queue* async_queue_for(const std::ostream& out);
+
+	inline static std::atomic<ztu::log_queue*> s_async_queue{ nullptr };
 };
 
 namespace logger_detail {
@@ -196,6 +244,29 @@ constexpr auto create_ANSI_color() {
 }
 
 static constexpr auto reset_color = create_ANSI_color<logger::colors::RESET, false>();
+
+template<typename T>
+inline constexpr bool is_c_string = std::is_pointer_v<T> and (
+	std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char> or
+		std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, unsigned char>
+);
+
+// Queued arguments are copied, so strings must not point into memory of the caller.
+template<typename T>
+using stored_t = std::conditional_t<
+	is_c_string<std::decay_t<T>> or std::is_same_v<std::decay_t<T>, std::string_view>,
+	std::string,
+	std::decay_t<T>
+>;
+
+template<typename T>
+stored_t<T> to_stored(T&& arg) {
+	if constexpr (is_c_string<std::decay_t<T>>) {
+		return std::string(reinterpret_cast<const char*>(arg));
+	} else {
+		return stored_t<T>(std::forward<T>(arg));
+	}
+}
 }
 
 template<logger::colors Color, ztu::string_literal Name>
@@ -284,30 +355,118 @@ void logger::set_log_level(logger::level n_level) {
 	m_level = n_level;
 }
 
+void logger::enable_async() {
+	// The pointer is reset before the queue writes its remaining lines and stops.
+	static struct async_state {
+		ztu::log_queue queue;
+
+		async_state() {
+			s_async_queue.store(&queue);
+		}
+
+		~async_state() {
+			s_async_queue.store(nullptr);
+		}
+	} state;
+}
+
+constexpr bool logger::is_compiled_in(const level n_level) {
+	return (
+		static_cast<int>(n_level) <= LOGGER_MAX_LEVEL and
+			not (LOGGER_STRIP_DEBUG and n_level == level::DBG)
+	);
+}
+
+ztu::log_queue* logger::async_queue_for(const std::ostream& out) {
+	const auto queue = s_async_queue.load(std::memory_order_relaxed);
+	return queue and (&out == &std::cout or &out == &std::cerr) ? queue : nullptr;
+}
+
 template<logger::level Level, typename... Args>
-void logger::println(std::ostream& out, level threshold, const std::string_view& format, Args&& ... args) {
+void logger::write_line(std::ostream& out, const std::string_view& format, Args&& ... args) {
 	constexpr auto colored_level = colored_level_names[static_cast<size_t>(Level)];
 	constexpr auto color_str = logger_detail::create_ANSI_color<colored_level.first, false>();
 	constexpr auto name_literal = ztu::string_literal<colored_level.second.length() + 1>(colored_level.second);
 	constexpr auto prefix = create_prefix<colored_level.first, name_literal>();
-	if (static_cast<ztu::u8>(threshold) >= static_cast<ztu::u8>(Level)) {
-		out << prefix;
-		print_impl<color_str>(out, format, std::forward<Args>(args)...);
-		out << std::endl;
-	}
+	out << prefix;
+	print_impl<color_str>(out, format, std::forward<Args>(args)...);
+	out << '\n';
 }
 
-
 template<logger::level Level, ztu::string_literal Format, typename... Args>
-constexpr void logger::constexpr_println(std::ostream& out, logger::level threshold, Args&& ... args) {
+void logger::constexpr_write_line(std::ostream& out, Args&& ... args) {
 	constexpr auto colored_level = colored_level_names[static_cast<size_t>(Level)];
 	constexpr auto color_str = logger_detail::create_ANSI_color<colored_level.first, false>();
 	constexpr auto name_literal = ztu::string_literal<colored_level.second.length() + 1>(colored_level.second);
 	constexpr auto prefix = create_prefix<colored_level.first, name_literal>();
-	if (static_cast<ztu::u8>(threshold) >= static_cast<ztu::u8>(Level)) {
-		out << prefix;
-		constexpr_print_impl<color_str, Format, 0>(out, std::forward<Args>(args)...);
-		out << std::endl;
+	out << prefix;
+	constexpr_print_impl<color_str, Format, 0>(out, std::forward<Args>(args)...);
+	out << '\n';
+}
+
+template<logger::level Level, ztu::string_literal Format, typename Payload>
+void logger::consume_line(std::ostream& out, std::byte* payload) {
+	const auto args = std::launder(reinterpret_cast<Payload*>(payload));
+	// Manipulators like 'std::hex' must not leak into the following lines of the batch.
+	const auto flags = out.flags();
+	std::apply(
+		[&out](auto& ... stored_args) {
+			constexpr_write_line<Level, Format>(out, stored_args...);
+		},
+		*args
+	);
+	out.flags(flags);
+	std::destroy_at(args);
+}
+
+void logger::consume_text(std::ostream& out, std::byte* payload) {
+	const auto text = std::launder(reinterpret_cast<std::string*>(payload));
+	out << *text;
+	std::destroy_at(text);
+}
+
+template<logger::level Level, typename... Args>
+void logger::println(std::ostream& out, level threshold, const std::string_view& format, Args&& ... args) {
+	if constexpr (is_compiled_in(Level)) {
+		if (static_cast<ztu::u8>(threshold) < static_cast<ztu::u8>(Level)) {
+			return;
+		}
+		if (const auto queue = async_queue_for(out)) {
+			// The format is only known at runtime, so only the write is deferred.
+			std::ostringstream line;
+			write_line<Level>(line, format, std::forward<Args>(args)...);
+			queue->push(&out == &std::cerr, &consume_text, std::move(line).str());
+		} else {
+			write_line<Level>(out, format, std::forward<Args>(args)...);
+			out.flush();
+		}
+	}
+}
+
+
+template<logger::level Level, ztu::string_literal Format, typename... Args>
+constexpr void logger::constexpr_println(std::ostream& out, logger::level threshold, Args&& ... args) {
+	if constexpr (is_compiled_in(Level)) {
+		if (static_cast<ztu::u8>(threshold) < static_cast<ztu::u8>(Level)) {
+			return;
+		}
+		if (const auto queue = async_queue_for(out)) {
+			using payload_t = std::tuple<logger_detail::stored_t<Args>...>;
+			if constexpr (sizeof(payload_t) <= ztu::log_queue::max_payload_size) {
+				queue->push(
+					&out == &std::cerr,
+					&consume_line<Level, Format, payload_t>,
+					payload_t(logger_detail::to_stored(std::forward<Args>(args))...)
+				);
+			} else {
+				std::ostringstream line;
+				constexpr_write_line<Level, Format>(line, std::forward<Args>(args)...);
+				queue->push(&out == &std::cerr, &consume_text, std::move(line).str());
+			}
+		} else {
+			constexpr_write_line<Level, Format>(out, std::forward<Args>(args)...);
+			out.flush();
+		}
 	}
 }
 
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include "util/uix.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace ztu {
+
+/**
+ * Read only view of a whole file.
+ * On linux the file is memory mapped, elsewhere it is read into a buffer.
+ */
+class mapped_file {
+public:
+	enum class access_pattern {
+		normal,
+		sequential,
+		random
+	};
+
+	[[nodiscard]] inline static std::error_code open(
+		const std::filesystem::path& filename,
+		mapped_file& dst,
+		access_pattern pattern = access_pattern::normal
+	);
+
+	mapped_file() = default;
+
+	mapped_file(const mapped_file&) = delete;
+
+	inline mapped_file(mapped_file&& other) noexcept;
+
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	inline mapped_file& operator=(mapped_file&& other) noexcept;
+
+	inline ~mapped_file();
+
+	[[nodiscard]] inline const char* data() const;
+
+	[[nodiscard]] inline const char* begin() const;
+
+	[[nodiscard]] inline const char* end() const;
+
+	[[nodiscard]] inline usize size() const;
+
+	[[nodiscard]] inline bool empty() const;
+
+	/**
+	 * Hints that the given byte range is not needed anymore, so its pages can leave the resident set.
+	 * Reading the range again faults the pages back in from the file.
+	 */
+	inline void release(usize offset, usize size) const;
+
+	inline void close();
+
+private:
+	const char* m_data{ nullptr };
+	usize m_size{ 0 };
+#ifndef __linux__
+	std::vector<char> m_buffer;
+#endif
+};
+
+
+std::error_code mapped_file::open(
+	const std::filesystem::path& filename,
+	mapped_file& dst,
+	[[maybe_unused]] const access_pattern pattern
+) {
+	dst.close();
+
+	std::error_code error;
+	const auto size = std::filesystem::file_size(filename, error);
+	if (error) {
+		return error;
+	}
+
+#ifdef __linux__
+	const auto fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	if (size == 0) {
+		::close(fd);
+		return {};
+	}
+
+	const auto bytes = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (bytes == MAP_FAILED) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	if (pattern != access_pattern::normal) {
+		madvise(bytes, size, pattern == access_pattern::sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+	}
+
+	dst.m_data = static_cast<const char*>(bytes);
+	dst.m_size = size;
+#else
+	auto in = std::ifstream(filename, std::ios::binary);
+	if (not in.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	dst.m_buffer.resize(size);
+	if (not in.read(dst.m_buffer.data(), static_cast<std::streamsize>(size))) {
+		dst.m_buffer.clear();
+		return std::make_error_code(std::errc::io_error);
+	}
+
+	dst.m_data = dst.m_buffer.data();
+	dst.m_size = size;
+#endif
+
+	return {};
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept :
+	m_data{ other.m_data },
+	m_size{ other.m_size }
+#ifndef __linux__
+	, m_buffer{ std::move(other.m_buffer) }
+#endif
+{
+	other.m_data = nullptr;
+	other.m_size = 0;
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+	if (&other != this) {
+		close();
+		m_data = other.m_data;
+		m_size = other.m_size;
+#ifndef __linux__
+		m_buffer = std::move(other.m_buffer);
+#endif
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+	return *this;
+}
+
+mapped_file::~mapped_file() {
+	close();
+}
+
+void mapped_file::close() {
+#ifdef __linux__
+	if (m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+#else
+	m_buffer.clear();
+	m_buffer.shrink_to_fit();
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
+
+const char* mapped_file::data() const {
+	return m_data;
+}
+
+const char* mapped_file::begin() const {
+	return m_data;
+}
+
+const char* mapped_file::end() const {
+	return m_data + m_size;
+}
+
+usize mapped_file::size() const {
+	return m_size;
+}
+
+bool mapped_file::empty() const {
+	return m_size == 0;
+}
+
+void mapped_file::release([[maybe_unused]] const usize offset, [[maybe_unused]] const usize size) const {
+#ifdef __linux__
+	if (offset >= m_size) {
+		return;
+	}
+	static const auto page_size = static_cast<usize>(sysconf(_SC_PAGESIZE));
+	const auto begin = offset / page_size * page_size;
+	const auto end = std::min(offset + size, m_size);
+	madvise(const_cast<char*>(m_data) + begin, end - begin, MADV_DONTNEED);
+#endif
+}
+
+} // namespace ztu
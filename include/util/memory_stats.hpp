@@ -0,0 +1,288 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+#include "util/uix.hpp"
+#include "util/logger.hpp"
+
+
+namespace ztu {
+
+namespace memory_stats_internal {
+
+template<usize NumCategories>
+struct atomic_totals {
+	std::array<std::atomic<usize>, NumCategories> bytes{};
+	std::atomic<usize> total_bytes{ 0 };
+};
+
+} // namespace memory_stats_internal
+
+/**
+ * Process wide accounting of the bytes held by assets, loader temporaries and GL objects.
+ * Every owner of memory holds a 'counter' that adds its bytes to one category, the totals
+ * and their peaks are kept in atomics so loader threads can update them without locking.
+ */
+class memory_stats {
+public:
+	enum class category : u8 {
+		cpu_geometry,
+		cpu_textures,
+		loader_temporaries,
+		gpu_buffers,
+		gpu_textures
+	};
+
+	static constexpr usize num_categories = 5;
+
+	static constexpr std::array<const char*, num_categories> category_names{
+		"CPU geometry", "CPU textures", "loader temporaries", "GPU buffers", "GPU textures"
+	};
+
+	/**
+	 * Phases of loading an asset, the peak of every category is recorded while a phase is active.
+	 */
+	enum class phase : u8 {
+		parse,
+		sort,
+		upload
+	};
+
+	static constexpr usize num_phases = 3;
+
+	static constexpr std::array<const char*, num_phases> phase_names{ "parse", "sort", "upload" };
+
+	struct totals {
+		std::array<usize, num_categories> bytes;
+		usize total_bytes;
+	};
+
+	/**
+	 * Bytes held by a single owner, they are removed from the category when the counter is destroyed.
+	 * Copies account for the same bytes again, as the owner's data is copied along with them.
+	 */
+	class counter {
+	public:
+		explicit inline counter(category type, usize bytes = 0);
+
+		inline counter(const counter& other);
+
+		inline counter(counter&& other) noexcept;
+
+		inline counter& operator=(const counter& other);
+
+		inline counter& operator=(counter&& other) noexcept;
+
+		inline ~counter();
+
+		inline void set(usize bytes);
+
+		[[nodiscard]] inline usize bytes() const;
+
+	private:
+		category m_category;
+		usize m_bytes;
+	};
+
+	/**
+	 * Marks a phase as active for the lifetime of the scope, phases of different threads may overlap.
+	 */
+	class phase_scope {
+	public:
+		explicit inline phase_scope(phase type);
+
+		phase_scope(const phase_scope&) = delete;
+
+		phase_scope& operator=(const phase_scope&) = delete;
+
+		inline ~phase_scope();
+
+	private:
+		phase m_phase;
+	};
+
+	inline static void add(category type, usize bytes);
+
+	inline static void remove(category type, usize bytes);
+
+	[[nodiscard]] inline static totals current();
+
+	[[nodiscard]] inline static totals peak();
+
+	[[nodiscard]] inline static totals phase_peak(phase type);
+
+	/**
+	 * Logs the current bytes and peaks of all categories and the peaks of all phases.
+	 */
+	template<logger::level Level>
+	inline static void log_report();
+
+private:
+	using atomic_totals = memory_stats_internal::atomic_totals<num_categories>;
+
+	inline static void raise_to(std::atomic<usize>& peak, usize bytes);
+
+	inline static void raise_to(atomic_totals& peak, category type, usize bytes, usize total_bytes);
+
+	[[nodiscard]] inline static totals load(const atomic_totals& values);
+
+	inline static atomic_totals s_current;
+	inline static atomic_totals s_peak;
+	inline static std::array<atomic_totals, num_phases> s_phase_peaks;
+	inline static std::array<std::atomic<u32>, num_phases> s_active_phases{};
+};
+
+
+memory_stats::counter::counter(const category type, const usize bytes) : m_category{ type }, m_bytes{ bytes } {
+	add(m_category, m_bytes);
+}
+
+memory_stats::counter::counter(const counter& other) : counter(other.m_category, other.m_bytes) {
+}
+
+memory_stats::counter::counter(counter&& other) noexcept :
+	m_category{ other.m_category },
+	m_bytes{ std::exchange(other.m_bytes, 0) } {
+}
+
+memory_stats::counter& memory_stats::counter::operator=(const counter& other) {
+	if (&other != this) {
+		remove(m_category, m_bytes);
+		m_category = other.m_category;
+		m_bytes = other.m_bytes;
+		add(m_category, m_bytes);
+	}
+	return *this;
+}
+
+memory_stats::counter& memory_stats::counter::operator=(counter&& other) noexcept {
+	if (&other != this) {
+		remove(m_category, m_bytes);
+		m_category = other.m_category;
+		m_bytes = std::exchange(other.m_bytes, 0);
+	}
+	return *this;
+}
+
+memory_stats::counter::~counter() {
+	remove(m_category, m_bytes);
+}
+
+void memory_stats::counter::set(const usize bytes) {
+	if (bytes > m_bytes) {
+		add(m_category, bytes - m_bytes);
+	} else {
+		remove(m_category, m_bytes - bytes);
+	}
+	m_bytes = bytes;
+}
+
+usize memory_stats::counter::bytes() const {
+	return m_bytes;
+}
+
+
+memory_stats::phase_scope::phase_scope(const phase type) : m_phase{ type } {
+	const auto index = static_cast<usize>(m_phase);
+	if (s_active_phases[index].fetch_add(1, std::memory_order_relaxed) == 0) {
+		// Memory that is already held when the phase starts also counts towards its peak.
+		const auto values = current();
+		for (usize i = 0; i < num_categories; i++) {
+			raise_to(s_phase_peaks[index].bytes[i], values.bytes[i]);
+		}
+		raise_to(s_phase_peaks[index].total_bytes, values.total_bytes);
+	}
+}
+
+memory_stats::phase_scope::~phase_scope() {
+	s_active_phases[static_cast<usize>(m_phase)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+void memory_stats::add(const category type, const usize bytes) {
+	if (bytes == 0) {
+		return;
+	}
+
+	const auto bytes_in_category = s_current.bytes[static_cast<usize>(type)].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	const auto total_bytes = s_current.total_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+	raise_to(s_peak, type, bytes_in_category, total_bytes);
+	for (usize i = 0; i < num_phases; i++) {
+		if (s_active_phases[i].load(std::memory_order_relaxed)) {
+			raise_to(s_phase_peaks[i], type, bytes_in_category, total_bytes);
+		}
+	}
+}
+
+void memory_stats::remove(const category type, const usize bytes) {
+	s_current.bytes[static_cast<usize>(type)].fetch_sub(bytes, std::memory_order_relaxed);
+	s_current.total_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+memory_stats::totals memory_stats::current() {
+	return load(s_current);
+}
+
+memory_stats::totals memory_stats::peak() {
+	return load(s_peak);
+}
+
+memory_stats::totals memory_stats::phase_peak(const phase type) {
+	return load(s_phase_peaks[static_cast<usize>(type)]);
+}
+
+template<logger::level Level>
+void memory_stats::log_report() {
+	static constexpr auto to_mib = [](const usize bytes) {
+		return static_cast<double>(bytes) / static_cast<double>(1 << 20);
+	};
+
+	const auto current_values = current(), peak_values = peak();
+	for (usize i = 0; i < num_categories; i++) {
+		logger::constexpr_println<Level, "memory: % % MiB (peak % MiB)">(
+			std::cout, logger::global_level,
+			category_names[i], to_mib(current_values.bytes[i]), to_mib(peak_values.bytes[i])
+		);
+	}
+	logger::constexpr_println<Level, "memory: total % MiB (peak % MiB)">(
+		std::cout, logger::global_level,
+		to_mib(current_values.total_bytes), to_mib(peak_values.total_bytes)
+	);
+
+	for (usize i = 0; i < num_phases; i++) {
+		const auto phase_values = phase_peak(static_cast<phase>(i));
+		logger::constexpr_println<Level, "memory: % phase peak % MiB, of which % MiB loader temporaries">(
+			std::cout, logger::global_level,
+			phase_names[i], to_mib(phase_values.total_bytes),
+			to_mib(phase_values.bytes[static_cast<usize>(category::loader_temporaries)])
+		);
+	}
+}
+
+void memory_stats::raise_to(std::atomic<usize>& peak, const usize bytes) {
+	auto expected = peak.load(std::memory_order_relaxed);
+	while (expected < bytes and not peak.compare_exchange_weak(expected, bytes, std::memory_order_relaxed));
+}
+
+void memory_stats::raise_to(
+	atomic_totals& peak,
+	const category type,
+	const usize bytes,
+	const usize total_bytes
+) {
+	raise_to(peak.bytes[static_cast<usize>(type)], bytes);
+	raise_to(peak.total_bytes, total_bytes);
+}
+
+memory_stats::totals memory_stats::load(const atomic_totals& values) {
+	totals result{};
+	for (usize i = 0; i < num_categories; i++) {
+		result.bytes[i] = values.bytes[i].load(std::memory_order_relaxed);
+	}
+	result.total_bytes = values.total_bytes.load(std::memory_order_relaxed);
+	return result;
+}
+
+} // namespace ztu
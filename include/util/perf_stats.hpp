@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <span>
+#include <string_view>
+#include "util/uix.hpp"
+#include "util/logger.hpp"
+
+
+namespace ztu {
+
+/**
+ * Rolling timings of named sections of the frame, measured on the CPU and optionally on the GPU.
+ * Every section keeps the last 'window_size' durations, from which averages and percentiles are computed on demand.
+ * Not thread safe, sections are meant to be recorded and read by the render thread.
+ */
+class perf_stats {
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr usize window_size = 256;
+
+	struct summary {
+		usize num_samples;
+		float average_ms;
+		float p50_ms;
+		float p95_ms;
+		float p99_ms;
+		float max_ms;
+	};
+
+	class samples {
+	public:
+		inline void add(float milliseconds);
+
+		inline void add(clock::duration duration);
+
+		[[nodiscard]] inline usize size() const;
+
+		/**
+		 * Returns the most recent sample or zero if there is none.
+		 */
+		[[nodiscard]] inline float last() const;
+
+		[[nodiscard]] inline summary summarize() const;
+
+	private:
+		std::array<float, window_size> m_values{};
+		usize m_next{ 0 };
+		usize m_size{ 0 };
+	};
+
+	struct section {
+		std::string name;
+		samples cpu;
+		samples gpu;
+	};
+
+	/**
+	 * Adds the CPU time from construction to destruction to the section.
+	 */
+	class cpu_scope {
+	public:
+		explicit inline cpu_scope(section& target);
+
+		cpu_scope(const cpu_scope&) = delete;
+
+		cpu_scope& operator=(const cpu_scope&) = delete;
+
+		inline ~cpu_scope();
+
+	private:
+		section& m_section;
+		clock::time_point m_start;
+	};
+
+	/**
+	 * Percentiles use the nearest rank, all values are zero if there are no samples.
+	 * The values are sorted in place.
+	 */
+	[[nodiscard]] inline static summary summarize(std::span<float> values);
+
+	/**
+	 * Returns the section with the given name and creates it on first use.
+	 * The reference stays valid for the lifetime of the stats, so hot code should look up its sections only once.
+	 */
+	[[nodiscard]] inline section& get(std::string_view name);
+
+	[[nodiscard]] inline const section* find(std::string_view name) const;
+
+	[[nodiscard]] inline const std::deque<section>& sections() const;
+
+	/**
+	 * Logs average, median, 95th and 99th percentile of every section.
+	 */
+	template<logger::level Level>
+	inline void log_report() const;
+
+private:
+	std::deque<section> m_sections;
+};
+
+
+void perf_stats::samples::add(const float milliseconds) {
+	m_values[m_next] = milliseconds;
+	m_next = (m_next + 1) % window_size;
+	m_size = std::min(m_size + 1, window_size);
+}
+
+void perf_stats::samples::add(const clock::duration duration) {
+	add(std::chrono::duration<float, std::milli>(duration).count());
+}
+
+usize perf_stats::samples::size() const {
+	return m_size;
+}
+
+float perf_stats::samples::last() const {
+	return m_size == 0 ? 0.0f : m_values[(m_next + window_size - 1) % window_size];
+}
+
+perf_stats::summary perf_stats::samples::summarize() const {
+	auto values = m_values;
+	return perf_stats::summarize(std::span(values.data(), m_size));
+}
+
+
+perf_stats::cpu_scope::cpu_scope(section& target) : m_section{ target }, m_start{ clock::now() } {
+}
+
+perf_stats::cpu_scope::~cpu_scope() {
+	m_section.cpu.add(clock::now() - m_start);
+}
+
+
+perf_stats::summary perf_stats::summarize(const std::span<float> values) {
+	if (values.empty()) {
+		return {};
+	}
+
+	std::sort(values.begin(), values.end());
+
+	auto sum = 0.0f;
+	for (const auto value : values) {
+		sum += value;
+	}
+
+	const auto percentile = [&](const usize percent) {
+		const auto rank = (percent * values.size() + 99) / 100;
+		return values[std::max(rank, usize{ 1 }) - 1];
+	};
+
+	return {
+		.num_samples = values.size(),
+		.average_ms = sum / static_cast<float>(values.size()),
+		.p50_ms = percentile(50),
+		.p95_ms = percentile(95),
+		.p99_ms = percentile(99),
+		.max_ms = values.back()
+	};
+}
+
+perf_stats::section& perf_stats::get(const std::string_view name) {
+	for (auto& current : m_sections) {
+		if (current.name == name) {
+			return current;
+		}
+	}
+	return m_sections.emplace_back(std::string(name));
+}
+
+const perf_stats::section* perf_stats::find(const std::string_view name) const {
+	for (const auto& current : m_sections) {
+		if (current.name == name) {
+			return &current;
+		}
+	}
+	return nullptr;
+}
+
+const std::deque<perf_stats::section>& perf_stats::sections() const {
+	return m_sections;
+}
+
+template<logger::level Level>
+void perf_stats::log_report() const {
+	for (const auto& current : m_sections) {
+		for (const auto& [samples, unit] : { std::pair{ &current.cpu, "CPU" }, std::pair{ &current.gpu, "GPU" } }) {
+			if (samples->size() == 0) {
+				continue;
+			}
+			const auto values = samples->summarize();
+			logger::constexpr_println<Level, "timing: % % avg % ms, p50 % ms, p95 % ms, p99 % ms (% samples)">(
+				std::cout, logger::global_level,
+				current.name, unit, values.average_ms, values.p50_ms, values.p95_ms, values.p99_ms, values.num_samples
+			);
+		}
+	}
+}
+
+} // namespace ztu
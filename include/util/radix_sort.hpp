@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include "util/uix.hpp"
+#include "util/job_system.hpp"
+
+
+namespace ztu {
+
+/**
+ * Stable LSD radix sort of key value pairs by the lowest 'KeyBits' bits of the key.
+ * Every pass builds one histogram per slice of the input, so the scatter step
+ * can run in parallel on the job system without any synchronization between slices.
+ * Passes where all keys share the same digit are skipped.
+ */
+template<usize KeyBits = 64, typename Value, typename Allocator>
+requires (0 < KeyBits and KeyBits <= 64)
+inline void parallel_radix_sort(
+	std::vector<std::pair<u64, Value>, Allocator>& entries,
+	job_system& jobs = job_system::shared()
+) {
+	static constexpr usize digit_bits = 8;
+	static constexpr usize num_buckets = usize{ 1 } << digit_bits;
+	static constexpr usize num_passes = (KeyBits + digit_bits - 1) / digit_bits;
+	static constexpr usize min_entries_per_slice = 1 << 14;
+
+	const auto num_entries = entries.size();
+	if (num_entries < 2) {
+		return;
+	}
+
+	const auto num_slices = std::min(jobs.num_workers() + 1, num_entries / min_entries_per_slice + 1);
+
+	using entry_t = std::pair<u64, Value>;
+	// The buffer comes from the same allocator, so the two can be swapped at the end.
+	auto buffer = std::vector<entry_t, Allocator>(num_entries, entries.get_allocator());
+	auto src = entries.data(), dst = buffer.data();
+
+	std::vector<std::array<usize, num_buckets>> histograms(num_slices);
+
+	const auto run_sliced = [&](const auto& f) {
+		jobs.parallel_for(
+			num_slices, [&](const usize t) {
+				f(t, num_entries * t / num_slices, num_entries * (t + 1) / num_slices);
+			}
+		);
+	};
+
+	for (usize pass = 0; pass < num_passes; pass++) {
+		const auto shift = pass * digit_bits;
+
+		run_sliced(
+			[&](const usize t, const usize begin, const usize end) {
+				auto& histogram = histograms[t];
+				histogram.fill(0);
+				for (auto i = begin; i < end; i++) {
+					histogram[(src[i].first >> shift) & (num_buckets - 1)]++;
+				}
+			}
+		);
+
+		// Turn counts into scatter offsets, ordered by bucket and then by slice to keep the sort stable.
+		auto offset = usize{ 0 };
+		auto is_trivial = false;
+		for (usize bucket = 0; bucket < num_buckets; bucket++) {
+			const auto bucket_begin = offset;
+			for (auto& histogram : histograms) {
+				const auto count = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += count;
+			}
+			is_trivial |= offset - bucket_begin == num_entries;
+		}
+
+		if (is_trivial) {
+			continue;
+		}
+
+		run_sliced(
+			[&](const usize t, const usize begin, const usize end) {
+				auto& offsets = histograms[t];
+				for (auto i = begin; i < end; i++) {
+					dst[offsets[(src[i].first >> shift) & (num_buckets - 1)]++] = src[i];
+				}
+			}
+		);
+
+		std::swap(src, dst);
+	}
+
+	if (src != entries.data()) {
+		entries.swap(buffer);
+	}
+}
+
+} // namespace ztu
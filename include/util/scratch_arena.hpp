@@ -0,0 +1,153 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <numeric>
+#include <algorithm>
+#include <memory_resource>
+#include "util/uix.hpp"
+#include "util/memory_stats.hpp"
+
+
+namespace ztu {
+
+/**
+ * Per thread bump allocator for short lived loader buffers.
+ * Memory is only handed back when the 'scope' it was allocated in ends, which rewinds the arena.
+ * The blocks are kept for the next scope and merged into one once the outermost scope ends,
+ * so loading many similar files allocates (and page faults) only while loading the first one.
+ * Scopes nest, which is needed as waiting on the job system may run other loader jobs on the same thread.
+ */
+class scratch_arena : public std::pmr::memory_resource {
+public:
+	// Memory beyond this is freed when the outermost scope ends, so one huge file does not pin it forever.
+	static constexpr usize max_retained_bytes = usize{ 256 } << 20;
+	static constexpr usize min_block_size = usize{ 1 } << 20;
+
+	class scope {
+	public:
+		inline scope();
+
+		scope(const scope&) = delete;
+
+		scope& operator=(const scope&) = delete;
+
+		inline ~scope();
+
+		[[nodiscard]] inline std::pmr::memory_resource* resource() const;
+
+	private:
+		scratch_arena& m_arena;
+		usize m_block_index;
+		usize m_offset;
+	};
+
+	scratch_arena() = default;
+
+	scratch_arena(const scratch_arena&) = delete;
+
+	scratch_arena& operator=(const scratch_arena&) = delete;
+
+	[[nodiscard]] inline static scratch_arena& local();
+
+	[[nodiscard]] inline usize num_reserved_bytes() const;
+
+private:
+	struct block {
+		std::unique_ptr<std::byte[]> data;
+		usize size;
+	};
+
+	inline void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+	inline void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+
+	[[nodiscard]] inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	inline void consolidate();
+
+private:
+	std::vector<block> m_blocks;
+	usize m_block_index{ 0 };
+	usize m_offset{ 0 };
+	usize m_depth{ 0 };
+	memory_stats::counter m_memory{ memory_stats::category::loader_temporaries };
+};
+
+
+scratch_arena::scope::scope() :
+	m_arena{ local() },
+	m_block_index{ m_arena.m_block_index },
+	m_offset{ m_arena.m_offset } {
+	m_arena.m_depth++;
+}
+
+scratch_arena::scope::~scope() {
+	m_arena.m_block_index = m_block_index;
+	m_arena.m_offset = m_offset;
+	if (--m_arena.m_depth == 0) {
+		m_arena.consolidate();
+	}
+}
+
+std::pmr::memory_resource* scratch_arena::scope::resource() const {
+	return &m_arena;
+}
+
+scratch_arena& scratch_arena::local() {
+	thread_local scratch_arena arena;
+	return arena;
+}
+
+usize scratch_arena::num_reserved_bytes() const {
+	return m_memory.bytes();
+}
+
+void* scratch_arena::do_allocate(const std::size_t bytes, const std::size_t alignment) {
+	for (; m_block_index < m_blocks.size(); m_block_index++, m_offset = 0) {
+		auto& current = m_blocks[m_block_index];
+		const auto address = reinterpret_cast<usize>(current.data.get()) + m_offset;
+		const auto begin = (address + alignment - 1) / alignment * alignment - reinterpret_cast<usize>(current.data.get());
+		if (begin + bytes <= current.size) {
+			m_offset = begin + bytes;
+			return current.data.get() + begin;
+		}
+	}
+
+	// Blocks double in size, so growing buffers only need a few of them.
+	const auto size = std::max({ bytes + alignment, min_block_size, m_blocks.empty() ? 0 : 2 * m_blocks.back().size });
+	auto& current = m_blocks.emplace_back(std::make_unique_for_overwrite<std::byte[]>(size), size);
+	m_memory.set(m_memory.bytes() + size);
+
+	const auto address = reinterpret_cast<usize>(current.data.get());
+	const auto begin = (address + alignment - 1) / alignment * alignment - address;
+	m_offset = begin + bytes;
+	return current.data.get() + begin;
+}
+
+void scratch_arena::do_deallocate(void*, std::size_t, std::size_t) {
+	// Freed as a whole once the scope ends.
+}
+
+bool scratch_arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+void scratch_arena::consolidate() {
+	const auto total_size = std::accumulate(
+		m_blocks.begin(), m_blocks.end(), usize{ 0 }, [](const usize sum, const block& b) { return sum + b.size; }
+	);
+
+	if (m_blocks.size() > 1 or total_size > max_retained_bytes) {
+		m_blocks.clear();
+		const auto size = std::min(total_size, max_retained_bytes);
+		m_blocks.emplace_back(std::make_unique_for_overwrite<std::byte[]>(size), size);
+		m_memory.set(size);
+	}
+
+	m_block_index = 0;
+	m_offset = 0;
+}
+
+} // namespace ztu
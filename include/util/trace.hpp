@@ -0,0 +1,281 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <utility>
+#include <filesystem>
+#include <system_error>
+#include "util/uix.hpp"
+#include "util/buffered_writer.hpp"
+
+
+namespace ztu {
+
+/**
+ * Records zones, counters and thread names into per thread buffers and writes them as Chrome trace event JSON,
+ * which Perfetto and chrome://tracing open directly.
+ * Nothing is recorded until 'start' is called, until then a zone only costs a relaxed load.
+ * Details passed as strings are built by the caller either way, file names are only converted while recording.
+ * Zone and counter names are not copied, so they have to be string literals.
+ */
+class trace {
+public:
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * Marks the lifetime of the scope as a zone on the current thread.
+	 * The detail, for example a file name, is shown with the zone.
+	 */
+	class zone {
+	public:
+		explicit inline zone(const char* name);
+
+		inline zone(const char* name, std::string detail);
+
+		inline zone(const char* name, const std::filesystem::path& file);
+
+		zone(const zone&) = delete;
+
+		zone& operator=(const zone&) = delete;
+
+		inline ~zone();
+
+	private:
+		// Remembered, so stopping the trace inside a zone does not leave it unmatched.
+		bool m_recorded;
+	};
+
+	inline static void start();
+
+	inline static void stop();
+
+	[[nodiscard]] inline static bool enabled();
+
+	inline static void begin(const char* name, std::string detail = {});
+
+	inline static void end();
+
+	inline static void counter(const char* name, double value);
+
+	/**
+	 * Names the current thread in the trace, this is kept even while recording is stopped.
+	 */
+	inline static void set_thread_name(std::string name);
+
+	/**
+	 * Writes everything recorded so far, recording continues in the meantime.
+	 */
+	[[nodiscard]] inline static std::error_code write(const std::filesystem::path& filename);
+
+private:
+	enum class event_type : u8 {
+		begin,
+		end,
+		counter
+	};
+
+	struct event {
+		event_type type;
+		const char* name;
+		clock::duration timestamp;
+		double value;
+		std::string detail;
+	};
+
+	struct thread_buffer {
+		std::mutex mutex;
+		usize id;
+		std::string name;
+		std::vector<event> events;
+	};
+
+	[[nodiscard]] inline static thread_buffer& local();
+
+	inline static void record(event_type type, const char* name, double value, std::string detail);
+
+	inline static void write_escaped(buffered_writer& out, const std::string& str);
+
+	inline static std::atomic<bool> s_enabled{ false };
+	inline static const clock::time_point s_epoch{ clock::now() };
+	inline static std::mutex s_buffers_mutex;
+	// Shared, so the events of threads that already exited are still written.
+	inline static std::vector<std::shared_ptr<thread_buffer>> s_buffers;
+};
+
+
+trace::zone::zone(const char* name) : m_recorded{ enabled() } {
+	if (m_recorded) {
+		record(event_type::begin, name, 0.0, {});
+	}
+}
+
+trace::zone::zone(const char* name, std::string detail) : m_recorded{ enabled() } {
+	if (m_recorded) {
+		record(event_type::begin, name, 0.0, std::move(detail));
+	}
+}
+
+trace::zone::zone(const char* name, const std::filesystem::path& file) : m_recorded{ enabled() } {
+	if (m_recorded) {
+		record(event_type::begin, name, 0.0, file.string());
+	}
+}
+
+trace::zone::~zone() {
+	if (m_recorded) {
+		record(event_type::end, nullptr, 0.0, {});
+	}
+}
+
+
+void trace::start() {
+	s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void trace::stop() {
+	s_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool trace::enabled() {
+	return s_enabled.load(std::memory_order_relaxed);
+}
+
+void trace::begin(const char* name, std::string detail) {
+	if (enabled()) {
+		record(event_type::begin, name, 0.0, std::move(detail));
+	}
+}
+
+void trace::end() {
+	if (enabled()) {
+		record(event_type::end, nullptr, 0.0, {});
+	}
+}
+
+void trace::counter(const char* name, const double value) {
+	if (enabled()) {
+		record(event_type::counter, name, value, {});
+	}
+}
+
+void trace::set_thread_name(std::string name) {
+	auto& buffer = local();
+	std::lock_guard lock(buffer.mutex);
+	buffer.name = std::move(name);
+}
+
+trace::thread_buffer& trace::local() {
+	thread_local const auto buffer = []() {
+		auto new_buffer = std::make_shared<thread_buffer>();
+		std::lock_guard lock(s_buffers_mutex);
+		new_buffer->id = s_buffers.size() + 1;
+		s_buffers.push_back(new_buffer);
+		return new_buffer;
+	}();
+	return *buffer;
+}
+
+void trace::record(const event_type type, const char* name, const double value, std::string detail) {
+	const auto timestamp = clock::now() - s_epoch;
+	auto& buffer = local();
+	// Only contended while the trace is written.
+	std::lock_guard lock(buffer.mutex);
+	buffer.events.emplace_back(type, name, timestamp, value, std::move(detail));
+}
+
+void trace::write_escaped(buffered_writer& out, const std::string& str) {
+	for (const auto c : str) {
+		if (c == '"' or c == '\\') {
+			out.write('\\');
+			out.write(c);
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+			out.write(escaped, 6);
+		} else {
+			out.write(c);
+		}
+	}
+}
+
+std::error_code trace::write(const std::filesystem::path& filename) {
+	buffered_writer out;
+	if (const auto e = buffered_writer::open(filename, out); e) {
+		return e;
+	}
+
+	std::vector<std::shared_ptr<thread_buffer>> buffers;
+	{
+		std::lock_guard lock(s_buffers_mutex);
+		buffers = s_buffers;
+	}
+
+	const auto write_str = [&](const std::string_view& str) {
+		out.write(str.data(), str.size());
+	};
+
+	char line[256];
+	auto separator = "\n";
+
+	write_str("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	for (const auto& buffer : buffers) {
+		std::lock_guard lock(buffer->mutex);
+
+		if (not buffer->name.empty()) {
+			const auto length = std::snprintf(
+				line, sizeof(line), "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"name\":\"thread_name\",\"args\":{\"name\":\"",
+				separator, buffer->id
+			);
+			out.write(line, length);
+			write_escaped(out, buffer->name);
+			write_str("\"}}");
+			separator = ",\n";
+		}
+
+		for (const auto& current : buffer->events) {
+			const auto microseconds = std::chrono::duration<double, std::micro>(current.timestamp).count();
+			auto length = 0;
+			switch (current.type) {
+			case event_type::begin:
+				length = std::snprintf(
+					line, sizeof(line), "%s{\"ph\":\"B\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"name\":\"%s\"",
+					separator, buffer->id, microseconds, current.name
+				);
+				break;
+			case event_type::end:
+				length = std::snprintf(
+					line, sizeof(line), "%s{\"ph\":\"E\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f",
+					separator, buffer->id, microseconds
+				);
+				break;
+			case event_type::counter:
+				length = std::snprintf(
+					line, sizeof(line), "%s{\"ph\":\"C\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"name\":\"%s\",\"args\":{\"value\":%.17g}",
+					separator, buffer->id, microseconds, current.name, current.value
+				);
+				break;
+			}
+			out.write(line, std::min(static_cast<usize>(length), sizeof(line) - 1));
+
+			if (not current.detail.empty()) {
+				write_str(",\"args\":{\"detail\":\"");
+				write_escaped(out, current.detail);
+				write_str("\"}");
+			}
+			write_str("}");
+			separator = ",\n";
+		}
+	}
+
+	write_str("\n]}\n");
+
+	return out.close();
+}
+
+} // namespace ztu
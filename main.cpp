@@ -6,31 +6,36 @@
 #include <SFML/Graphics/RectangleShape.hpp>
 
 #include <cmath>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "geometry/mesh_loader.hpp"
-#include "geometry/mesh.hpp"
-
-#include <geometry/point_cloud.hpp>
-
-#include <graphics/renderable_attributes.hpp>
 #include <graphics/flying_camera.hpp>
+#include <graphics/camera_path.hpp>
 
 #include <util/arx.hpp>
-#include <geometry/point_cloud_loader.hpp>
 
 #include "graphics/renderers/mesh_renderer.hpp"
 #include "graphics/renderers/mesh_line_renderer.hpp"
 #include "graphics/renderers/mesh_point_renderer.hpp"
 #include "graphics/renderers/point_cloud_renderer.hpp"
 #include <util/extra_arx_parsers.hpp>
-
-
-using default_mesh = mesh<vertex_components::tex_coord, vertex_components::normal>;
+#include <util/job_system.hpp>
+#include <util/memory_stats.hpp>
+#include "graphics/upload_scheduler.hpp"
+#include "graphics/scene.hpp"
+#include "graphics/shader_program.hpp"
+#include "graphics/gpu_timer.hpp"
+#include "graphics/frame_latency.hpp"
+#include "graphics/accumulation_buffer.hpp"
+#include "graphics/point_budget.hpp"
+#include "graphics/perf_hud.hpp"
+#include <util/perf_stats.hpp>
+#include <util/frame_pacer.hpp>
+#include <util/trace.hpp>
 
 using my_arx = ztu::arx<
 	ztu::arx_flag<'f', "fullscreen">,
@@ -40,21 +45,62 @@ using my_arx = ztu::arx<
 	ztu::arx_flag<'\0', "fps", unsigned int>,
 	ztu::arx_flag<'\0', "spawn", glm::vec3, &extra_arx_parsers::glm_vec<3, float, glm::highp>>,
 	ztu::arx_flag<'s', "size", glm::vec3, &extra_arx_parsers::glm_vec<3, float, glm::highp>>,
-	ztu::arx_flag<'p', "pedantic">
+	ztu::arx_flag<'p', "pedantic">,
+	ztu::arx_flag<'\0', "upload-budget", unsigned int>,
+	ztu::arx_flag<'\0', "upload-time", float>,
+	ztu::arx_flag<'\0', "keep-geometry">,
+	ztu::arx_flag<'\0', "shader-cache", std::string>,
+	ztu::arx_flag<'\0', "trace", std::string>,
+	ztu::arx_flag<'\0', "record-path", std::string>,
+	ztu::arx_flag<'\0', "on-demand">,
+	ztu::arx_flag<'\0', "frame-times", std::string>,
+	ztu::arx_flag<'\0', "low-latency">,
+	ztu::arx_flag<'\0', "frames-in-flight", unsigned int>,
+	ztu::arx_flag<'\0', "progressive", unsigned int>,
+	ztu::arx_flag<'\0', "point-budget", ztu::usize, &extra_arx_parsers::count<ztu::usize>>
 >;
 
 int main(int num_args, char* args[]) {
 
+	// Loaders log from worker threads, so lines are written by a background thread.
+	logger::enable_async();
+
 	//----------------------[ Argument Parsing ]----------------------//
 
 	my_arx arguments(num_args, args);
 
+	// Written on exit and on F4, the file opens in Perfetto or chrome://tracing.
+	const auto trace_file = arguments.get<"trace">();
+	ztu::trace::set_thread_name("main");
+	if (trace_file) {
+		ztu::trace::start();
+	}
+
 	const auto fullscreen = arguments.get<"fullscreen">().value();
 	const auto pedantic_enabled = arguments.get<"pedantic">().value();
+	// Otherwise the CPU copies of the geometry are dropped once uploaded and fetched again from their files on demand.
+	const auto keep_geometry = arguments.get<"keep-geometry">().value();
 	const auto vsync_enabled = arguments.get<"vsync">().value();
 	const auto fps = arguments.get<"fps">().value_or(60);
+	// Frames are only drawn when something changed, otherwise the viewer waits for the next event.
+	const auto on_demand = arguments.get<"on-demand">().value();
+	// Limits how many frames the driver may queue ahead, so input is shown sooner. Zero means no limit.
+	const auto frames_in_flight = arguments.get<"frames-in-flight">().value_or(
+		arguments.get<"low-latency">().value() ? 1 : 0
+	);
+	// Number of slices points are split into, while the view is still every frame adds one of them to the image.
+	const auto progressive_slices = arguments.get<"progressive">().value_or(0);
+	// Upper bound of the points drawn per frame, the actual number adapts to hold the frame rate.
+	const auto max_points = arguments.get<"point-budget">();
 	const auto spawn = arguments.get<"spawn">().value_or(glm::vec3{ 0, 0, 0 });
 	const auto outer_box = arguments.get<"size">().value_or(glm::vec3{ 100, 100, 100 });
+	// At most this many MiB or milliseconds are spent on GPU uploads per frame.
+	const auto upload_budget = upload_scheduler::budget{
+		.max_bytes = ztu::usize{ arguments.get<"upload-budget">().value_or(64) } << 20,
+		.max_time = std::chrono::microseconds(
+			static_cast<ztu::i64>(1000.0f * arguments.get<"upload-time">().value_or(4.0f))
+		)
+	};
 
 	constexpr auto title = "3D-Viewer";
 
@@ -70,6 +116,8 @@ int main(int num_args, char* args[]) {
 		return -1;
 	}
 
+	shader_program::enable_parallel_compile();
+
 	sf::RectangleShape bar_background, bar_foreground;
 
 	sf::Font font{};
@@ -148,6 +196,17 @@ int main(int num_args, char* args[]) {
 
 	const auto shader_dir = std::filesystem::path{ "../shaders" };
 
+	// Linked programs are kept between runs, an empty path disables the cache.
+	auto shader_cache_dir = fs::temp_directory_path() / "3d_viewer" / "shaders";
+	if (const auto dir = arguments.get<"shader-cache">(); dir) {
+		shader_cache_dir = *dir;
+	} else if (const auto cache_home = std::getenv("XDG_CACHE_HOME"); cache_home and *cache_home) {
+		shader_cache_dir = fs::path{ cache_home } / "3d_viewer" / "shaders";
+	} else if (const auto home = std::getenv("HOME"); home and *home) {
+		shader_cache_dir = fs::path{ home } / ".cache" / "3d_viewer" / "shaders";
+	}
+	const auto shader_cache = program_binary_cache(shader_cache_dir);
+
 	const auto shader_files = std::array{
 		std::array{ fs::path{ "mesh_vertex.glsl" }, fs::path{ "" }, fs::path{ "mesh_fragment.glsl" } },
 		std::array{ fs::path{ "mesh_line_vertex.glsl" }, fs::path{ "" }, fs::path{ "mesh_line_fragment.glsl" } },
@@ -157,15 +216,26 @@ int main(int num_args, char* args[]) {
 	using shader_tpl_t = std::tuple<shaders::meshes, shaders::mesh_lines, shaders::mesh_points, shaders::points>;
 	shader_tpl_t shader_tpl;
 
+	// All programs are handed to the driver before the first status query, so they compile in parallel.
+	std::array<pending_program, std::tuple_size_v<shader_tpl_t>> pending_programs;
+
 	ztu::for_each::index<std::tuple_size_v<shader_tpl_t>>(
 		[&]<auto Index>() {
 			const auto& [vertex_file, geometry_file, fragment_file] = shader_files[Index];
+			using shader_t = std::tuple_element_t<Index, shader_tpl_t>;
+			pending_programs[Index] = shader_t::begin_from_files(
+				shader_dir / vertex_file, shader_dir / geometry_file, shader_dir / fragment_file, &shader_cache
+			);
+			return false;
+		}
+	);
+
+	ztu::for_each::index<std::tuple_size_v<shader_tpl_t>>(
+		[&]<auto Index>() {
 			using shader_t = std::tuple_element_t<Index, shader_tpl_t>;
 			shader_t& shader = std::get<Index>(shader_tpl);
-			if (shader_t::from_files(
-				shader_dir / vertex_file, shader_dir / geometry_file, shader_dir / fragment_file, shader
-			)) {
-				error<"Failed loading shader %">(vertex_file);
+			if (shader.finish(pending_programs[Index], &shader_cache)) {
+				error<"Failed loading shader %">(shader_files[Index][0]);
 				exit(-1);
 			}
 			return false;
@@ -180,91 +250,18 @@ int main(int num_args, char* args[]) {
 
 	//----------------------[ Asset loading ]----------------------//
 
-	std::vector<default_mesh> meshes;
-	std::unordered_map<std::string, std::shared_ptr<material>> materials;
-
-	std::vector<basic_point_cloud> basic_point_clouds;
-	std::vector<reflectance_point_cloud> reflectance_point_clouds;
+	// Loader jobs hand their CPU side assets to the render loop, which uploads them as they arrive.
+	scene assets({ .pedantic = pedantic_enabled, .keep_geometry = keep_geometry, .outer_box = outer_box });
 
+	std::vector<fs::path> inputs;
 	for (ztu::isize i = 0; i < arguments.num_positional(); i++) {
-		auto path = fs::path{ arguments.get(i).value() };
-
-		const auto progress = 0.2f + 0.4f * (
-			static_cast<float>(i) / static_cast<float>(arguments.num_positional())
-		);
-		auto progress_title = std::string("Loading: ") + path.c_str();
-
-		if (fs::is_directory(path)) {
-			progress_title += " (3dtk)";
-			set_progress(progress, progress_title.c_str());
-			if (const auto e = point_cloud_loader::load_from_3dtk_directory(
-					path, basic_point_clouds, reflectance_point_clouds
-				); e) {
-				warn<"Cannot parse directory %: %">(path, e.message());
-			}
-		} else if (path.extension() == ".c3d") {
-			progress_title += " (compact 3dtk)";
-			set_progress(progress, progress_title.c_str());
-			std::vector<typename reflectance_point_cloud::vertex_t> points;
-			if (const auto e = point_cloud_loader::load_v1_c3d_file(path, points); e) {
-				warn<"Cannot read from %: %">(path, e.message());
-			}
-			reflectance_point_clouds.emplace_back(std::move(points));
-		} else if (path.extension() == ".obj") {
-			progress_title += " (Wavefront OBJ)";
-			set_progress(progress, progress_title.c_str());
-			if (const auto e = mesh_loader::load_from_obj(path, meshes, materials, pedantic_enabled); e) {
-				info<"Cannot parse obj %: %">(path, e.message());
-			}
-		} else {
-			warn<"Skipping %">(path);
-			progress_title += " Skipped";
-			set_progress(progress, progress_title.c_str());
-		}
-	}
-
-	set_progress(0.6f, "Calculating model size");
-
-	aabb model_box;
-	ztu::u64 num_points = 0;
-	for (const auto& point_cloud : basic_point_clouds) {
-		model_box.join(point_cloud.calc_bounding_box());
-		num_points += point_cloud.points().size();
+		inputs.emplace_back(arguments.get(i).value());
 	}
-	for (const auto& point_cloud : reflectance_point_clouds) {
-		model_box.join(point_cloud.calc_bounding_box());
-		num_points += point_cloud.points().size();
-	}
-	debug<"num m_points: %">(num_points);
-
-	ztu::u64 num_vertices = 0;
-	for (const auto& mesh : meshes) {
-		model_box.join(mesh.calc_bounding_box());
-		num_vertices += mesh.vertex_buffer().size();
-	}
-
-	debug<"num m_vertices: %">(num_vertices);
-
-	const auto model_size = model_box.size();
-	debug<"model size: % % %">(model_size.x, model_size.y, model_size.z);
-
-
-	const auto model_scale = std::min(
-		{
-			std::abs(model_size.x) < glm::epsilon<float>() ? 1 : (outer_box.x / model_size.x),
-			std::abs(model_size.y) < glm::epsilon<float>() ? 1 : (outer_box.y / model_size.y),
-			std::abs(model_size.z) < glm::epsilon<float>() ? 1 : (outer_box.z / model_size.z),
-		}
-	);
-
-	const auto transform = glm::scale(
-		glm::identity<glm::mat4x4>(),
-		{ model_scale, model_scale, model_scale }
-	);
+	assets.load(inputs);
 
 	//----------------------[ Final OpenGL Context Initialization ]----------------------//
 
-	set_progress(0.65f, "Initializing OpenGL");
+	set_progress(0.5f, "Initializing OpenGL");
 
 	if (fullscreen) {
 		window.create(sf::VideoMode(), title, sf::Style::Fullscreen, sf::ContextSettings(24, 8, 2, 4, 6));
@@ -301,61 +298,30 @@ int main(int num_args, char* args[]) {
 	window.setVerticalSyncEnabled(vsync_enabled);
 	window.setActive(true);
 
-	//----------------------[ OpenGL Buffer Initialization ]----------------------//
-
-	set_progress(0.7f, "Creating mesh instances");
+	//----------------------[ Asset streaming ]----------------------//
 
-	std::vector<mesh_instance> mesh_instances;
-	mesh_instances.reserve(meshes.size());
+	std::string loading_title;
 
-	auto fallback_color_attr = std::make_shared<renderable_attributes::color>(glm::vec4(1, 0, 1, 1));
-	auto fallback_point_size_attr = std::make_shared<renderable_attributes::point_size>(3.0f);
+	const auto stream_assets = [&]() {
+		if (assets.loaded()) {
+			return;
+		}
 
-	for (auto& mesh : meshes) {
-		mesh.init_vao();
-		mesh_instances.push_back(mesh.create_instance(transform).value());
-		bool found_color_attr = false;
-		for (auto& attribute : mesh_instances.back().attributes) {
-			if (attribute.index() == 0) {
-				std::get<0>(attribute.attributes) = fallback_color_attr;
-				found_color_attr = true;
+		if (assets.stream(upload_budget)) {
+			window.setTitle(title);
+		} else {
+			const auto num_inputs = assets.num_inputs();
+			auto new_title = (
+				std::string(title) + " - Loading " +
+					std::to_string(num_inputs - assets.num_inputs_left()) + "/" + std::to_string(num_inputs) + ", " +
+					std::to_string(assets.num_pending_upload_bytes() >> 20) + " MiB to upload"
+			);
+			if (new_title != loading_title) {
+				loading_title = std::move(new_title);
+				window.setTitle(loading_title);
 			}
 		}
-		if (not found_color_attr) {
-			mesh_instances.back().attributes.emplace_back(fallback_color_attr);
-		}
-		mesh_instances.back().attributes.emplace_back(fallback_point_size_attr);
-	}
-
-	set_progress(0.8f, "Creating point cloud instances");
-	std::vector<point_cloud_instance> point_cloud_instances;
-	point_cloud_instances.reserve(basic_point_clouds.size() + reflectance_point_clouds.size());
-
-	for (auto& point_cloud : basic_point_clouds) {
-		point_cloud.init_vao();
-		point_cloud_instances.push_back(
-			point_cloud.create_instance(transform).value()
-		);
-		point_cloud_instances.back().attributes.emplace_back(fallback_point_size_attr);
-	}
-
-	for (auto& point_cloud : reflectance_point_clouds) {
-		point_cloud.init_vao();
-		point_cloud_instances.push_back(
-			point_cloud.create_instance(transform).value()
-		);
-		point_cloud_instances.back().attributes.emplace_back(fallback_point_size_attr);
-	}
-
-	std::array<std::shared_ptr<renderable_attributes::color>, 20> colors{};
-	for (auto& attr_ptr : colors) {
-		attr_ptr = std::make_shared<renderable_attributes::color>(rgba_colors::random());
-	}
-
-	for (auto i = 0; i < static_cast<ztu::isize>(point_cloud_instances.size()); i++) {
-		point_cloud_instances[i].attributes.emplace_back(colors[i % 3]);
-	}
-
+	};
 
 	set_progress(1.0f, "Initialization complete");
 
@@ -379,7 +345,16 @@ int main(int num_args, char* args[]) {
 	flying_camera player(spawn, { 0, 0, 1 }, { 0, 1, 0 });
 
 	const auto frame_time = std::chrono::microseconds(int(1000000.0f / static_cast<float>(fps)));
-	const auto dt = static_cast<float>(frame_time.count()) / 1000.f;
+	const auto frame_time_ms = static_cast<float>(frame_time.count()) / 1000.f;
+	auto pacer = ztu::frame_pacer(frame_time);
+
+	// Every camera update is recorded, so '3d_render_bench' can replay the exact same flight.
+	// Paths are replayed with a fixed time step, so while recording the camera also uses it.
+	const auto record_path_file = arguments.get<"record-path">();
+	auto recorded_path = camera_path{ .delta_time = frame_time_ms, .spawn = spawn };
+
+	// Time in milliseconds the camera moves by on the next update, measured by the pacer.
+	auto dt = frame_time_ms;
 
 	bool running = true;
 	bool lockMouse = true;
@@ -398,57 +373,247 @@ int main(int num_args, char* args[]) {
 
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+	// Holds the image that is refined while the view is still, moving only shows the first slice.
+	accumulation_buffer accumulation;
+	auto progressive = progressive_slices != 0;
+	auto num_refined_slices = ztu::u32{ 0 };
+	if (progressive) {
+		m_point_cloud_renderer.enable_slices(progressive_slices);
+		if (const auto e = accumulation_buffer::create(width, height, accumulation); e) {
+			warn<"Progressive refinement disabled: %">(e.message());
+			progressive = false;
+		}
+	}
+
+	// The points share most of the frame with the meshes, the rest is left for the CPU, the overlay and presenting.
+	auto points = std::optional<point_budget>();
+	if (max_points) {
+		if (progressive) {
+			warn<"The point budget is ignored, progressive refinement draws its own slices">();
+		} else {
+			points.emplace(*max_points, 0.8f * frame_time_ms);
+		}
+	}
+
+	const auto write_trace = [&]() {
+		if (not trace_file) {
+			return;
+		}
+		if (const auto e = ztu::trace::write(*trace_file); e) {
+			warn<"Could not write trace %: %">(*trace_file, e.message());
+		} else {
+			info<"Wrote trace %">(*trace_file);
+		}
+	};
+
+	ztu::perf_stats timings;
+	auto& frame_timings = timings.get("frame");
+	auto& event_timings = timings.get("events");
+	auto& stream_timings = timings.get("streaming");
+	auto& mesh_timings = timings.get("mesh pass");
+	auto& point_timings = timings.get("point pass");
+	auto& display_timings = timings.get("display");
+	auto& interval_timings = timings.get("interval");
+	auto& latency_timings = timings.get("input latency");
+
+	gpu_timer mesh_gpu_timer(mesh_timings.gpu), point_gpu_timer(point_timings.gpu);
+	frame_latency latency(latency_timings.cpu, frames_in_flight);
+
+	perf_hud hud(font);
+
 	//----------------------[ Game Loop ]----------------------//
 
-	while (running) {
-		const auto start = std::chrono::high_resolution_clock::now();
+	// Set by everything that changes the next frame, only used in on demand mode.
+	auto frame_invalid = true;
+
+	const auto handle_event = [&](const sf::Event& event) {
+		// A free cursor does not affect the scene.
+		frame_invalid |= event.type != sf::Event::MouseMoved or lockMouse;
+
+		if (event.type == sf::Event::Closed) {
+			running = false;
+		} else if (event.type == sf::Event::Resized) {
+			glViewport(0, 0, event.size.width, event.size.height);
+			width = event.size.width;
+			height = event.size.height;
+			update_proj_mat();
+			if (progressive) {
+				if (const auto e = accumulation_buffer::create(width, height, accumulation); e) {
+					warn<"Progressive refinement disabled: %">(e.message());
+					progressive = false;
+				}
+			}
+		} else if (event.type == sf::Event::MouseWheelMoved) {
+			scale = std::max(scale * (1.0f + 0.1f * event.mouseWheel.delta), 1.f);
+			update_proj_mat();
+		} else if (event.type == sf::Event::KeyPressed) {
+			switch (event.key.code) {
+			case sf::Keyboard::Escape:
+				running = false;
+				break;
+			case sf::Keyboard::Tab:
+				window.setMouseCursorVisible(!(lockMouse ^= 1));
+				break;
+			case sf::Keyboard::F3:
+				hud.toggle();
+				break;
+			case sf::Keyboard::F4:
+				write_trace();
+				break;
+			case sf::Keyboard::M:
+				assets.log_asset_memory();
+				ztu::memory_stats::log_report<logger::level::INFO>();
+				break;
+				//case sf::Keyboard::T: renderIndex = (renderIndex + 1) % renderers.size(); break;
+			default:
+				break;
+			}
+		}
+	};
 
+	while (running) {
 		sf::Event event;
-		while (window.pollEvent(event)) {
-			if (event.type == sf::Event::Closed) {
-				running = false;
-			} else if (event.type == sf::Event::Resized) {
-				glViewport(0, 0, event.size.width, event.size.height);
-				width = event.size.width;
-				height = event.size.height;
-				update_proj_mat();
-			} else if (event.type == sf::Event::MouseWheelMoved) {
-				scale = std::max(scale * (1.0f + 0.1f * event.mouseWheel.delta), 1.f);
-				update_proj_mat();
-			} else if (event.type == sf::Event::KeyPressed) {
-				switch (event.key.code) {
-				case sf::Keyboard::Escape:
-					running = false;
-					break;
-				case sf::Keyboard::Tab:
-					window.setMouseCursorVisible(!(lockMouse ^= 1));
-					break;
-					//case sf::Keyboard::T: renderIndex = (renderIndex + 1) % renderers.size(); break;
-				default:
-					break;
-				}
+
+		// The frame on screen is still up-to-date, so nothing is drawn until an event changes that.
+		// Loading and a visible overlay change every frame, as does a camera that is still drifting or a refining image.
+		const auto refined = not progressive or num_refined_slices == m_point_cloud_renderer.num_slices();
+		if (on_demand and not frame_invalid and assets.loaded() and not hud.visible() and player.at_rest() and refined) {
+			const auto idle_zone = ztu::trace::zone("idle");
+			// Frames finishing during the wait would otherwise count it as latency.
+			latency.finish();
+			if (window.waitEvent(event)) {
+				handle_event(event);
 			}
+			pacer.restart();
+			dt = frame_time_ms;
+		}
+
+		const auto frame_zone = ztu::trace::zone("frame");
+		auto frame_scope = std::optional<ztu::perf_stats::cpu_scope>(frame_timings);
+		auto event_scope = std::optional<ztu::perf_stats::cpu_scope>(event_timings);
+
+		while (window.pollEvent(event)) {
+			handle_event(event);
+		}
+
+		event_scope.reset();
+
+		if (not running) {
+			break;
+		}
+
+		//renderers[renderIndex]->render(renderables, proj_mat, player.view_matrix());
+		{
+			const auto scope = ztu::perf_stats::cpu_scope(stream_timings);
+			stream_assets();
+		}
+
+		if (ztu::trace::enabled()) {
+			ztu::trace::counter("upload MiB pending", static_cast<double>(assets.num_pending_upload_bytes() >> 20));
+			ztu::trace::counter("memory MiB", static_cast<double>(ztu::memory_stats::current().total_bytes >> 20));
 		}
 
+		{
+			const auto zone = ztu::trace::zone("frames in flight");
+			latency.wait();
+		}
+
+		// Input is sampled as late as possible, right before the view matrix is needed.
+		latency.input_sampled();
 		if (lockMouse) [[likely]] {
 			const int middleX = width / 2;
 			const int middleY = height / 2;
 			const auto mouseDelta = sf::Mouse::getPosition(window);
-			sf::Mouse::setPosition({ middleX, middleY }, window);
-			player.update(dt, mouseDelta.x - middleX, mouseDelta.y - middleY);
+			// Only moved back when needed, as moving the cursor generates another event.
+			if (mouseDelta.x != middleX or mouseDelta.y != middleY) {
+				sf::Mouse::setPosition({ middleX, middleY }, window);
+			}
+			const auto input = flying_camera::poll_input(mouseDelta.x - middleX, mouseDelta.y - middleY);
+			if (record_path_file) {
+				recorded_path.inputs.push_back(input);
+			}
+			player.update(dt, input);
+			frame_invalid |= not input.empty();
 		}
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		const auto view_matrix = player.view_matrix() * assets.model_transform();
 
-		//renderers[renderIndex]->render(renderables, proj_mat, player.view_matrix());
-		m_mesh_renderer.render(mesh_instances, proj_mat, player.view_matrix());
-		m_point_cloud_renderer.render(point_cloud_instances, proj_mat, player.view_matrix());
+		if (progressive) {
+			// Anything that changes the image starts the refinement over.
+			if (frame_invalid or not assets.loaded() or not player.at_rest()) {
+				num_refined_slices = 0;
+			}
+			accumulation.bind();
+		}
 
-		window.display();
+		if (not progressive or num_refined_slices == 0) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			const auto scope = ztu::perf_stats::cpu_scope(mesh_timings);
+			const auto gpu_scope = gpu_timer::scope(mesh_gpu_timer);
+			m_mesh_renderer.render(assets.mesh_instances(), proj_mat, view_matrix);
+		}
+		if (points) {
+			const auto scope = ztu::perf_stats::cpu_scope(point_timings);
+			const auto gpu_scope = gpu_timer::scope(point_gpu_timer);
+			const auto num_drawn = m_point_cloud_renderer.render_budget(
+				assets.point_cloud_instances(), proj_mat, view_matrix, points->points()
+			);
+			// GPU times are read a few frames late, the budget smooths over that.
+			points->update(num_drawn, point_timings.gpu.last(), mesh_timings.gpu.last());
+			if (ztu::trace::enabled()) {
+				ztu::trace::counter("points drawn", static_cast<double>(num_drawn));
+				ztu::trace::counter("point budget", static_cast<double>(points->points()));
+			}
+		} else if (not progressive) {
+			const auto scope = ztu::perf_stats::cpu_scope(point_timings);
+			const auto gpu_scope = gpu_timer::scope(point_gpu_timer);
+			m_point_cloud_renderer.render(assets.point_cloud_instances(), proj_mat, view_matrix);
+		} else if (num_refined_slices != m_point_cloud_renderer.num_slices()) {
+			const auto scope = ztu::perf_stats::cpu_scope(point_timings);
+			const auto gpu_scope = gpu_timer::scope(point_gpu_timer);
+			m_point_cloud_renderer.render_slices(
+				assets.point_cloud_instances(), proj_mat, view_matrix, num_refined_slices++, 1
+			);
+		}
+
+		if (progressive) {
+			accumulation.present();
+		}
+
+		hud.draw(window, timings);
+
+		{
+			const auto scope = ztu::perf_stats::cpu_scope(display_timings);
+			window.display();
+		}
+		latency.frame_submitted();
 
-		const auto finish = std::chrono::high_resolution_clock::now();
-		std::this_thread::sleep_for(frame_time - (finish - start));
+		frame_invalid = false;
+
+		// The wait below is not part of the frame's work.
+		frame_scope.reset();
+
+		const auto elapsed = std::chrono::duration<float, std::milli>(pacer.wait()).count();
+		interval_timings.cpu.add(elapsed);
+		if (not record_path_file) {
+			// A stall must not throw the camera across the scene.
+			dt = std::min(elapsed, 4.0f * frame_time_ms);
+		}
+	}
+
+	timings.log_report<logger::level::DBG>();
+	pacer.log_report<logger::level::INFO>();
+	if (const auto frame_times_file = arguments.get<"frame-times">(); frame_times_file) {
+		if (const auto e = pacer.intervals().write_csv(*frame_times_file); e) {
+			warn<"Could not write frame times %: %">(*frame_times_file, e.message());
+		}
+	}
+	if (record_path_file) {
+		if (const auto e = recorded_path.save(*record_path_file); e) {
+			warn<"Could not write camera path %: %">(*record_path_file, e.message());
+		}
 	}
+	write_trace();
 
 	return 0;
 }
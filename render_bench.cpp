@@ -0,0 +1,265 @@
+#include <GL/glew.h>
+
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <numbers>
+#include <filesystem>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <util/arx.hpp>
+#include <util/logger.hpp>
+#include <util/perf_stats.hpp>
+#include <util/extra_arx_parsers.hpp>
+#include "graphics/scene.hpp"
+#include "graphics/shaders.hpp"
+#include "graphics/gpu_timer.hpp"
+#include "graphics/camera_path.hpp"
+#include "graphics/flying_camera.hpp"
+#include "graphics/headless_context.hpp"
+#include "graphics/renderers/mesh_renderer.hpp"
+#include "graphics/renderers/point_cloud_renderer.hpp"
+
+
+using bench_arx = ztu::arx<
+	ztu::arx_flag<'c', "camera-path", std::string>,
+	ztu::arx_flag<'n', "frames", unsigned int>,
+	ztu::arx_flag<'\0', "warmup", unsigned int>,
+	ztu::arx_flag<'\0', "width", unsigned int>,
+	ztu::arx_flag<'\0', "height", unsigned int>,
+	ztu::arx_flag<'\0', "shaders", std::string>,
+	ztu::arx_flag<'s', "size", glm::vec3, &extra_arx_parsers::glm_vec<3, float, glm::highp>>,
+	ztu::arx_flag<'p', "pedantic">,
+	ztu::arx_flag<'o', "output", std::string>
+>;
+
+struct frame_timing {
+	float cpu_ms;
+	float mesh_gpu_ms;
+	float point_gpu_ms;
+};
+
+std::string escape_json(const std::string& str) {
+	std::string escaped;
+	for (const auto c : str) {
+		if (c == '"' or c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		} else if (static_cast<unsigned char>(c) >= 0x20) {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+void write_summary(std::ostream& out, const char* name, std::vector<float> values) {
+	const auto summary = ztu::perf_stats::summarize(values);
+	out << "\"" << name << "\":{"
+		<< "\"average_ms\":" << summary.average_ms << ","
+		<< "\"p50_ms\":" << summary.p50_ms << ","
+		<< "\"p95_ms\":" << summary.p95_ms << ","
+		<< "\"p99_ms\":" << summary.p99_ms << ","
+		<< "\"max_ms\":" << summary.max_ms << "}";
+}
+
+int main(int num_args, char* args[]) {
+
+	//----------------------[ Argument Parsing ]----------------------//
+
+	bench_arx arguments(num_args, args);
+
+	if (arguments.num_positional() == 0) {
+		error<
+			"Usage: % [-c <camera path>] [-n <frames>] [--warmup <frames>] [--width <px>] [--height <px>] "
+			"[--shaders <directory>] [-o <output.json>] <3dtk directory | .obj | .cobj | .c3d>..."
+		>(args[0]);
+		return -1;
+	}
+
+	auto path = camera_path{};
+	const auto path_file = arguments.get<"camera-path">();
+	if (path_file) {
+		if (const auto e = camera_path::load(*path_file, path); e) {
+			error<"Could not read camera path %: %">(*path_file, e.message());
+			return -1;
+		}
+	}
+
+	// Without a path the camera stays at the spawn.
+	const auto num_frames = arguments.get<"frames">().value_or(
+		path.inputs.empty() ? 300 : static_cast<unsigned int>(path.inputs.size())
+	);
+	const auto num_warmup_frames = arguments.get<"warmup">().value_or(10);
+	const auto width = arguments.get<"width">().value_or(1280);
+	const auto height = arguments.get<"height">().value_or(720);
+	const auto shader_dir = std::filesystem::path{ arguments.get<"shaders">().value_or("../shaders") };
+	const auto output_file = arguments.get<"output">();
+
+	//----------------------[ Context Setup ]----------------------//
+
+	headless_context context;
+	if (const auto e = headless_context::create(width, height, context); e) {
+		return -1;
+	}
+
+	const auto renderer_name = std::string(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	const auto gl_version = std::string(reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	info<"Rendering on % (%)">(renderer_name, gl_version);
+
+	//----------------------[ Shader Setup ]----------------------//
+
+	shaders::meshes mesh_shader;
+	shaders::points point_shader;
+
+	auto mesh_program = shaders::meshes::begin_from_files(
+		shader_dir / "mesh_vertex.glsl", "", shader_dir / "mesh_fragment.glsl"
+	);
+	auto point_program = shaders::points::begin_from_files(
+		shader_dir / "point_vertex.glsl", "", shader_dir / "point_fragment.glsl"
+	);
+	if (mesh_shader.finish(mesh_program) or point_shader.finish(point_program)) {
+		error<"Failed loading shaders from %">(shader_dir);
+		return -1;
+	}
+
+	auto mesh_pass = mesh_renderer(&mesh_shader);
+	auto point_pass = point_cloud_renderer(&point_shader);
+
+	//----------------------[ Asset loading ]----------------------//
+
+	// Geometry is kept, as nothing else is loaded during the benchmark.
+	scene assets({
+		.pedantic = arguments.get<"pedantic">().value(),
+		.keep_geometry = true,
+		.outer_box = arguments.get<"size">().value_or(glm::vec3{ 100, 100, 100 })
+	});
+
+	std::vector<std::filesystem::path> inputs;
+	for (ztu::isize i = 0; i < arguments.num_positional(); i++) {
+		inputs.emplace_back(arguments.get(i).value());
+	}
+	assets.load(inputs);
+	assets.finish_loading();
+
+	//----------------------[ Benchmark ]----------------------//
+
+	// Same projection and state as the viewer without any zoom.
+	const auto proj_mat = glm::perspective(
+		std::numbers::pi_v<float> / 2.0f,
+		float(width) / float(height),
+		0.1f, 1000.0f
+	);
+
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CCW);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glClearDepth(1.f);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+	ztu::perf_stats timings;
+	auto& mesh_timings = timings.get("mesh pass");
+	auto& point_timings = timings.get("point pass");
+	gpu_timer mesh_gpu_timer(mesh_timings.gpu), point_gpu_timer(point_timings.gpu);
+
+	auto player = flying_camera(path.spawn, { 0, 0, 1 }, { 0, 1, 0 });
+
+	std::vector<frame_timing> frames;
+	frames.reserve(num_frames);
+
+	for (ztu::usize frame = 0; frame < num_warmup_frames + num_frames; frame++) {
+		const auto start = ztu::perf_stats::clock::now();
+
+		// The path starts over from the spawn once it is used up.
+		if (not path.inputs.empty()) {
+			const auto input_index = frame % path.inputs.size();
+			if (input_index == 0) {
+				player = flying_camera(path.spawn, { 0, 0, 1 }, { 0, 1, 0 });
+			}
+			player.update(path.delta_time, path.inputs[input_index]);
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		const auto view_matrix = player.view_matrix() * assets.model_transform();
+		{
+			const auto gpu_scope = gpu_timer::scope(mesh_gpu_timer);
+			mesh_pass.render(assets.mesh_instances(), proj_mat, view_matrix);
+		}
+		{
+			const auto gpu_scope = gpu_timer::scope(point_gpu_timer);
+			point_pass.render(assets.point_cloud_instances(), proj_mat, view_matrix);
+		}
+
+		// Waiting for the GPU stands in for presenting the frame, so every frame is timed in full.
+		glFinish();
+
+		const auto cpu_time = ztu::perf_stats::clock::now() - start;
+
+		mesh_gpu_timer.collect();
+		point_gpu_timer.collect();
+
+		if (frame >= num_warmup_frames) {
+			frames.push_back({
+				.cpu_ms = std::chrono::duration<float, std::milli>(cpu_time).count(),
+				.mesh_gpu_ms = mesh_timings.gpu.last(),
+				.point_gpu_ms = point_timings.gpu.last()
+			});
+		}
+	}
+
+	//----------------------[ Report ]----------------------//
+
+	std::ofstream output;
+	if (output_file) {
+		output.open(*output_file, std::ios::trunc);
+		if (not output.is_open()) {
+			error<"Could not open %">(*output_file);
+			return -1;
+		}
+	}
+	auto& out = output_file ? static_cast<std::ostream&>(output) : std::cout;
+
+	std::vector<float> cpu_values, mesh_gpu_values, point_gpu_values;
+	for (const auto& timing : frames) {
+		cpu_values.push_back(timing.cpu_ms);
+		mesh_gpu_values.push_back(timing.mesh_gpu_ms);
+		point_gpu_values.push_back(timing.point_gpu_ms);
+	}
+
+	out << "{\"renderer\":\"" << escape_json(renderer_name) << "\","
+		<< "\"gl_version\":\"" << escape_json(gl_version) << "\","
+		<< "\"camera_path\":\"" << escape_json(path_file.value_or("")) << "\","
+		<< "\"width\":" << width << ",\"height\":" << height << ","
+		<< "\"warmup_frames\":" << num_warmup_frames << ",\"frames\":" << frames.size() << ","
+		<< "\"summary\":{";
+	write_summary(out, "cpu_frame", cpu_values);
+	out << ",";
+	write_summary(out, "gpu_mesh_pass", mesh_gpu_values);
+	out << ",";
+	write_summary(out, "gpu_point_pass", point_gpu_values);
+	out << "},\"per_frame\":[";
+	for (ztu::usize i = 0; i < frames.size(); i++) {
+		out << (i ? "," : "") << "\n["
+			<< frames[i].cpu_ms << "," << frames[i].mesh_gpu_ms << "," << frames[i].point_gpu_ms << "]";
+	}
+	out << "\n],\"per_frame_columns\":[\"cpu_frame_ms\",\"gpu_mesh_pass_ms\",\"gpu_point_pass_ms\"]}\n";
+
+	if (not out.flush()) {
+		error<"Could not write the results">();
+		return -1;
+	}
+
+	return 0;
+}
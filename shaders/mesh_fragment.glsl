@@ -1,4 +1,4 @@
-#version 460
+#version 450
 
 uniform sampler2D tex;
 uniform float color_merge;
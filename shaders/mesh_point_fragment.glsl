@@ -1,4 +1,4 @@
-#version 460
+#version 450
 
 in vec4 frag_color;
 out vec4 FragColor;
@@ -4,13 +4,20 @@
 
 #include <SFML/OpenGL.hpp>
 #include "graphics/to_gl_type.hpp"
+#include "util/trace.hpp"
 
 
 template<vertex_component... Cs>
 mesh<Cs...>::mesh(
 	const std::vector<typename mesh<Cs...>::vertex_t>& vertexBuffer,
 	const std::vector<ztu::u32>& indexBuffer
-) : m_vertices{ vertexBuffer }, m_indices{ indexBuffer } {
+) :
+	m_vertices{ vertexBuffer },
+	m_indices{ indexBuffer },
+	m_num_vertices{ m_vertices.size() },
+	m_num_indices{ m_indices.size() },
+	m_bounds{ position_bounds::calc_parallel(m_vertices.data(), m_vertices.size()) } {
+	update_cpu_memory();
 }
 
 
@@ -18,7 +25,13 @@ template<vertex_component... Cs>
 mesh<Cs...>::mesh(
 	std::vector<typename mesh<Cs...>::vertex_t>&& vertexBuffer,
 	std::vector<ztu::u32>&& indexBuffer
-) : m_vertices{ std::move(vertexBuffer) }, m_indices{ std::move(indexBuffer) } {
+) :
+	m_vertices{ std::move(vertexBuffer) },
+	m_indices{ std::move(indexBuffer) },
+	m_num_vertices{ m_vertices.size() },
+	m_num_indices{ m_indices.size() },
+	m_bounds{ position_bounds::calc_parallel(m_vertices.data(), m_vertices.size()) } {
+	update_cpu_memory();
 }
 
 template<vertex_component... Cs>
@@ -35,6 +48,11 @@ template<vertex_component... Cs>
 mesh<Cs...>::mesh(const mesh<Cs...>& other) :
 	m_vertices{ other.m_vertices },
 	m_indices{ other.m_indices },
+	m_num_vertices{ other.m_num_vertices },
+	m_num_indices{ other.m_num_indices },
+	m_source{ other.m_source },
+	m_bounds{ other.m_bounds },
+	m_cpu_memory{ other.m_cpu_memory },
 	m_material{ other.m_material } {
 }
 
@@ -42,6 +60,12 @@ template<vertex_component... Cs>
 mesh<Cs...>::mesh(mesh<Cs...>&& other) noexcept:
 	m_vertices{ std::move(other.m_vertices) },
 	m_indices{ std::move(other.m_indices) },
+	m_num_vertices{ other.m_num_vertices },
+	m_num_indices{ other.m_num_indices },
+	m_source{ std::move(other.m_source) },
+	m_bounds{ other.m_bounds },
+	m_cpu_memory{ std::move(other.m_cpu_memory) },
+	m_gpu_memory{ std::move(other.m_gpu_memory) },
 	m_vertex_buffer_id{ other.m_vertex_buffer_id },
 	m_index_buffer_id{ other.m_index_buffer_id },
 	m_vao_id{ other.m_vao_id },
@@ -62,6 +86,12 @@ mesh<Cs...>& mesh<Cs...>::operator=(const mesh<Cs...>& other) {
 
 		m_vertices = other.m_vertices;
 		m_indices = other.m_indices;
+		m_num_vertices = other.m_num_vertices;
+		m_num_indices = other.m_num_indices;
+		m_source = other.m_source;
+		m_bounds = other.m_bounds;
+		m_cpu_memory = other.m_cpu_memory;
+		m_gpu_memory.set(0);
 		m_material = other.m_material;
 	}
 
@@ -76,6 +106,12 @@ mesh<Cs...>& mesh<Cs...>::operator=(mesh<Cs...>&& other) noexcept {
 
 		m_vertices = std::move(other.m_vertices);
 		m_indices = std::move(other.m_indices);
+		m_num_vertices = other.m_num_vertices;
+		m_num_indices = other.m_num_indices;
+		m_source = std::move(other.m_source);
+		m_bounds = other.m_bounds;
+		m_cpu_memory = std::move(other.m_cpu_memory);
+		m_gpu_memory = std::move(other.m_gpu_memory);
 
 		m_vao_id = other.m_vao_id;
 		m_vertex_buffer_id = other.m_vertex_buffer_id;
@@ -92,21 +128,27 @@ mesh<Cs...>& mesh<Cs...>::operator=(mesh<Cs...>&& other) noexcept {
 }
 
 template<vertex_component... Cs>
-void mesh<Cs...>::init_vao() {
+void mesh<Cs...>::init_vao(upload_scheduler& uploads) {
+	const auto zone = ztu::trace::zone("mesh::init_vao");
+
 	glGenVertexArrays(1, &m_vao_id);
 	glBindVertexArray(m_vao_id);
 
+	const auto vertex_buffer_size = m_vertices.size() * sizeof(vertex_t);
 	glGenBuffers(1, &m_vertex_buffer_id);
 	glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer_id);
-	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(vertex_t), &m_vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertex_buffer_size), nullptr, GL_STATIC_DRAW);
 
+	const auto index_buffer_size = m_indices.size() * sizeof(ztu::u32);
 	glGenBuffers(1, &m_index_buffer_id);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer_id);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(ztu::u32), &m_indices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_buffer_size), nullptr, GL_STATIC_DRAW);
+
+	m_gpu_memory.set(vertex_buffer_size + index_buffer_size);
 
 	glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer_id);
 
-	const auto& first_vertex = m_vertices.front();
+	const auto first_vertex = vertex_t{};
 
 	ztu::for_each::index<std::tuple_size_v<vertex>>(
 		[&first_vertex]<auto Index>() {
@@ -131,8 +173,11 @@ void mesh<Cs...>::init_vao() {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
+	uploads.enqueue_buffer(m_vertex_buffer_id, m_vertices.data(), vertex_buffer_size);
+	uploads.enqueue_buffer(m_index_buffer_id, m_indices.data(), index_buffer_size);
+
 	if (auto mtl_ptr = m_material.lock()) {
-		mtl_ptr->init_attributes();
+		mtl_ptr->init_attributes(uploads);
 	}
 }
 
@@ -152,20 +197,12 @@ std::optional<mesh_instance> mesh<Cs...>::create_instance(const glm::mat4x4& mod
 		}
 	}
 
-	return mesh_instance{ m_vao_id, m_indices.size(), model_matrix, std::move(attributes) };
+	return mesh_instance{ m_vao_id, m_num_indices, model_matrix, std::move(attributes) };
 }
 
 template<vertex_component... Cs>
-aabb mesh<Cs...>::calc_bounding_box() const {
-	aabb box;
-	box.min = glm::vec3{ FLT_MAX, FLT_MAX, FLT_MAX };
-	box.max = glm::vec3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
-	for (const auto& vertex : m_vertices) {
-		const auto& position = std::get<0>(vertex);
-		box.min = glm::min(box.min, position);
-		box.max = glm::max(box.max, position);
-	}
-	return box;
+const aabb& mesh<Cs...>::bounding_box() const {
+	return m_bounds;
 }
 
 template<vertex_component... Cs>
@@ -174,16 +211,78 @@ const std::vector<typename mesh<Cs...>::vertex_t>& mesh<Cs...>::vertex_buffer()
 }
 
 template<vertex_component... Cs>
-std::vector<typename mesh<Cs...>::vertex_t>& mesh<Cs...>::vertex_buffer() {
-	return m_vertices;
+const std::vector<ztu::u32>& mesh<Cs...>::index_buffer() const {
+	return m_indices;
 }
 
 template<vertex_component... Cs>
-const std::vector<ztu::u32>& mesh<Cs...>::index_buffer() const {
-	return m_indices;
+ztu::usize mesh<Cs...>::num_vertices() const {
+	return m_num_vertices;
 }
 
 template<vertex_component... Cs>
-std::vector<ztu::u32>& mesh<Cs...>::index_buffer() {
-	return m_indices;
+ztu::usize mesh<Cs...>::num_indices() const {
+	return m_num_indices;
+}
+
+template<vertex_component... Cs>
+void mesh<Cs...>::set_source(geometry_source source) {
+	m_source = std::move(source);
+}
+
+template<vertex_component... Cs>
+bool mesh<Cs...>::release_cpu_data() {
+	if (not m_source) {
+		return false;
+	}
+	// Only a swap actually returns the memory.
+	std::vector<vertex_t>().swap(m_vertices);
+	std::vector<ztu::u32>().swap(m_indices);
+	update_cpu_memory();
+	return true;
+}
+
+template<vertex_component... Cs>
+std::error_code mesh<Cs...>::fetch_cpu_data() {
+	if (has_cpu_data()) {
+		return {};
+	}
+
+	if (not m_source) {
+		return std::make_error_code(std::errc::no_such_file_or_directory);
+	}
+
+	std::vector<vertex_t> vertices;
+	std::vector<ztu::u32> indices;
+	if (const auto e = m_source(vertices, indices); e) {
+		return e;
+	}
+	if (vertices.size() != m_num_vertices or indices.size() != m_num_indices) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+	m_vertices = std::move(vertices);
+	m_indices = std::move(indices);
+	update_cpu_memory();
+
+	return {};
+}
+
+template<vertex_component... Cs>
+bool mesh<Cs...>::has_cpu_data() const {
+	return m_vertices.size() == m_num_vertices and m_indices.size() == m_num_indices;
+}
+
+template<vertex_component... Cs>
+ztu::usize mesh<Cs...>::cpu_bytes() const {
+	return m_cpu_memory.bytes();
+}
+
+template<vertex_component... Cs>
+ztu::usize mesh<Cs...>::gpu_bytes() const {
+	return m_gpu_memory.bytes();
+}
+
+template<vertex_component... Cs>
+void mesh<Cs...>::update_cpu_memory() {
+	m_cpu_memory.set(m_vertices.capacity() * sizeof(vertex_t) + m_indices.capacity() * sizeof(ztu::u32));
 }
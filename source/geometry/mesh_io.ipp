@@ -0,0 +1,561 @@
+#ifndef INCLUDE_MESH_IO_IMPLEMENTATION
+#error Never include this file directly include 'mesh_io.hpp'
+#endif
+
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include "util/for_each.hpp"
+#include "util/mapped_file.hpp"
+#include "util/buffered_writer.hpp"
+#include "util/memory_stats.hpp"
+#include "util/scratch_arena.hpp"
+
+namespace mesh_loader_error {
+
+struct category : std::error_category {
+	[[nodiscard]] const char* name() const noexcept override {
+		return "connector";
+	}
+
+	[[nodiscard]] std::string message(int ev) const override {
+		switch (static_cast<codes>(ev)) {
+			using
+			enum codes;
+		case obj_cannot_open_file:
+			return "Cannot open given obj file";
+		case obj_malformed_vertex:
+			return "Malformed 'v' statement";
+		case obj_malformed_texture_coordinate:
+			return "Malformed 'vt' statement";
+		case obj_malformed_normal:
+			return "Malformed 'vn' statement";
+		case obj_malformed_face:
+			return "Malformed 'f' statement";
+		case obj_face_index_out_of_range:
+			return "Face index out of range";
+		case obj_unknown_line_begin:
+			return "Unknown obj line begin";
+		case mtl_cannot_open_file:
+			return "Cannot open mtl file";
+		case mtl_cannot_open_texture:
+			return "Cannot open texture file";
+		case mtl_malformed_color:
+			return "Malformed 'Kd' statement";
+		case mtl_malformed_color_alpha:
+			return "malformed 'd' statement";
+		case mlt_unknown_line_begin:
+			return "Unknown mtl line begin";
+		default:
+			using namespace std::string_literals;
+			return "unrecognized error ("s + std::to_string(ev) + ")";
+		}
+	}
+};
+
+} // namespace mesh_loader_error
+
+
+inline std::error_category& connector_error_category() {
+	static mesh_loader_error::category category;
+	return category;
+}
+
+
+namespace mesh_loader_error {
+
+inline std::error_code make_error_code(codes e) {
+	return { static_cast<int>(e), connector_error_category() };
+}
+
+} // namespace mesh_loader_error
+
+
+template<vertex_component... Cs>
+struct vertex_id {
+	std::array<ztu::u32, std::tuple_size_v<mesh_vertex<Cs...>>> indices{ };
+
+	friend auto operator<=>(const vertex_id&, const vertex_id&) = default;
+};
+
+template<vertex_component... Cs>
+struct indexed_vertex_id {
+	vertex_id<vertex_components::position, Cs...> id;
+	ztu::u32 bufferIndex{ ztu::u32_max };
+
+	indexed_vertex_id(std::span<const ztu::u32, std::tuple_size_v<mesh_vertex<Cs...>>> indices) {
+		std::copy(indices.begin(), indices.end(), id.indices.begin());
+	}
+
+	friend auto operator<=>(const indexed_vertex_id& a, const indexed_vertex_id& b) {
+		return a.id <=> b.id;
+	}
+
+	bool operator==(const indexed_vertex_id& other) const noexcept {
+		return other.id == id;
+	}
+};
+
+
+template<typename F>
+struct prefixed_parser {
+	const std::string_view prefix;
+	F parse;
+};
+
+template<class... Fs>
+bool parse_line(std::string_view line, prefixed_parser<Fs>&& ... parsers) {
+	return ztu::for_each::argument(
+		[&](auto&& parser) {
+			if (line.starts_with(parser.prefix)) {
+				parser.parse(line.substr(parser.prefix.length()));
+				return true;
+			}
+			return false;
+		}, parsers...
+	);
+}
+
+
+template<vertex_component... Cs>
+std::error_code mesh_loader::parse_obj(
+	const std::filesystem::path& filename,
+	std::vector<mesh_data<Cs...>>& destination,
+	std::vector<std::filesystem::path>& material_libraries,
+	bool pedantic
+) {
+	using
+	enum mesh_loader_error::codes;
+	using mesh_loader_error::make_error_code;
+
+	auto in = std::ifstream{ filename };
+	if (not in.is_open()) {
+		return make_error_code(obj_cannot_open_file);
+	}
+
+	const auto parse_phase = ztu::memory_stats::phase_scope(ztu::memory_stats::phase::parse);
+
+	namespace fs = std::filesystem;
+	const auto directory = fs::path(filename).parent_path();
+
+	// Vertex lookup for parsing.
+	// Contains one default value for each type because a face must not always specify
+	// an index for normal and texture coordinated. Since the final vertex buffer needs
+	// to have all three components, these default values are used in these cases.
+	// (The default vertex position is not strictly needed but makes indexing easier)
+	// All parsing buffers live in the scratch arena of this thread, which keeps its memory between files.
+	const auto scratch = ztu::scratch_arena::scope();
+
+	std::pmr::vector<typename vertex_components::position::type> vertices({ { 0.f, 0.f, 0.f } }, scratch.resource());
+	std::pmr::vector<typename vertex_components::normal::type> normals({ { 0.f, 0.f, 0.f } }, scratch.resource());
+	std::pmr::vector<typename vertex_components::tex_coord::type> tex_coords({ { 0.f, 0.f } }, scratch.resource());
+
+	static constexpr auto num_comps = std::tuple_size_v<mesh_vertex<Cs...>>;
+
+	// Vertex and index buffer of the current mesh, they are copied into exactly sized buffers once it is complete.
+	std::pmr::vector<mesh_vertex<Cs...>> vertex_buffer(scratch.resource());
+	std::pmr::vector<ztu::u32> index_buffer(scratch.resource());
+
+	// Each vertex of a face can represent a unique combination of vertex-/texture-/normal-coordinates.
+	// But some combinations may occur more than once, for example on every corner of a cube 3 triangles will
+	// reference the exact same corner vertex.
+	// To get the best rendering performance and lowest final memory footprint these duplicates
+	// need to be removed. So this sorted lookup is used to identify the aforementioned duplicates
+	// and only push unique combinations to the vertex buffer.
+	std::pmr::vector<indexed_vertex_id<Cs...>> vertex_ids(scratch.resource());
+
+	std::string use_material_name;
+	mesh_loader_error::codes errc{ };
+	std::string line;
+
+	const auto push_mesh = [&]() {
+		if (not vertex_buffer.empty()) {
+			// Copy buffers instead of moving to keep capacity for further parsing
+			// and have the final buffers be shrunk to size.
+			destination.push_back({
+				{ vertex_buffer.begin(), vertex_buffer.end() },
+				{ index_buffer.begin(), index_buffer.end() },
+				use_material_name
+			});
+		}
+
+		vertex_buffer.clear();
+		index_buffer.clear();
+		vertex_ids.clear();
+		use_material_name.clear();
+	};
+
+	const auto find_or_push_vertex = [&](const std::array<ztu::u32, num_comps>& comp_indices) -> ztu::isize {
+		// Search through sorted lookup to check if index combination is unique
+		indexed_vertex_id<Cs...> vID(comp_indices);
+		const auto id_it = std::upper_bound(vertex_ids.begin(), vertex_ids.end(), vID);
+
+		ztu::isize index;
+
+		if (id_it != vertex_ids.begin() and *(id_it - 1) == vID) {
+			index = (id_it - 1)->bufferIndex;
+		} else {
+			index = vID.bufferIndex = vertex_buffer.size();
+			vertex_ids.insert(id_it, vID);
+
+			auto& dst_vertex = vertex_buffer.emplace_back();
+
+			using vertex = std::tuple<vertex_components::position, Cs...>;
+			const auto set_vertex_comp = [&dst_vertex]<typename Component>(
+				const std::pmr::vector<typename Component::type>& list,
+				const ztu::u32 index
+			) -> mesh_loader_error::codes {
+				if (index >= list.size()) {
+					return obj_face_index_out_of_range;
+				}
+				const auto& value = list[index];
+				ztu::for_each::index<std::tuple_size_v<vertex>>(
+					[&]<auto Index>() {
+						if constexpr (std::is_same_v<
+							Component, std::tuple_element_t<Index, vertex>>) {
+							std::get<Index>(dst_vertex) = value;
+							return true;
+						}
+						return false;
+					}
+				);
+
+				return ok;
+			};
+
+			// @formatter:off unreadable if turned on
+			if ((errc = set_vertex_comp.template operator()<vertex_components::position>(
+					vertices, comp_indices[0]
+				)) != ok or
+				(errc = set_vertex_comp.template operator()<vertex_components::tex_coord>(
+					tex_coords, comp_indices[1]
+				)) != ok or
+				(errc = set_vertex_comp.template operator()<vertex_components::normal>(
+					normals, comp_indices[2]
+				)) != ok
+			) {
+				// Discard whole face if one index is out of range
+				index = -1;
+			}
+			// @formatter:on
+		}
+
+		return index;
+	};
+
+	while (std::getline(in, line)) {
+		[[maybe_unused]] const auto found_match = parse_line(
+			line,
+			prefixed_parser{
+				"v ", [&](const auto& param) {
+					typename vertex_components::position::type position;
+					auto it = param.begin();
+					for (int i = 0; i < 3; i++) {
+						const auto [ptr, ec] = std::from_chars(it, param.cend(), position[i]);
+						if (ec != std::errc()) {
+							errc = obj_malformed_vertex;
+							return;
+						}
+						it = ptr + 1; // skip space in between components
+					}
+					vertices.push_back(position);
+				}
+			},
+			prefixed_parser{
+				"vt ", [&](const auto& param) {
+					typename vertex_components::tex_coord::type coord;
+					auto it = param.begin();
+					for (int i = 0; i < 2; i++) {
+						const auto [ptr, ec] = std::from_chars(it, param.cend(), coord[i]);
+						if (ec != std::errc()) {
+							errc = obj_malformed_texture_coordinate;
+							return;
+						}
+						it = ptr + 1; // skip space in between components
+					}
+					tex_coords.push_back(coord);
+				}
+			},
+			prefixed_parser{
+				"vn ", [&](const auto& param) {
+					typename vertex_components::normal::type normal;
+					auto it = param.begin();
+					for (int i = 0; i < 3; i++) {
+						const auto [ptr, ec] = std::from_chars(it, param.cend(), normal[i]);
+						if (ec != std::errc()) {
+							errc = obj_malformed_normal;
+							return;
+						}
+						it = ptr + 1; // skip space in between components
+					}
+					normals.push_back(normal);
+				}
+			},
+			prefixed_parser{
+				"o ", [&](const auto& param) {
+					push_mesh(); // Name is currently ignored
+				}
+			},
+			prefixed_parser{
+				"f ", [&](const auto& param) {
+					ztu::u32 first_index, prev_index, comp_index = 0;
+
+					// Index for position and all the vertex components
+					// Indices are set to 0 so if the obj does not hold m_data
+					// for that component the fallback component at index 0 is used
+					std::array<ztu::u32, num_comps> comp_indices{ };
+
+					const char* it = param.begin();
+					for (int vertex_index = 0; it <= param.end();) {
+						// include an extra iteration to push the last vertex
+						if (it == param.end() or *it == ' ') {
+
+							const auto curr_index = find_or_push_vertex(comp_indices);
+							if (curr_index == -1) {
+								return;
+							}
+
+							if (vertex_index >= 2) {
+								index_buffer.reserve(3);
+								index_buffer.push_back(first_index);
+								index_buffer.push_back(prev_index);
+								index_buffer.push_back(curr_index);
+							} else if (vertex_index == 0) {
+								first_index = curr_index;
+							}
+
+							prev_index = curr_index;
+							vertex_index++;
+							it++;
+							comp_index = 0;
+
+						} else if (*it == '/') {
+							comp_index++;
+							it++;
+							if (comp_index == 3) [[unlikely]] {
+								errc = obj_malformed_face;
+								return;
+							}
+						} else {
+							// Implement relative indexing feature
+							const auto [ptr, ec] = std::from_chars(it, param.cend(), comp_indices[comp_index]);
+							if (ec != std::errc()) {
+								errc = obj_malformed_face;
+								// Discard whole face if one index is malformed
+								return;
+							}
+							it = ptr;
+						}
+					}
+				}
+			},
+			prefixed_parser{
+				"usemtl ", [&](const auto& param) {
+					use_material_name = param;
+				}
+			},
+			prefixed_parser{
+				"mtllib ", [&](const auto& param) {
+					auto material_filename = fs::path(param);
+					if (material_filename.is_relative()) {
+						material_filename = directory / material_filename;
+					}
+					material_libraries.push_back(std::move(material_filename));
+				}
+			}
+		);
+		if (pedantic) {
+			/*
+			Even on pedantic this is too much as this parser is not feature complete.
+			if (not found_match) [[unlikely]] {
+			 	return make_error_code(obj_unknown_line_begin);
+			}
+		 	*/
+			if (errc != ok) [[unlikely]] {
+				return make_error_code(errc);
+			}
+		}
+	}
+
+	push_mesh();
+
+	return { };
+}
+
+template<vertex_component... Cs>
+std::error_code mesh_loader::write_cobj_file(
+	const std::filesystem::path& filename,
+	const std::vector<mesh_data<Cs...>>& meshes,
+	const std::vector<std::filesystem::path>& material_libraries
+) {
+	static_assert((std::is_same_v<typename Cs::component_type, float> and ...));
+	static_assert(1 + sizeof...(Cs) <= cobj::max_components);
+
+	static constexpr auto component_uuids = vertex_component_uuids<vertex_components::position, Cs...>;
+	static constexpr auto vertex_floats = (vertex_components::position::count + ... + Cs::count);
+
+	if (meshes.size() > ztu::u32_max or material_libraries.size() > ztu::u32_max) {
+		return std::make_error_code(std::errc::value_too_large);
+	}
+
+	ztu::buffered_writer out;
+	if (const auto e = ztu::buffered_writer::open(filename, out); e) {
+		return e;
+	}
+
+	cobj::header header;
+	header.num_components = component_uuids.size();
+	std::copy(component_uuids.begin(), component_uuids.end(), header.component_uuids.begin());
+	header.num_meshes = static_cast<ztu::u32>(meshes.size());
+	header.num_material_libraries = static_cast<ztu::u32>(material_libraries.size());
+	out.write(header);
+
+	const auto write_string = [&out](const std::string& str) {
+		out.write(static_cast<ztu::u32>(str.size()));
+		out.write(str.data(), str.size());
+	};
+
+	const auto directory = std::filesystem::absolute(filename).parent_path();
+	for (const auto& material_library : material_libraries) {
+		write_string(std::filesystem::proximate(material_library, directory).generic_string());
+	}
+
+	std::vector<float> floats;
+	for (const auto& mesh : meshes) {
+		if (
+			mesh.material_name.size() > ztu::u32_max or
+			mesh.vertices.size() > ztu::u32_max or
+			mesh.indices.size() > ztu::u32_max
+		) {
+			return std::make_error_code(std::errc::value_too_large);
+		}
+
+		out.write(cobj::mesh_header{
+			.material_name_size = static_cast<ztu::u32>(mesh.material_name.size()),
+			.num_vertices = static_cast<ztu::u32>(mesh.vertices.size()),
+			.num_indices = static_cast<ztu::u32>(mesh.indices.size())
+		});
+		out.write(mesh.material_name.data(), mesh.material_name.size());
+
+		floats.resize(mesh.vertices.size() * vertex_floats);
+		auto dst = floats.data();
+		for (const auto& vertex : mesh.vertices) {
+			dst = pack_vertex(vertex, dst);
+		}
+		out.write(floats.data(), floats.size() * sizeof(float));
+		out.write(mesh.indices.data(), mesh.indices.size() * sizeof(ztu::u32));
+	}
+
+	return out.close();
+}
+
+template<vertex_component... Cs>
+std::error_code mesh_loader::load_cobj_file(
+	const std::filesystem::path& filename,
+	std::vector<mesh_data<Cs...>>& meshes,
+	std::vector<std::filesystem::path>& material_libraries
+) {
+	static constexpr auto component_uuids = vertex_component_uuids<vertex_components::position, Cs...>;
+	static constexpr auto vertex_floats = (vertex_components::position::count + ... + Cs::count);
+
+	const auto parse_phase = ztu::memory_stats::phase_scope(ztu::memory_stats::phase::parse);
+
+	ztu::mapped_file file;
+	if (const auto e = ztu::mapped_file::open(filename, file, ztu::mapped_file::access_pattern::sequential); e) {
+		return e;
+	}
+
+	auto it = file.begin();
+	const auto end = file.end();
+
+	const auto read = [&](void* dst, const ztu::usize size) {
+		if (static_cast<ztu::usize>(end - it) < size) {
+			return false;
+		}
+		std::memcpy(dst, it, size);
+		it += size;
+		return true;
+	};
+
+	const auto invalid_file = std::make_error_code(std::errc::invalid_argument);
+
+	cobj::header header;
+	if (
+		not read(&header, sizeof(header)) or
+		header.magic != cobj::magic_bytes or
+		header.version != cobj::version_1 or
+		header.num_components != component_uuids.size() or
+		not std::equal(component_uuids.begin(), component_uuids.end(), header.component_uuids.begin())
+	) {
+		return invalid_file;
+	}
+
+	const auto read_string = [&](std::string& str) {
+		auto size = ztu::u32{};
+		if (not read(&size, sizeof(size)) or static_cast<ztu::usize>(end - it) < size) {
+			return false;
+		}
+		str.assign(it, size);
+		it += size;
+		return true;
+	};
+
+	const auto directory = filename.parent_path();
+	std::string str;
+	for (ztu::u32 i = 0; i < header.num_material_libraries; i++) {
+		if (not read_string(str)) {
+			return invalid_file;
+		}
+		auto material_library = std::filesystem::path(str);
+		if (material_library.is_relative()) {
+			material_library = directory / material_library;
+		}
+		material_libraries.push_back(std::move(material_library));
+	}
+
+	const auto scratch = ztu::scratch_arena::scope();
+	std::pmr::vector<float> floats(scratch.resource());
+	for (ztu::u32 i = 0; i < header.num_meshes; i++) {
+		cobj::mesh_header mesh_header;
+		if (not read(&mesh_header, sizeof(mesh_header))) {
+			return invalid_file;
+		}
+
+		const auto num_floats = ztu::usize{ mesh_header.num_vertices } * vertex_floats;
+		const auto mesh_size = (
+			ztu::usize{ mesh_header.material_name_size } +
+			num_floats * sizeof(float) +
+			ztu::usize{ mesh_header.num_indices } * sizeof(ztu::u32)
+		);
+		// Check the size up front, so broken headers cannot cause huge allocations.
+		if (static_cast<ztu::usize>(end - it) < mesh_size) {
+			return invalid_file;
+		}
+
+		auto& mesh = meshes.emplace_back();
+
+		floats.resize(num_floats);
+		mesh.material_name.resize(mesh_header.material_name_size);
+		mesh.indices.resize(mesh_header.num_indices);
+
+		read(mesh.material_name.data(), mesh.material_name.size());
+		read(floats.data(), num_floats * sizeof(float));
+		read(mesh.indices.data(), mesh.indices.size() * sizeof(ztu::u32));
+
+		mesh.vertices.resize(mesh_header.num_vertices);
+		const float* src = floats.data();
+		for (auto& vertex : mesh.vertices) {
+			src = unpack_vertex(src, vertex);
+		}
+
+		if (std::any_of(
+			mesh.indices.begin(), mesh.indices.end(),
+			[&](const ztu::u32 index) { return index >= mesh.vertices.size(); }
+		)) {
+			meshes.pop_back();
+			return invalid_file;
+		}
+	}
+
+	return {};
+}
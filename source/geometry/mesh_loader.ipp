@@ -3,112 +3,69 @@
 #endif
 
 #include <fstream>
+#include "util/trace.hpp"
 
-namespace mesh_loader_error {
 
-struct category : std::error_category {
-	[[nodiscard]] const char* name() const noexcept override {
-		return "connector";
-	}
+namespace mesh_loader_internal {
 
-	[[nodiscard]] std::string message(int ev) const override {
-		switch (static_cast<codes>(ev)) {
-			using
-			enum codes;
-		case obj_cannot_open_file:
-			return "Cannot open given obj file";
-		case obj_malformed_vertex:
-			return "Malformed 'v' statement";
-		case obj_malformed_texture_coordinate:
-			return "Malformed 'vt' statement";
-		case obj_malformed_normal:
-			return "Malformed 'vn' statement";
-		case obj_malformed_face:
-			return "Malformed 'f' statement";
-		case obj_face_index_out_of_range:
-			return "Face index out of range";
-		case obj_unknown_line_begin:
-			return "Unknown obj line begin";
-		case mtl_cannot_open_file:
-			return "Cannot open mtl file";
-		case mtl_cannot_open_texture:
-			return "Cannot open texture file";
-		case mtl_malformed_color:
-			return "Malformed 'Kd' statement";
-		case mtl_malformed_color_alpha:
-			return "malformed 'd' statement";
-		case mlt_unknown_line_begin:
-			return "Unknown mtl line begin";
-		default:
-			using namespace std::string_literals;
-			return "unrecognized error ("s + std::to_string(ev) + ")";
+/**
+ * Source that loads the whole file again with 'load' and picks the mesh at 'index'.
+ */
+template<vertex_component... Cs, typename Load>
+typename mesh<Cs...>::geometry_source make_mesh_source(const Load& load, const ztu::usize index) {
+	return [load, index](auto& vertices, auto& indices) -> std::error_code {
+		std::vector<mesh_data<Cs...>> meshes;
+		std::vector<std::filesystem::path> material_libraries;
+		if (const auto e = load(meshes, material_libraries); e) {
+			return e;
 		}
-	}
-};
-
-} // namespace mesh_loader_error
-
-
-inline std::error_category& connector_error_category() {
-	static mesh_loader_error::category category;
-	return category;
-}
-
-
-namespace mesh_loader_error {
-
-inline std::error_code make_error_code(codes e) {
-	return { static_cast<int>(e), connector_error_category() };
+		if (index >= meshes.size()) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+		vertices = std::move(meshes[index].vertices);
+		indices = std::move(meshes[index].indices);
+		return {};
+	};
 }
 
-} // namespace mesh_loader_error
-
-
-template<vertex_component... Cs>
-struct vertex_id {
-	std::array<ztu::u32, std::tuple_size_v<typename mesh<Cs...>::vertex_t>> indices{ };
-
-	friend auto operator<=>(const vertex_id&, const vertex_id&) = default;
-};
-
-template<vertex_component... Cs>
-struct indexed_vertex_id {
-	vertex_id<vertex_components::position, Cs...> id;
-	ztu::u32 bufferIndex{ ztu::u32_max };
-
-	indexed_vertex_id(std::span<const ztu::u32, std::tuple_size_v<typename mesh<Cs...>::vertex_t>> indices) {
-		std::copy(indices.begin(), indices.end(), id.indices.begin());
-	}
-
-	friend auto operator<=>(const indexed_vertex_id& a, const indexed_vertex_id& b) {
-		return a.id <=> b.id;
+template<vertex_component... Cs, typename Load>
+std::error_code create_meshes(
+	const Load& load,
+	std::vector<mesh<Cs...>>& destination,
+	std::unordered_map<std::string, std::shared_ptr<material>>& materials,
+	bool pedantic
+) {
+	std::vector<mesh_data<Cs...>> meshes;
+	std::vector<std::filesystem::path> material_libraries;
+	if (const auto e = load(meshes, material_libraries); e) {
+		return e;
 	}
 
-	bool operator==(const indexed_vertex_id& other) const noexcept {
-		return other.id == id;
+	for (const auto& material_library : material_libraries) {
+		const auto errc = mesh_loader::parse_mtl(material_library, materials, pedantic);
+		if (pedantic and errc != mesh_loader_error::codes::ok) [[unlikely]] {
+			return mesh_loader_error::make_error_code(errc);
+		}
 	}
-};
-
 
-template<typename F>
-struct prefixed_parser {
-	const std::string_view prefix;
-	F parse;
-};
+	for (ztu::usize i = 0; i < meshes.size(); i++) {
+		auto& data = meshes[i];
+		auto& new_mesh = destination.emplace_back(std::move(data.vertices), std::move(data.indices));
+		new_mesh.set_source(make_mesh_source<Cs...>(load, i));
 
-template<class... Fs>
-bool parse_line(std::string_view line, prefixed_parser<Fs>&& ... parsers) {
-	return ztu::for_each::argument(
-		[&](auto&& parser) {
-			if (line.starts_with(parser.prefix)) {
-				parser.parse(line.substr(parser.prefix.length()));
-				return true;
+		if (not data.material_name.empty()) {
+			const auto it = materials.find(data.material_name);
+			if (it != materials.end()) {
+				new_mesh.m_material = it->second;
 			}
-			return false;
-		}, parsers...
-	);
+		}
+	}
+
+	return {};
 }
 
+} // namespace mesh_loader_internal
+
 
 template<vertex_component... Cs>
 std::error_code mesh_loader::load_from_obj(
@@ -117,260 +74,35 @@ std::error_code mesh_loader::load_from_obj(
 	std::unordered_map<std::string, std::shared_ptr<material>>& materials,
 	bool pedantic
 ) {
-	using
-	enum mesh_loader_error::codes;
-	using mesh_loader_error::make_error_code;
+	const auto zone = ztu::trace::zone("load_from_obj", filename);
 
-	auto in = std::ifstream{ filename };
-	if (not in.is_open()) {
-		return make_error_code(obj_cannot_open_file);
-	}
-
-	namespace fs = std::filesystem;
-	const auto directory = fs::path(filename).parent_path();
-
-	// Vertex lookup for parsing.
-	// Contains one default value for each type because a face must not always specify
-	// an index for normal and texture coordinated. Since the final vertex buffer needs
-	// to have all three components, these default values are used in these cases.
-	// (The default vertex position is not strictly needed but makes indexing easier)
-	std::vector<typename vertex_components::position::type> vertices{ { 0.f, 0.f, 0.f } };
-	std::vector<typename vertex_components::normal::type> normals{ { 0.f, 0.f, 0.f } };
-	std::vector<typename vertex_components::tex_coord::type> tex_coords{ { 0.f, 0.f } };
-
-	static constexpr auto num_comps = std::tuple_size_v<typename mesh<Cs...>::vertex_t>;
-
-	// Final vertex and index buffer for OpenGL
-	std::vector<typename mesh<Cs...>::vertex_t> vertex_buffer;
-	std::vector<ztu::u32> index_buffer;
-
-	// Each vertex of a face can represent a unique combination of vertex-/texture-/normal-coordinates.
-	// But some combinations may occur more than once, for example on every corner of a cube 3 triangles will
-	// reference the exact same corner vertex.
-	// To get the best rendering performance and lowest final memory footprint these duplicates
-	// need to be removed. So this sorted lookup is used to identify the aforementioned duplicates
-	// and only push unique combinations to the vertex buffer.
-	std::vector<indexed_vertex_id<Cs...>> vertex_ids;
-
-	std::string use_material_name;
-	mesh_loader_error::codes errc{ };
-	std::string line;
-
-	const auto push_mesh = [&]() {
-		if (not vertex_buffer.empty()) {
-			// Copy buffers instead of moving to keep capacity for further parsing
-			// and have the final buffers be shrunk to size.
-			auto& new_mesh = destination.emplace_back(vertex_buffer, index_buffer);
-
-			if (not use_material_name.empty()) {
-				const auto it = materials.find(use_material_name);
-				if (it != materials.end()) {
-					new_mesh.m_material = it->second;
-				}
-			}
-		}
-
-		vertex_buffer.clear();
-		index_buffer.clear();
-		vertex_ids.clear();
-		use_material_name.clear();
+	const auto load = [filename, pedantic](
+		std::vector<mesh_data<Cs...>>& meshes,
+		std::vector<std::filesystem::path>& material_libraries
+	) {
+		return parse_obj(filename, meshes, material_libraries, pedantic);
 	};
 
-	const auto find_or_push_vertex = [&](const std::array<ztu::u32, num_comps>& comp_indices) -> ztu::isize {
-		// Search through sorted lookup to check if index combination is unique
-		indexed_vertex_id<Cs...> vID(comp_indices);
-		const auto id_it = std::upper_bound(vertex_ids.begin(), vertex_ids.end(), vID);
-
-		ztu::isize index;
-
-		if (id_it != vertex_ids.begin() and *(id_it - 1) == vID) {
-			index = (id_it - 1)->bufferIndex;
-		} else {
-			index = vID.bufferIndex = vertex_buffer.size();
-			vertex_ids.insert(id_it, vID);
-
-			auto& dst_vertex = vertex_buffer.emplace_back();
-
-			using vertex = mesh<Cs...>::vertex;
-			const auto set_vertex_comp = [&dst_vertex]<typename Component>(
-				const std::vector<typename Component::type>& list,
-				const ztu::u32 index
-			) -> mesh_loader_error::codes {
-				if (index >= list.size()) {
-					return obj_face_index_out_of_range;
-				}
-				const auto& value = list[index];
-				ztu::for_each::index<std::tuple_size_v<vertex>>(
-					[&]<auto Index>() {
-						if constexpr (std::is_same_v<
-							Component, std::tuple_element_t<Index, vertex>>) {
-							std::get<Index>(dst_vertex) = value;
-							return true;
-						}
-						return false;
-					}
-				);
-
-				return ok;
-			};
+	return mesh_loader_internal::create_meshes(load, destination, materials, pedantic);
+}
 
-			// @formatter:off unreadable if turned on
-			if ((errc = set_vertex_comp.template operator()<vertex_components::position>(
-					vertices, comp_indices[0]
-				)) != ok or
-				(errc = set_vertex_comp.template operator()<vertex_components::tex_coord>(
-					tex_coords, comp_indices[1]
-				)) != ok or
-				(errc = set_vertex_comp.template operator()<vertex_components::normal>(
-					normals, comp_indices[2]
-				)) != ok
-			) {
-				// Discard whole face if one index is out of range
-				index = -1;
-			}
-			// @formatter:on
-		}
+template<vertex_component... Cs>
+std::error_code mesh_loader::load_from_cobj(
+	const std::filesystem::path& filename,
+	std::vector<mesh<Cs...>>& destination,
+	std::unordered_map<std::string, std::shared_ptr<material>>& materials,
+	bool pedantic
+) {
+	const auto zone = ztu::trace::zone("load_from_cobj", filename);
 
-		return index;
+	const auto load = [filename](
+		std::vector<mesh_data<Cs...>>& meshes,
+		std::vector<std::filesystem::path>& material_libraries
+	) {
+		return load_cobj_file(filename, meshes, material_libraries);
 	};
 
-	while (std::getline(in, line)) {
-		[[maybe_unused]] const auto found_match = parse_line(
-			line,
-			prefixed_parser{
-				"v ", [&](const auto& param) {
-					typename vertex_components::position::type position;
-					auto it = param.begin();
-					for (int i = 0; i < 3; i++) {
-						const auto [ptr, ec] = std::from_chars(it, param.cend(), position[i]);
-						if (ec != std::errc()) {
-							errc = obj_malformed_vertex;
-							return;
-						}
-						it = ptr + 1; // skip space in between components
-					}
-					vertices.push_back(position);
-				}
-			},
-			prefixed_parser{
-				"vt ", [&](const auto& param) {
-					typename vertex_components::tex_coord::type coord;
-					auto it = param.begin();
-					for (int i = 0; i < 2; i++) {
-						const auto [ptr, ec] = std::from_chars(it, param.cend(), coord[i]);
-						if (ec != std::errc()) {
-							errc = obj_malformed_texture_coordinate;
-							return;
-						}
-						it = ptr + 1; // skip space in between components
-					}
-					tex_coords.push_back(coord);
-				}
-			},
-			prefixed_parser{
-				"vn ", [&](const auto& param) {
-					typename vertex_components::normal::type normal;
-					auto it = param.begin();
-					for (int i = 0; i < 3; i++) {
-						const auto [ptr, ec] = std::from_chars(it, param.cend(), normal[i]);
-						if (ec != std::errc()) {
-							errc = obj_malformed_normal;
-							return;
-						}
-						it = ptr + 1; // skip space in between components
-					}
-					normals.push_back(normal);
-				}
-			},
-			prefixed_parser{
-				"o ", [&](const auto& param) {
-					push_mesh(); // Name is currently ignored
-				}
-			},
-			prefixed_parser{
-				"f ", [&](const auto& param) {
-					ztu::u32 first_index, prev_index, comp_index = 0;
-
-					// Index for position and all the vertex components
-					// Indices are set to 0 so if the obj does not hold m_data
-					// for that component the fallback component at index 0 is used
-					std::array<ztu::u32, num_comps> comp_indices{ };
-
-					const char* it = param.begin();
-					for (int vertex_index = 0; it <= param.end();) {
-						// include an extra iteration to push the last vertex
-						if (it == param.end() or *it == ' ') {
-
-							const auto curr_index = find_or_push_vertex(comp_indices);
-							if (curr_index == -1) {
-								return;
-							}
-
-							if (vertex_index >= 2) {
-								index_buffer.reserve(3);
-								index_buffer.push_back(first_index);
-								index_buffer.push_back(prev_index);
-								index_buffer.push_back(curr_index);
-							} else if (vertex_index == 0) {
-								first_index = curr_index;
-							}
-
-							prev_index = curr_index;
-							vertex_index++;
-							it++;
-							comp_index = 0;
-
-						} else if (*it == '/') {
-							comp_index++;
-							it++;
-							if (comp_index == 3) [[unlikely]] {
-								errc = obj_malformed_face;
-								return;
-							}
-						} else {
-							// Implement relative indexing feature
-							const auto [ptr, ec] = std::from_chars(it, param.cend(), comp_indices[comp_index]);
-							if (ec != std::errc()) {
-								errc = obj_malformed_face;
-								// Discard whole face if one index is malformed
-								return;
-							}
-							it = ptr;
-						}
-					}
-				}
-			},
-			prefixed_parser{
-				"usemtl ", [&](const auto& param) {
-					use_material_name = param;
-				}
-			},
-			prefixed_parser{
-				"mtllib ", [&](const auto& param) {
-					auto material_filename = fs::path(param);
-					if (material_filename.is_relative()) {
-						material_filename = directory / material_filename;
-					}
-					errc = parse_mtl(material_filename, materials, pedantic);
-				}
-			}
-		);
-		if (pedantic) {
-			/*
-			Even on pedantic this is too much as this parser is not feature complete.
-			if (not found_match) [[unlikely]] {
-			 	return make_error_code(obj_unknown_line_begin);
-			}
-		 	*/
-			if (errc != ok) [[unlikely]] {
-				return make_error_code(errc);
-			}
-		}
-	}
-
-	push_mesh();
-
-	return { };
+	return mesh_loader_internal::create_meshes(load, destination, materials, pedantic);
 }
 
 mesh_loader_error::codes mesh_loader::parse_mtl(
@@ -378,6 +110,7 @@ mesh_loader_error::codes mesh_loader::parse_mtl(
 	std::unordered_map<std::string, std::shared_ptr<material>>& materials,
 	bool pedantic
 ) {
+	const auto zone = ztu::trace::zone("parse_mtl", filename);
 
 	using
 	enum mesh_loader_error::codes;
@@ -419,9 +152,7 @@ mesh_loader_error::codes mesh_loader::parse_mtl(
 					if (texture::load(texture_filename.c_str(), tex, true)) {
 						errc = mtl_cannot_open_texture;
 					} else {
-						curr_material.m_tex = std::make_unique<texture>(
-							std::move(tex)
-						);
+						curr_material.set_texture(std::move(tex));
 					}
 				}
 			},
@@ -3,21 +3,64 @@
 #endif
 
 
+#include <numeric>
 #include <SFML/OpenGL.hpp>
 #include "util/logger.hpp"
+#include "util/trace.hpp"
 #include "graphics/to_gl_type.hpp"
 
 
 template<vertex_component... Cs>
 point_cloud<Cs...>::point_cloud(
-	const std::vector<typename point_cloud<Cs...>::vertex_t>& n_points
-) : m_points{ n_points } {
+	const std::vector<typename point_cloud<Cs...>::vertex_t>& n_points,
+	const glm::mat4x4& n_pose
+) : m_points{ n_points }, m_num_points{ m_points.size() }, m_pose{ n_pose } {
+	m_chunks = sort_into_chunks(m_points);
+	update_local_bounding_box();
+	update_cpu_memory();
 }
 
 template<vertex_component... Cs>
 point_cloud<Cs...>::point_cloud(
-	std::vector<typename point_cloud<Cs...>::vertex_t>&& n_points
-) : m_points{ std::move(n_points) } {
+	std::vector<typename point_cloud<Cs...>::vertex_t>&& n_points,
+	const glm::mat4x4& n_pose
+) : m_points{ std::move(n_points) }, m_num_points{ m_points.size() }, m_pose{ n_pose } {
+	m_chunks = sort_into_chunks(m_points);
+	update_local_bounding_box();
+	update_cpu_memory();
+}
+
+template<vertex_component... Cs>
+point_cloud<Cs...>::point_cloud(
+	std::vector<typename point_cloud<Cs...>::vertex_t>&& n_points,
+	std::vector<point_cloud_chunk>&& n_chunks,
+	const glm::mat4x4& n_pose
+) :
+	m_points{ std::move(n_points) },
+	m_num_points{ m_points.size() },
+	m_chunks{ std::move(n_chunks) },
+	m_pose{ n_pose } {
+	if (m_chunks.empty()) {
+		m_chunks = sort_into_chunks(m_points);
+	}
+	update_local_bounding_box();
+	update_cpu_memory();
+}
+
+template<vertex_component... Cs>
+point_cloud<Cs...>::point_cloud(
+	std::shared_ptr<const ztu::mapped_file> n_file,
+	const ztu::usize n_offset,
+	const ztu::usize n_num_points,
+	std::vector<point_cloud_chunk>&& n_chunks,
+	const glm::mat4x4& n_pose
+) :
+	m_mapped_file{ std::move(n_file) },
+	m_mapped_offset{ n_offset },
+	m_num_points{ n_num_points },
+	m_chunks{ std::move(n_chunks) },
+	m_pose{ n_pose } {
+	update_local_bounding_box();
 }
 
 template<vertex_component... Cs>
@@ -29,12 +72,29 @@ point_cloud<Cs...>::~point_cloud() {
 
 template<vertex_component... Cs>
 point_cloud<Cs...>::point_cloud(const point_cloud<Cs...>& other) :
-	m_points{ other.m_points } {
+	m_points{ other.m_points },
+	m_source{ other.m_source },
+	m_mapped_file{ other.m_mapped_file },
+	m_mapped_offset{ other.m_mapped_offset },
+	m_num_points{ other.m_num_points },
+	m_chunks{ other.m_chunks },
+	m_local_bounds{ other.m_local_bounds },
+	m_pose{ other.m_pose },
+	m_cpu_memory{ other.m_cpu_memory } {
 }
 
 template<vertex_component... Cs>
 point_cloud<Cs...>::point_cloud(point_cloud<Cs...>&& other) noexcept:
 	m_points{ std::move(other.m_points) },
+	m_source{ std::move(other.m_source) },
+	m_mapped_file{ std::move(other.m_mapped_file) },
+	m_mapped_offset{ other.m_mapped_offset },
+	m_num_points{ other.m_num_points },
+	m_chunks{ std::move(other.m_chunks) },
+	m_local_bounds{ other.m_local_bounds },
+	m_pose{ other.m_pose },
+	m_cpu_memory{ std::move(other.m_cpu_memory) },
+	m_gpu_memory{ std::move(other.m_gpu_memory) },
 	m_vertex_buffer_id{ other.m_vertex_buffer_id },
 	m_vao_id{ other.m_vao_id } {
 	other.m_vao_id = 0;
@@ -45,9 +105,21 @@ template<vertex_component... Cs>
 point_cloud<Cs...>& point_cloud<Cs...>::operator=(const point_cloud<Cs...>& other) {
 
 	if (&other != this) {
-		this->~point_cloud();
+		// The copy gets its own buffer on 'init_vao', the memory counters account for themselves on assignment.
+		if (m_vertex_buffer_id) {
+			glDeleteBuffers(1, &m_vertex_buffer_id);
+		}
 
 		m_points = other.m_points;
+		m_source = other.m_source;
+		m_mapped_file = other.m_mapped_file;
+		m_mapped_offset = other.m_mapped_offset;
+		m_num_points = other.m_num_points;
+		m_chunks = other.m_chunks;
+		m_local_bounds = other.m_local_bounds;
+		m_pose = other.m_pose;
+		m_cpu_memory = other.m_cpu_memory;
+		m_gpu_memory.set(0);
 		m_vao_id = 0;
 		m_vertex_buffer_id = 0;
 	}
@@ -62,6 +134,15 @@ point_cloud<Cs...>& point_cloud<Cs...>::operator=(point_cloud<Cs...>&& other) no
 		glDeleteBuffers(1, &m_vertex_buffer_id);
 
 		m_points = std::move(other.m_points);
+		m_source = std::move(other.m_source);
+		m_mapped_file = std::move(other.m_mapped_file);
+		m_mapped_offset = other.m_mapped_offset;
+		m_num_points = other.m_num_points;
+		m_chunks = std::move(other.m_chunks);
+		m_local_bounds = other.m_local_bounds;
+		m_pose = other.m_pose;
+		m_cpu_memory = std::move(other.m_cpu_memory);
+		m_gpu_memory = std::move(other.m_gpu_memory);
 		m_vao_id = other.m_vao_id;
 		m_vertex_buffer_id = other.m_vertex_buffer_id;
 
@@ -73,37 +154,79 @@ point_cloud<Cs...>& point_cloud<Cs...>::operator=(point_cloud<Cs...>&& other) no
 }
 
 template<vertex_component... Cs>
-void point_cloud<Cs...>::init_vao() {
+void point_cloud<Cs...>::init_vao(upload_scheduler& uploads) {
 
 	if (m_vao_id) {
 		return;
 	}
 
+	const auto zone = ztu::trace::zone("point_cloud::init_vao");
+
 	glGenVertexArrays(1, &m_vao_id);
 	glBindVertexArray(m_vao_id);
 
 	glGenBuffers(1, &m_vertex_buffer_id);
 	glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer_id);
-	glBufferData(GL_ARRAY_BUFFER, m_points.size() * sizeof(vertex_t), &m_points[0], GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer_id);
+	// Mapped files store the components packed in order, while the tuple layout is up to the standard library.
+	static constexpr auto component_sizes = std::array{
+		sizeof(vertex_components::position::type),
+		sizeof(typename Cs::type)...
+	};
+	static constexpr auto packed_vertex_size = std::accumulate(
+		component_sizes.begin(), component_sizes.end(), ztu::usize{ 0 }
+	);
+
+	std::array<ztu::usize, component_sizes.size()> offsets;
+	ztu::usize stride;
+
+	if (m_mapped_file) {
+		const auto size = m_num_points * packed_vertex_size;
+		glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		m_gpu_memory.set(size);
+
+		// Uploaded slices are released right away, so only few slices of the file are resident at a time.
+		uploads.enqueue_buffer(
+			m_vertex_buffer_id,
+			m_mapped_file->data() + m_mapped_offset,
+			size,
+			[file = m_mapped_file](const char* data, const ztu::usize slice_size) {
+				file->release(static_cast<ztu::usize>(data - file->data()), slice_size);
+			}
+		);
+
+		std::exclusive_scan(component_sizes.begin(), component_sizes.end(), offsets.begin(), ztu::usize{ 0 });
+		stride = packed_vertex_size;
+	} else {
+		const auto size = m_points.size() * sizeof(vertex_t);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STATIC_DRAW);
+		m_gpu_memory.set(size);
+
+		uploads.enqueue_buffer(m_vertex_buffer_id, m_points.data(), size);
 
-	const auto& first_vertex = m_points.front();
+		const auto first_vertex = vertex_t{};
+		ztu::for_each::index<std::tuple_size_v<vertex>>(
+			[&]<auto Index>() {
+				offsets[Index] = static_cast<ztu::usize>(
+					reinterpret_cast<const char*>(&std::get<Index>(first_vertex)) -
+						reinterpret_cast<const char*>(&first_vertex)
+				);
+				return false;
+			}
+		);
+		stride = sizeof(vertex_t);
+	}
 
 	ztu::for_each::index<std::tuple_size_v<vertex>>(
-		[&first_vertex]<auto Index>() {
-			const auto offset = static_cast<ztu::usize>(
-				reinterpret_cast<const char*>(&std::get<Index>(first_vertex)) -
-					reinterpret_cast<const char*>(&first_vertex)
-			);
+		[&]<auto Index>() {
 			using component = std::tuple_element_t<Index, vertex>;
 			glVertexAttribPointer(
 				Index,
 				component::count,
 				to_gl_type<typename component::component_type>(),
 				GL_FALSE,
-				sizeof(vertex_t),
-				reinterpret_cast<GLvoid*>(offset)
+				static_cast<GLsizei>(stride),
+				reinterpret_cast<GLvoid*>(offsets[Index])
 			);
 			glEnableVertexAttribArray(Index);
 			return false;
@@ -120,23 +243,134 @@ std::optional<point_cloud_instance> point_cloud<Cs...>::create_instance(const gl
 		return std::nullopt;
 	}
 
-	return point_cloud_instance(m_vao_id, m_points.size(), model_matrix, {});
+	return point_cloud_instance(m_vao_id, num_points(), model_matrix * m_pose, {}, m_chunks);
 }
 
 template<vertex_component... Cs>
-aabb point_cloud<Cs...>::calc_bounding_box() const {
-	aabb box;
-	box.min = glm::vec3{ FLT_MAX, FLT_MAX, FLT_MAX };
-	box.max = glm::vec3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
-	for (const auto& point : m_points) {
-		const auto& position = std::get<0>(point);
-		box.min = glm::min(box.min, position);
-		box.max = glm::max(box.max, position);
+aabb point_cloud<Cs...>::bounding_box() const {
+	auto box = m_local_bounds;
+	if (num_points() != 0) {
+		box.transform(m_pose);
 	}
 	return box;
 }
 
+template<vertex_component... Cs>
+const aabb& point_cloud<Cs...>::local_bounding_box() const {
+	return m_local_bounds;
+}
+
+template<vertex_component... Cs>
+void point_cloud<Cs...>::update_local_bounding_box() {
+	// Chunks always cover all points, so their bounds save a pass over the points.
+	m_local_bounds = {};
+	if (m_chunks.empty()) {
+		m_local_bounds = position_bounds::calc_parallel(m_points.data(), m_points.size());
+	} else {
+		for (const auto& chunk : m_chunks) {
+			m_local_bounds.join(chunk.bounds);
+		}
+	}
+}
+
 template<vertex_component... Cs>
 const std::vector<typename point_cloud<Cs...>::vertex_t>& point_cloud<Cs...>::points() const {
 	return m_points;
 }
+
+template<vertex_component... Cs>
+ztu::usize point_cloud<Cs...>::num_points() const {
+	return m_num_points;
+}
+
+template<vertex_component... Cs>
+void point_cloud<Cs...>::set_source(point_source source) {
+	m_source = std::move(source);
+}
+
+template<vertex_component... Cs>
+bool point_cloud<Cs...>::release_cpu_data() {
+	if (not m_source and not m_mapped_file) {
+		return false;
+	}
+	// Only a swap actually returns the memory.
+	std::vector<vertex_t>().swap(m_points);
+	update_cpu_memory();
+	return true;
+}
+
+template<vertex_component... Cs>
+std::error_code point_cloud<Cs...>::fetch_cpu_data() {
+	if (has_cpu_data()) {
+		return {};
+	}
+
+	if (m_mapped_file) {
+		static constexpr auto vertex_floats = (vertex_components::position::count + ... + Cs::count);
+
+		const auto floats = reinterpret_cast<const float*>(m_mapped_file->data() + m_mapped_offset);
+		m_points.resize(m_num_points);
+		ztu::job_system::shared().parallel_for(
+			m_chunks.size(), [&](const ztu::usize i) {
+				const auto& chunk = m_chunks[i];
+				auto src = floats + chunk.offset * vertex_floats;
+				for (auto j = chunk.offset; j < chunk.offset + chunk.num_points; j++) {
+					src = unpack_vertex(src, m_points[j]);
+				}
+			}
+		);
+		update_cpu_memory();
+		return {};
+	}
+
+	if (not m_source) {
+		return std::make_error_code(std::errc::no_such_file_or_directory);
+	}
+
+	std::vector<vertex_t> points;
+	if (const auto e = m_source(points); e) {
+		return e;
+	}
+	if (points.size() != m_num_points) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+	m_points = std::move(points);
+	update_cpu_memory();
+
+	return {};
+}
+
+template<vertex_component... Cs>
+bool point_cloud<Cs...>::has_cpu_data() const {
+	return m_points.size() == m_num_points;
+}
+
+template<vertex_component... Cs>
+ztu::usize point_cloud<Cs...>::cpu_bytes() const {
+	return m_cpu_memory.bytes();
+}
+
+template<vertex_component... Cs>
+ztu::usize point_cloud<Cs...>::gpu_bytes() const {
+	return m_gpu_memory.bytes();
+}
+
+template<vertex_component... Cs>
+void point_cloud<Cs...>::update_cpu_memory() {
+	m_cpu_memory.set(m_points.capacity() * sizeof(vertex_t));
+}
+
+template<vertex_component... Cs>
+const std::vector<point_cloud_chunk>& point_cloud<Cs...>::chunks() const {
+	return m_chunks;
+}
+
+template<vertex_component... Cs>
+const glm::mat4x4& point_cloud<Cs...>::pose() const {
+	return m_pose;
+}
+
+template<vertex_component... Cs>
+void point_cloud<Cs...>::set_pose(const glm::mat4x4& pose) {
+	m_pose = pose;
+}
@@ -0,0 +1,897 @@
+#ifndef INCLUDE_POINT_CLOUD_IO_IMPLEMENTATION
+#error Never include this file directly include 'point_cloud_io.hpp'
+#endif
+
+
+#include <fstream>
+#include <cfloat>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+#include "util/logger.hpp"
+#include "util/mapped_file.hpp"
+#include "util/buffered_writer.hpp"
+#include "util/job_system.hpp"
+#include "util/memory_stats.hpp"
+#include "util/scratch_arena.hpp"
+#include "util/trace.hpp"
+
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <fcntl.h>
+
+
+#define USE_MMAP_FOR_FILE_LOAD
+#endif
+
+
+namespace point_cloud_loader_internal {
+
+template<bool Reflectance, bool Hex>
+[[nodiscard]] inline std::errc parse_3dtk_line(const char* it, const char* end, glm::vec4& vec) {
+	static constexpr auto num_floats = Reflectance ? 4 : 3;
+
+	for (int i = 0; i < num_floats; i++) {
+		std::from_chars_result result;
+		if constexpr (Hex) {
+			const auto [minus, plus] = std::pair{ *it == '-', *it == '+' };
+			it += plus or minus ? 3 : 2; // skip [-+]?0x
+			result = std::from_chars(it, end, vec[i], std::chars_format::hex);
+			if (minus) {
+				vec[i] *= -1.0;
+			}
+		} else {
+			result = std::from_chars(it, end, vec[i], std::chars_format::general);
+		}
+		if (result.ec != std::errc()) {
+			return result.ec;
+		}
+		it = result.ptr + 1; // skip space in between components
+	}
+
+	return {};
+}
+
+template<bool Reflectance>
+[[nodiscard]] inline auto to_3dtk_vertex(const glm::vec4& vec) {
+	if constexpr (Reflectance) {
+		const auto reflectance = (vec[3] + 20.0f) / 40.0f;
+		return point_cloud_loader::reflectance_vertex(
+			glm::vec3(vec[0], vec[1], vec[2]),
+			glm::vec1(reflectance)
+		);
+	} else {
+		return point_cloud_loader::basic_vertex(
+			glm::vec3(vec[0], vec[1], vec[2])
+		);
+	}
+}
+
+/**
+ * Parses a memory mapped '.3d' file on the shared job system.
+ * The file is split into newline aligned chunks whose lines are counted first.
+ * This way every chunk gets its own slice of the final point buffer and can be
+ * parsed in place without concatenating per thread buffers afterwards.
+ */
+template<bool Reflectance, bool Hex, typename Vertex>
+[[nodiscard]] inline std::error_code parse_3dtk_points_parallel(
+	const std::filesystem::path& filename,
+	std::vector<Vertex>& points,
+	const ztu::usize num_threads
+) {
+	static constexpr auto min_chunk_size = ztu::usize{ 1 } << 20;
+	static constexpr auto chunks_per_thread = ztu::usize{ 4 };
+
+	ztu::mapped_file file;
+	if (const auto e = ztu::mapped_file::open(filename, file, ztu::mapped_file::access_pattern::sequential); e) {
+		return e;
+	}
+
+	const auto begin = file.begin(), end = file.end();
+
+	const auto next_line = [&end](const char* it) {
+		const auto newline = static_cast<const char*>(std::memchr(it, '\n', end - it));
+		return newline ? newline + 1 : end;
+	};
+
+	const auto num_chunks = std::max(
+		std::min(num_threads * chunks_per_thread, file.size() / min_chunk_size),
+		ztu::usize{ 1 }
+	);
+
+	std::vector<const char*> chunk_bounds(num_chunks + 1, begin);
+	for (ztu::usize i = 1; i < num_chunks; i++) {
+		const auto split = std::max(begin + file.size() * i / num_chunks, chunk_bounds[i - 1]);
+		chunk_bounds[i] = split == begin ? begin : next_line(split - 1);
+	}
+	chunk_bounds.back() = end;
+
+	// Count lines to get an upper bound of points per chunk (empty lines are skipped later on).
+	std::vector<ztu::usize> chunk_offsets(num_chunks + 1, 0);
+	auto& jobs = ztu::job_system::shared();
+
+	jobs.parallel_for(
+		num_chunks, [&](const ztu::usize i) {
+			const auto chunk_begin = chunk_bounds[i], chunk_end = chunk_bounds[i + 1];
+			auto num_lines = static_cast<ztu::usize>(std::count(chunk_begin, chunk_end, '\n'));
+			num_lines += chunk_begin != chunk_end and *(chunk_end - 1) != '\n';
+			chunk_offsets[i + 1] = num_lines;
+		}
+	);
+
+	std::partial_sum(chunk_offsets.begin(), chunk_offsets.end(), chunk_offsets.begin());
+
+	const auto base_offset = points.size();
+	points.resize(base_offset + chunk_offsets.back());
+
+	std::vector<std::pair<ztu::usize, std::errc>> chunk_results(num_chunks);
+	jobs.parallel_for(
+		num_chunks, [&](const ztu::usize i) {
+			const auto chunk_end = chunk_bounds[i + 1];
+			auto dst = points.begin() + static_cast<ztu::isize>(base_offset + chunk_offsets[i]);
+			auto& [num_points, error] = chunk_results[i];
+
+			for (auto line = chunk_bounds[i]; line < chunk_end;) {
+				const auto line_end = std::find(line, chunk_end, '\n');
+				if (line_end != line) {
+					glm::vec4 vec;
+					if ((error = parse_3dtk_line<Reflectance, Hex>(line, line_end, vec)) != std::errc()) {
+						return;
+					}
+					dst[num_points++] = to_3dtk_vertex<Reflectance>(vec);
+				}
+				line = line_end + (line_end != chunk_end);
+			}
+		}
+	);
+
+	// Close gaps left by empty lines and drop everything after the first error,
+	// so the result matches the sequential parser.
+	auto write_offset = base_offset;
+	auto error = std::errc();
+	for (ztu::usize i = 0; i < num_chunks and error == std::errc(); i++) {
+		const auto [num_points, chunk_error] = chunk_results[i];
+		const auto read_offset = base_offset + chunk_offsets[i];
+		if (read_offset != write_offset) {
+			std::copy_n(
+				points.begin() + static_cast<ztu::isize>(read_offset),
+				num_points,
+				points.begin() + static_cast<ztu::isize>(write_offset)
+			);
+		}
+		write_offset += num_points;
+		error = chunk_error;
+	}
+	points.resize(write_offset);
+
+	if (error != std::errc()) {
+		return std::make_error_code(error);
+	}
+
+	return {};
+}
+
+template<vertex_component... Cs>
+inline constexpr auto c3d_component_uuids = vertex_component_uuids<vertex_components::position, Cs...>;
+
+template<vertex_component... Cs>
+inline constexpr auto c3d_vertex_floats = (
+	vertex_components::position::count + ... + Cs::count
+);
+
+/**
+ * Parses the header from the first bytes of a '.c3d' file of the given size.
+ * Version 1 headers are converted, so callers only have to handle the difference in payload layout.
+ */
+[[nodiscard]] inline std::error_code parse_c3d_header(
+	std::span<const char> bytes,
+	const ztu::u64 file_size,
+	c3d::header& header
+) {
+	static constexpr auto v1_header_size = sizeof(char) * 2 + sizeof(ztu::u8) * 2 + sizeof(ztu::u32);
+
+	if (bytes.size() < v1_header_size or bytes[0] != c3d::magic_bytes[0] or bytes[1] != c3d::magic_bytes[1]) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	const auto version = static_cast<ztu::u8>(bytes[2]);
+
+	if (version == c3d::version_1) {
+		// Version 1 only ever stored reflectance points with a big endian point count.
+		auto num_points = ztu::u32{};
+		std::reverse_copy(&bytes[4], &bytes[4] + sizeof(num_points), reinterpret_cast<char*>(&num_points));
+		header = c3d::header{};
+		header.version = c3d::version_1;
+		header.num_components = 2;
+		header.component_uuids[0] = vertex_components::position::uuid;
+		header.component_uuids[1] = vertex_components::reflectance::uuid;
+		header.num_points = num_points;
+		header.bounds_min.fill(FLT_MAX);
+		header.bounds_max.fill(-FLT_MAX);
+		const auto identity = glm::identity<glm::mat4>();
+		std::copy_n(&identity[0][0], header.pose.size(), header.pose.begin());
+		return {};
+	}
+
+	if (version != c3d::version_2 or bytes.size() < sizeof(c3d::header)) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	const auto table_size = ztu::u64{ header.num_chunks } * sizeof(c3d::chunk_entry);
+	if (
+		header.num_components == 0 or header.num_components > c3d::max_components or
+		header.codec > c3d::codec::delta_varint or
+		header.chunk_table_offset > file_size or
+		table_size > file_size - header.chunk_table_offset
+	) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	return {};
+}
+
+template<vertex_component... Cs>
+[[nodiscard]] inline bool matches_c3d_schema(const c3d::header& header) {
+	return header.num_components == c3d_component_uuids<Cs...>.size() and std::equal(
+		c3d_component_uuids<Cs...>.begin(), c3d_component_uuids<Cs...>.end(), header.component_uuids.begin()
+	);
+}
+
+[[nodiscard]] inline std::error_code read_c3d_chunk_table(
+	const ztu::mapped_file& file,
+	const c3d::header& header,
+	std::vector<c3d::chunk_entry>& chunk_table
+) {
+	chunk_table.resize(header.num_chunks);
+	std::memcpy(
+		chunk_table.data(),
+		file.data() + header.chunk_table_offset,
+		chunk_table.size() * sizeof(c3d::chunk_entry)
+	);
+
+	auto num_points = ztu::u64{ 0 };
+	for (const auto& entry : chunk_table) {
+		if (
+			entry.payload_offset > file.size() or
+			entry.payload_size > file.size() - entry.payload_offset or
+			entry.num_points > point_cloud_chunk::max_points
+		) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+		num_points += entry.num_points;
+	}
+
+	// The header's count sizes everything that is read from the payload, so it has to match the chunks.
+	if (num_points != header.num_points) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	return {};
+}
+
+[[nodiscard]] inline aabb to_aabb(const c3d::chunk_entry& entry) {
+	aabb bounds;
+	std::copy_n(entry.bounds_min.begin(), 3, &bounds.min[0]);
+	std::copy_n(entry.bounds_max.begin(), 3, &bounds.max[0]);
+	return bounds;
+}
+
+} // namespace point_cloud_loader_internal
+
+
+namespace point_cloud_loader {
+
+std::error_code analyze_3dtk_file(
+	const std::filesystem::path& filename,
+	ztu::u32& num_floats,
+	std::chars_format& format
+) {
+	auto in = std::ifstream(filename);
+
+	if (not in.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	std::string line;
+	std::getline(in, line);
+
+	auto begin = &*line.cbegin();
+	auto end = &*line.cend();
+
+	format = std::chars_format::general;
+	num_floats = 0;
+	float ignore_num;
+
+	for (auto it = begin; it < end; it++) { // skip space in between components
+		it += *it == '-' or *it == '+';
+
+		std::chars_format current_format;
+		if (*it == '0' and it + 1 < end and *(it + 1) == 'x') {
+			it += 2; // skip 0x
+			current_format = std::chars_format::hex;
+		} else {
+			current_format = std::chars_format::general;
+		}
+
+		if (it == begin and current_format != format) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+
+		const auto [next_it, err] = std::from_chars(it, end, ignore_num, current_format);
+		if (err != std::errc()) {
+			return std::make_error_code(err);
+		}
+
+		it = next_it;
+		format = current_format;
+		num_floats++;
+	}
+
+	return {};
+}
+
+std::error_code read_3dtk_pose(
+	const std::filesystem::path& pose_filename,
+	glm::mat4& pose
+) {
+	auto in = std::ifstream(pose_filename);
+	if (not in.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	glm::vec3 offset, rotation;
+	if (
+		in >> std::skipws
+			>> offset[0] >> offset[1] >> offset[2]
+			>> rotation[0] >> rotation[1] >> rotation[2]
+		) {
+		static constexpr auto to_radians = float(M_PI / 180.0);
+		pose = glm::translate(glm::identity<glm::mat4>(), offset);
+		pose *= glm::eulerAngleXYZ(
+			rotation[0] * to_radians,
+			rotation[1] * to_radians,
+			rotation[2] * to_radians
+		);
+	} else {
+		return make_error_code(std::errc::invalid_argument);
+	}
+
+	return {};
+}
+
+std::error_code load_3dtk_scan(
+	const std::filesystem::path& filename,
+	std::vector<basic_vertex>& basic_points,
+	std::vector<reflectance_vertex>& reflectance_points,
+	glm::mat4& pose,
+	const ztu::usize num_threads
+) {
+	ztu::u32 num_floats{};
+	std::chars_format float_format{};
+	if (const auto e = analyze_3dtk_file(filename, num_floats, float_format); e) {
+		return e;
+	}
+
+	auto base_filename = filename;
+	base_filename.replace_extension();
+
+	if (num_floats == 3 && float_format == std::chars_format::general) {
+		return load_from_3dtk_file<false, false>(base_filename, basic_points, reflectance_points, pose, num_threads);
+	} else if (num_floats == 3 && float_format == std::chars_format::hex) {
+		return load_from_3dtk_file<false, true>(base_filename, basic_points, reflectance_points, pose, num_threads);
+	} else if (num_floats == 4 && float_format == std::chars_format::general) {
+		return load_from_3dtk_file<true, false>(base_filename, basic_points, reflectance_points, pose, num_threads);
+	} else if (num_floats == 4 && float_format == std::chars_format::hex) {
+		return load_from_3dtk_file<true, true>(base_filename, basic_points, reflectance_points, pose, num_threads);
+	}
+
+	warn<"Unknown format of % (num_floats: % float_format: %)">(
+		filename.c_str(),
+		num_floats,
+		float_format == std::chars_format::general
+			? "general"
+			: "hex"
+	);
+
+	return std::make_error_code(std::errc::not_supported);
+}
+
+template<bool Reflectance, bool Hex>
+std::error_code load_from_3dtk_file(
+	const std::filesystem::path& base_filename,
+	std::vector<basic_vertex>& basic_points,
+	std::vector<reflectance_vertex>& reflectance_points,
+	glm::mat4& pose,
+	const ztu::usize num_threads
+) {
+	const auto zone = ztu::trace::zone("load_from_3dtk_file", base_filename);
+
+	auto pose_filename = base_filename, point_filename = base_filename;
+	pose_filename.replace_extension(".pose");
+	point_filename.replace_extension(".3d");
+
+	namespace fs = std::filesystem;
+
+	if (not fs::exists(pose_filename) or not fs::exists(point_filename)) {
+		return make_error_code(std::errc::no_such_file_or_directory);
+	}
+
+	if (const auto e = read_3dtk_pose(pose_filename, pose); e) {
+		return e;
+	}
+
+	if constexpr (Reflectance) {
+		// Reflectance scans are mirrored along the x-axis, which is folded into the pose.
+		pose = glm::scale(glm::identity<glm::mat4>(), glm::vec3{ -1.0f, 1.0f, 1.0f }) * pose;
+	}
+
+	auto& points = [&]() -> auto& {
+		if constexpr (Reflectance) {
+			return reflectance_points;
+		} else {
+			return basic_points;
+		}
+	}();
+
+	using namespace point_cloud_loader_internal;
+
+	if (num_threads > 1) {
+		return parse_3dtk_points_parallel<Reflectance, Hex>(point_filename, points, num_threads);
+	}
+
+	auto in = std::ifstream(point_filename);
+	if (not in.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	// The number of points is unknown up front, so they are collected in scratch memory and copied over once.
+	const auto scratch = ztu::scratch_arena::scope();
+	std::pmr::vector<std::remove_cvref_t<decltype(points[0])>> parsed_points(scratch.resource());
+
+	auto error = std::errc();
+	std::string line;
+	while (std::getline(in, line)) {
+		// Empty lines are skipped like in the parallel parser.
+		if (line.empty()) {
+			continue;
+		}
+		glm::vec4 vec;
+		if ((error = parse_3dtk_line<Reflectance, Hex>(line.data(), line.data() + line.size(), vec)) != std::errc()) {
+			break;
+		}
+		parsed_points.push_back(to_3dtk_vertex<Reflectance>(vec));
+	}
+
+	points.reserve(points.size() + parsed_points.size());
+	points.insert(points.end(), parsed_points.begin(), parsed_points.end());
+
+	if (error != std::errc()) {
+		return std::make_error_code(error);
+	}
+
+	return {};
+}
+
+
+[[nodiscard]] inline std::error_code write_v1_c3d_file(
+	const std::filesystem::path& filename,
+	/*const glm::vec3& position,
+	const glm::vec3& direction,*/
+	const std::vector<reflectance_vertex>& points
+) {
+	if (points.size() > ztu::u32_max) {
+		return std::make_error_code(std::errc::value_too_large);
+	}
+
+	ztu::buffered_writer out;
+	if (const auto e = ztu::buffered_writer::open(filename, out); e) {
+		return e;
+	}
+
+	const auto write_float = [&out](const float& f) {
+		out.write(f);
+	};
+
+	const auto write_float_vec = [&out](const glm::vec3& vec) {
+		static constexpr auto packed_size = 3 * sizeof(float);
+		static_assert(sizeof(vec) == packed_size);
+		out.write(&vec[0], packed_size);
+	};
+
+	const auto write_be_int = [&out]<std::integral Int>(Int i) {
+		const auto bytes = reinterpret_cast<char*>(&i);
+		std::reverse(bytes, bytes + sizeof(Int));
+		out.write(bytes, sizeof(Int));
+	};
+
+	// magic bytes
+	out.write('3');
+	out.write('d');
+
+	// version
+	out.write(char{ 1 });
+
+	/*// position
+	write_float_vec(position);
+
+	// direction
+	write_float_vec(direction);*/
+
+	// num components
+	out.write(char{ 4 });
+
+	// num m_vertices
+	write_be_int(static_cast<ztu::u32>(points.size()));
+
+	for (const auto& point : points) {
+		write_float_vec(std::get<0>(point)); // position
+		write_float(std::get<1>(point)[0]); // reflectance
+	}
+
+	return out.close();
+}
+
+std::error_code load_v1_c3d_file(
+	const std::filesystem::path& filename,
+	std::vector<reflectance_vertex>& points
+) {
+	auto in = std::ifstream(filename);
+	if (not in.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	static constexpr auto header_size = std::streamoff(
+		sizeof(ztu::i8) * 2 + sizeof(ztu::u8) * 2 + sizeof(ztu::u32)
+	);
+
+	in.seekg(0, std::ios::end);
+	const auto size = in.tellg();
+
+	if (size == 0 or size == std::numeric_limits<std::streamsize>::max()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	if (size < header_size) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	in.seekg(0, std::ios::beg);
+
+	static constexpr auto magic_bytes = std::array{ '3', 'd', static_cast<char>(1) };
+
+	auto actual_magic_bytes = std::array<char, 3>{};
+	in.read(actual_magic_bytes.data(), actual_magic_bytes.size());
+
+	if (actual_magic_bytes != magic_bytes) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	const auto read_be_int = [&in]<std::integral Int>() {
+		Int value;
+		const auto bytes = reinterpret_cast<char*>(&value);
+		in.read(bytes, sizeof(Int));
+		std::reverse(bytes, bytes + sizeof(Int));
+		return value;
+	};
+
+	const auto num_comps = static_cast<ztu::u8>(in.get());
+	const auto num_vertices = read_be_int.template operator()<ztu::u32>();
+
+	const auto full_size = header_size + (
+		static_cast<std::streamoff>(num_comps) *
+			static_cast<std::streamoff>(num_vertices) *
+			static_cast<std::streamoff>(sizeof(float))
+	);
+
+	if (size != full_size) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	points.resize(num_vertices);
+
+#ifdef USE_MMAP_FOR_FILE_LOAD
+	in.close();
+	const auto fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	const auto bytes = mmap(
+		nullptr,
+		full_size,
+		PROT_READ,
+		MAP_SHARED,
+		fd,
+		0
+	);
+	close(fd);
+
+	if (bytes == std::numeric_limits<decltype(bytes)>::max()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	const auto data = reinterpret_cast<const float*>(static_cast<const ztu::u8*>(bytes) + header_size);
+
+	for (ztu::usize i = 0; i < num_vertices; i++) {
+		auto& point = points[i];
+		const auto vertex = &data[i * ztu::usize(num_comps)];
+		std::copy_n(
+			vertex, 3,
+			reinterpret_cast<float*>(&std::get<0>(point))
+		);
+		std::get<1>(point) = glm::vec1{ vertex[3] };
+	}
+
+	if (munmap(bytes, full_size) != 0) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+#else
+	const auto read_float = [&in]() {
+		float value;
+		in.read(reinterpret_cast<char*>(&value), sizeof(float));
+		return value;
+	};
+
+	const auto read_float_vec3 = [&in]() {
+		glm::vec3 vec;
+		static constexpr auto packed_size = 3 * sizeof(float);
+		static_assert(sizeof(vec) == packed_size);
+		in.read(reinterpret_cast<char*>(&vec[0]), packed_size);
+		return vec;
+	};
+
+	for (auto& point : m_points) {
+		std::get<0>(point) = read_float_vec3();
+		std::get<1>(point) = glm::vec1{ read_float() };
+	}
+#endif
+
+	return {};
+}
+
+template<vertex_component... Cs>
+std::error_code write_v2_c3d_file(
+	const std::filesystem::path& filename,
+	const std::vector<point_cloud_vertex<Cs...>>& points,
+	std::span<const point_cloud_chunk> chunks,
+	const glm::mat4& pose,
+	const c3d::codec codec
+) {
+	using namespace point_cloud_loader_internal;
+
+	static_assert((std::is_same_v<typename Cs::component_type, float> and ...));
+	static_assert(1 + sizeof...(Cs) <= c3d::max_components);
+	static constexpr auto stride = c3d_vertex_floats<Cs...>;
+
+	if (codec > c3d::codec::delta_varint) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	if (chunks.size() > ztu::u32_max) {
+		return std::make_error_code(std::errc::value_too_large);
+	}
+
+	c3d::header header;
+	header.codec = codec;
+	header.num_components = c3d_component_uuids<Cs...>.size();
+	std::copy(c3d_component_uuids<Cs...>.begin(), c3d_component_uuids<Cs...>.end(), header.component_uuids.begin());
+	header.num_chunks = static_cast<ztu::u32>(chunks.size());
+	std::copy_n(&pose[0][0], header.pose.size(), header.pose.begin());
+	header.chunk_table_offset = sizeof(c3d::header);
+
+	aabb bounds;
+	for (const auto& chunk : chunks) {
+		if (
+			chunk.offset < 0 or chunk.num_points < 0 or chunk.num_points > ztu::u32_max or
+			chunk.offset + chunk.num_points > static_cast<ztu::isize>(points.size())
+		) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+		header.num_points += chunk.num_points;
+		bounds.join(chunk.bounds);
+	}
+	std::copy_n(&bounds.min[0], 3, header.bounds_min.begin());
+	std::copy_n(&bounds.max[0], 3, header.bounds_max.begin());
+
+	std::vector<std::vector<ztu::u8>> payloads(chunks.size());
+	ztu::job_system::shared().parallel_for(
+		chunks.size(), [&](const ztu::usize i) {
+			const auto& chunk = chunks[i];
+			std::vector<float> floats(static_cast<ztu::usize>(chunk.num_points) * stride);
+			auto dst = floats.data();
+			for (auto j = chunk.offset; j < chunk.offset + chunk.num_points; j++) {
+				dst = pack_vertex(points[j], dst);
+			}
+
+			auto& payload = payloads[i];
+			if (codec == c3d::codec::delta_varint) {
+				c3d::encode_delta_varint(floats, stride, payload);
+			} else {
+				payload.resize(floats.size() * sizeof(float));
+				std::memcpy(payload.data(), floats.data(), payload.size());
+			}
+		}
+	);
+
+	std::vector<c3d::chunk_entry> chunk_table(chunks.size());
+	auto payload_offset = header.chunk_table_offset + chunk_table.size() * sizeof(c3d::chunk_entry);
+	for (ztu::usize i = 0; i < chunks.size(); i++) {
+		auto& entry = chunk_table[i];
+		entry.payload_offset = payload_offset;
+		entry.payload_size = payloads[i].size();
+		entry.num_points = static_cast<ztu::u32>(chunks[i].num_points);
+		std::copy_n(&chunks[i].bounds.min[0], 3, entry.bounds_min.begin());
+		std::copy_n(&chunks[i].bounds.max[0], 3, entry.bounds_max.begin());
+		entry.reserved = 0;
+		payload_offset += entry.payload_size;
+	}
+
+	ztu::buffered_writer out;
+	if (const auto e = ztu::buffered_writer::open(filename, out); e) {
+		return e;
+	}
+
+	out.write(header);
+	out.write(chunk_table.data(), chunk_table.size() * sizeof(c3d::chunk_entry));
+	for (const auto& payload : payloads) {
+		out.write(payload.data(), payload.size());
+	}
+
+	return out.close();
+}
+
+std::error_code read_c3d_header(
+	const std::filesystem::path& filename,
+	c3d::header& header
+) {
+	auto in = std::ifstream(filename, std::ios::binary);
+	if (not in.is_open()) {
+		return std::make_error_code(static_cast<std::errc>(errno));
+	}
+
+	std::error_code error;
+	const auto size = std::filesystem::file_size(filename, error);
+	if (error) {
+		return error;
+	}
+
+	std::array<char, sizeof(c3d::header)> bytes{};
+	in.read(bytes.data(), bytes.size());
+	const auto num_read = static_cast<ztu::usize>(in.gcount());
+
+	return point_cloud_loader_internal::parse_c3d_header({ bytes.data(), num_read }, size, header);
+}
+
+template<vertex_component... Cs>
+bool has_c3d_schema(const c3d::header& header) {
+	return point_cloud_loader_internal::matches_c3d_schema<Cs...>(header);
+}
+
+template<vertex_component... Cs, typename Select>
+std::error_code load_c3d_chunks(
+	const std::filesystem::path& filename,
+	const Select& select,
+	std::vector<point_cloud_vertex<Cs...>>& points,
+	std::vector<point_cloud_chunk>& chunks,
+	glm::mat4& pose
+) {
+	using namespace point_cloud_loader_internal;
+
+	static constexpr auto stride = c3d_vertex_floats<Cs...>;
+
+	const auto parse_phase = ztu::memory_stats::phase_scope(ztu::memory_stats::phase::parse);
+
+	ztu::mapped_file file;
+	if (const auto e = ztu::mapped_file::open(filename, file, ztu::mapped_file::access_pattern::random); e) {
+		return e;
+	}
+
+	c3d::header header;
+	if (const auto e = parse_c3d_header({ file.data(), file.size() }, file.size(), header); e) {
+		return e;
+	}
+
+	if (not matches_c3d_schema<Cs...>(header)) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	if (header.version == c3d::version_1) {
+		if constexpr (std::is_same_v<point_cloud_vertex<Cs...>, reflectance_vertex>) {
+			file.close();
+			std::vector<reflectance_vertex> v1_points;
+			if (const auto e = load_v1_c3d_file(filename, v1_points); e) {
+				return e;
+			}
+			points.insert(points.end(), v1_points.begin(), v1_points.end());
+			pose = glm::identity<glm::mat4>();
+			return {};
+		} else {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+	}
+
+	std::vector<c3d::chunk_entry> chunk_table;
+	if (const auto e = read_c3d_chunk_table(file, header, chunk_table); e) {
+		return e;
+	}
+
+	std::vector<std::pair<const c3d::chunk_entry*, aabb>> selected_chunks;
+	for (const auto& entry : chunk_table) {
+		const auto bounds = to_aabb(entry);
+		if (select(bounds)) {
+			selected_chunks.emplace_back(&entry, bounds);
+		}
+	}
+
+	const auto base_offset = points.size();
+	std::vector<ztu::usize> chunk_offsets(selected_chunks.size() + 1, base_offset);
+	for (ztu::usize i = 0; i < selected_chunks.size(); i++) {
+		chunk_offsets[i + 1] = chunk_offsets[i] + selected_chunks[i].first->num_points;
+	}
+	points.resize(chunk_offsets.back());
+
+	std::vector<std::error_code> chunk_errors(selected_chunks.size());
+	ztu::job_system::shared().parallel_for(
+		selected_chunks.size(), [&](const ztu::usize i) {
+			const auto& entry = *selected_chunks[i].first;
+			const auto payload = file.data() + entry.payload_offset;
+
+			const auto scratch = ztu::scratch_arena::scope();
+			std::pmr::vector<float> floats(entry.num_points * stride, scratch.resource());
+			if (header.codec == c3d::codec::delta_varint) {
+				chunk_errors[i] = c3d::decode_delta_varint(
+					{ reinterpret_cast<const ztu::u8*>(payload), entry.payload_size }, stride, floats
+				);
+			} else if (entry.payload_size == floats.size() * sizeof(float)) {
+				std::memcpy(floats.data(), payload, entry.payload_size);
+			} else {
+				chunk_errors[i] = std::make_error_code(std::errc::invalid_argument);
+			}
+
+			if (chunk_errors[i]) {
+				return;
+			}
+
+			const float* src = floats.data();
+			for (auto j = chunk_offsets[i]; j < chunk_offsets[i + 1]; j++) {
+				src = unpack_vertex(src, points[j]);
+			}
+		}
+	);
+
+	for (const auto& error : chunk_errors) {
+		if (error) {
+			points.resize(base_offset);
+			return error;
+		}
+	}
+
+	for (ztu::usize i = 0; i < selected_chunks.size(); i++) {
+		chunks.emplace_back(
+			static_cast<ztu::isize>(chunk_offsets[i]),
+			static_cast<ztu::isize>(selected_chunks[i].first->num_points),
+			selected_chunks[i].second
+		);
+	}
+
+	std::copy_n(header.pose.begin(), header.pose.size(), &pose[0][0]);
+
+	return {};
+}
+
+template<vertex_component... Cs>
+std::error_code load_c3d_file(
+	const std::filesystem::path& filename,
+	std::vector<point_cloud_vertex<Cs...>>& points,
+	std::vector<point_cloud_chunk>& chunks,
+	glm::mat4& pose
+) {
+	return load_c3d_chunks<Cs...>(filename, [](const aabb&) { return true; }, points, chunks, pose);
+}
+
+} // namespace point_cloud_loader
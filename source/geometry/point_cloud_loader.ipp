@@ -3,410 +3,292 @@
 #endif
 
 
-#include <fstream>
-#include <charconv>
-#include <glm/gtx/euler_angles.hpp>
+#include <variant>
 #include "util/logger.hpp"
+#include "util/mapped_file.hpp"
+#include "util/job_system.hpp"
+#include "util/memory_stats.hpp"
+#include "util/trace.hpp"
 
 
-#ifdef __linux__
-#include <sys/mman.h>
-#include <fcntl.h>
+namespace point_cloud_loader_internal {
 
+using scan_t = std::variant<std::monostate, basic_point_cloud, reflectance_point_cloud>;
 
-#define USE_MMAP_FOR_FILE_LOAD
-#endif
-
-
-namespace point_cloud_loader {
-
-std::error_code analyze_3dtk_file(
-	const std::filesystem::path& filename,
-	ztu::u32& num_floats,
-	std::chars_format& format
+inline std::error_code list_3dtk_scans(
+	const std::filesystem::path& path,
+	std::vector<std::filesystem::path>& file_paths
 ) {
-	auto in = std::ifstream(filename);
+	namespace fs = std::filesystem;
 
-	if (not in.is_open()) {
-		return std::make_error_code(static_cast<std::errc>(errno));
+	if (not fs::exists(path)) {
+		return make_error_code(std::errc::no_such_file_or_directory);
 	}
 
-	std::string line;
-	std::getline(in, line);
-
-	auto begin = &*line.cbegin();
-	auto end = &*line.cend();
-
-	format = std::chars_format::general;
-	num_floats = 0;
-	float ignore_num;
+	for (const auto& filename : std::filesystem::directory_iterator{ path }) {
+		const auto& file_path = filename.path();
+		if (file_path.extension() == ".3d") {
+			file_paths.push_back(file_path);
+		}
+	}
 
-	for (auto it = begin; it < end; it++) { // skip space in between components
-		it += *it == '-' or *it == '+';
+	std::sort(file_paths.begin(), file_paths.end());
 
-		std::chars_format current_format;
-		if (*it == '0' and it + 1 < end and *(it + 1) == 'x') {
-			it += 2; // skip 0x
-			current_format = std::chars_format::hex;
-		} else {
-			current_format = std::chars_format::general;
-		}
+	return {};
+}
 
-		if (it == begin and current_format != format) {
-			return std::make_error_code(std::errc::invalid_argument);
+/**
+ * Source that parses the scan again and brings the points into the chunk order of the point cloud.
+ */
+template<typename PointCloud>
+typename PointCloud::point_source make_3dtk_source(const std::filesystem::path& file_path) {
+	return [file_path](std::vector<typename PointCloud::vertex_t>& points) -> std::error_code {
+		std::vector<point_cloud_loader::basic_vertex> basic_points;
+		std::vector<point_cloud_loader::reflectance_vertex> reflectance_points;
+		auto pose = glm::identity<glm::mat4>();
+
+		if (const auto e = point_cloud_loader::load_3dtk_scan(
+			file_path, basic_points, reflectance_points, pose, ztu::job_system::shared().num_workers()
+		); e) {
+			return e;
 		}
 
-		const auto [next_it, err] = std::from_chars(it, end, ignore_num, current_format);
-		if (err != std::errc()) {
-			return std::make_error_code(err);
+		if constexpr (std::is_same_v<PointCloud, basic_point_cloud>) {
+			points = std::move(basic_points);
+		} else {
+			points = std::move(reflectance_points);
 		}
 
-		it = next_it;
-		format = current_format;
-		num_floats++;
-	}
+		// Sorting is deterministic, so the points end up in the same order as in the point cloud.
+		[[maybe_unused]] const auto chunks = sort_into_chunks(points);
 
-	return {};
+		return {};
+	};
 }
 
-template<bool Reflectance, bool Hex>
-std::error_code load_from_3dtk_file(
-	const std::filesystem::path& base_filename,
-	std::vector<basic_vertex>& basic_points,
-	std::vector<reflectance_vertex>& reflectance_points
-) {
-
-	auto pose_filename = base_filename, point_filename = base_filename;
-	pose_filename.replace_extension(".pose");
-	point_filename.replace_extension(".3d");
-
-	namespace fs = std::filesystem;
-
-	if (not fs::exists(pose_filename) or not fs::exists(point_filename)) {
-		return make_error_code(std::errc::no_such_file_or_directory);
-	}
+inline scan_t load_3dtk_point_cloud(const std::filesystem::path& file_path, const ztu::usize num_threads) {
+	std::vector<point_cloud_loader::basic_vertex> basic_points;
+	std::vector<point_cloud_loader::reflectance_vertex> reflectance_points;
+	auto pose = glm::identity<glm::mat4>();
 
-	auto transform = glm::identity<glm::mat4>();
+	// The parsed points count as temporaries until the point cloud takes them over.
+	auto points_memory = ztu::memory_stats::counter(ztu::memory_stats::category::loader_temporaries);
+	auto error = std::error_code{};
 	{
-		auto in = std::ifstream(pose_filename);
-		if (not in.is_open()) {
-			return std::make_error_code(static_cast<std::errc>(errno));
-		}
-
-		glm::vec3 offset, rotation;
-		if (
-			in >> std::skipws
-				>> offset[0] >> offset[1] >> offset[2]
-				>> rotation[0] >> rotation[1] >> rotation[2]
-			) {
-			static constexpr auto to_radians = float(M_PI / 180.0);
-			transform = glm::translate(transform, offset);
-			transform *= glm::eulerAngleXYZ(
-				rotation[0] * to_radians,
-				rotation[1] * to_radians,
-				rotation[2] * to_radians
-			);
-		} else {
-			return make_error_code(std::errc::invalid_argument);
-		}
+		const auto parse_phase = ztu::memory_stats::phase_scope(ztu::memory_stats::phase::parse);
+		error = point_cloud_loader::load_3dtk_scan(file_path, basic_points, reflectance_points, pose, num_threads);
+		points_memory.set(
+			basic_points.capacity() * sizeof(basic_points[0]) +
+				reflectance_points.capacity() * sizeof(reflectance_points[0])
+		);
 	}
 
-	{
-		auto in = std::ifstream(point_filename);
-		if (not in.is_open()) {
-			return std::make_error_code(static_cast<std::errc>(errno));
-		}
-
-		std::string line;
-		while (std::getline(in, line)) {
-			glm::vec4 vec;
-			auto it = &*line.cbegin();
-			auto end = &*line.cend();
-
-			static constexpr auto num_floats = Reflectance ? 4 : 3;
-
-			for (int i = 0; i < num_floats; i++) {
-				std::from_chars_result result;
-				if constexpr (Hex) {
-					const auto [minus, plus] = std::pair{ *it == '-', *it == '+' };
-					it += plus or minus ? 3 : 2; // skip [-+]?0x
-					result = std::from_chars(it, end, vec[i], std::chars_format::hex);
-					if (minus) {
-						vec[i] *= -1.0;
-					}
-				} else {
-					result = std::from_chars(it, end, vec[i], std::chars_format::general);
-				}
-				if (result.ec != std::errc()) {
-					return std::make_error_code(result.ec);
-				}
-				it = result.ptr + 1; // skip space in between components
-			}
+	if (error and error != std::errc::not_supported) {
+		warn<"Error while parsing %: '%'">(
+			file_path.c_str(),
+			error.message()
+		);
+	}
 
-			if constexpr (Reflectance) {
-				const auto reflectance = (vec[3] + 20.0f) / 40.0f;
-				vec[3] = 1.0f;
-				const auto position = transform * vec;
-				reflectance_points.emplace_back(
-					glm::vec3(-position[0], position[1], position[2]),
-					glm::vec1(reflectance)
-				);
-			} else {
-				vec[3] = 1.0f;
-				const auto position = transform * vec;
-				basic_points.emplace_back(
-					glm::vec3(position[0], position[1], position[2])
-				);
-			}
-		}
+	if (basic_points.empty() and reflectance_points.empty()) {
+		warn<"Skipping file %: contains no m_vertices">(file_path.c_str());
+	} else if (not basic_points.empty()) {
+		auto cloud = basic_point_cloud(std::move(basic_points), pose);
+		cloud.set_source(make_3dtk_source<basic_point_cloud>(file_path));
+		return cloud;
+	} else if (not reflectance_points.empty()) {
+		auto cloud = reflectance_point_cloud(std::move(reflectance_points), pose);
+		cloud.set_source(make_3dtk_source<reflectance_point_cloud>(file_path));
+		return cloud;
 	}
 
 	return {};
 }
 
+} // namespace point_cloud_loader_internal
+
+
+namespace point_cloud_loader {
+
 std::error_code load_from_3dtk_directory(
 	const std::filesystem::path& path,
 	std::vector<basic_point_cloud>& basic_point_cloud,
 	std::vector<reflectance_point_cloud>& reflectance_point_cloud
 ) {
-	namespace fs = std::filesystem;
+	using namespace point_cloud_loader_internal;
 
-	if (not fs::exists(path)) {
-		return make_error_code(std::errc::no_such_file_or_directory);
+	std::vector<std::filesystem::path> file_paths;
+	if (const auto e = list_3dtk_scans(path, file_paths); e) {
+		return e;
 	}
 
-	for (const auto& filename : std::filesystem::directory_iterator{ path }) {
-		auto file_path = reinterpret_cast<const fs::path&>(filename);
-		if (file_path.extension() != ".3d") {
-			continue;
-		}
-
-		std::error_code error;
-		ztu::u32 num_floats{};
-		std::chars_format float_format{};
-		if ((error = analyze_3dtk_file(file_path.c_str(), num_floats, float_format))) {
-			warn<"Skipping file %: cannot recognize format '%'">(file_path.c_str(), error.message());
-			continue;
-		}
-
-		file_path.replace_extension();
+	auto& jobs = ztu::job_system::shared();
+	const auto num_threads = jobs.num_workers();
 
-		std::vector<basic_vertex> basic_points;
-		std::vector<reflectance_vertex> reflectance_points;
+	// Scans are loaded concurrently but merged in filename order, so results do not depend on timing.
+	std::vector<std::future<scan_t>> scans;
+	scans.reserve(file_paths.size());
 
-		if (num_floats == 3 && float_format == std::chars_format::general) {
-			error = load_from_3dtk_file<false, false>(file_path.c_str(), basic_points, reflectance_points);
-		} else if (num_floats == 3 && float_format == std::chars_format::hex) {
-			error = load_from_3dtk_file<false, true>(file_path.c_str(), basic_points, reflectance_points);
-		} else if (num_floats == 4 && float_format == std::chars_format::general) {
-			error = load_from_3dtk_file<true, false>(file_path.c_str(), basic_points, reflectance_points);
-		} else if (num_floats == 4 && float_format == std::chars_format::hex) {
-			error = load_from_3dtk_file<true, true>(file_path.c_str(), basic_points, reflectance_points);
-		} else {
-			warn<"Skipping file %: unknown format (num_floats: % float_format: %)">(
-				file_path.c_str(),
-				num_floats,
-				float_format == std::chars_format::general
-					? "general"
-					: "hex"
-			);
-			continue;
-		};
-
-		if (error) {
-			warn<"Skipping file %: error while parsing '%'">(
-				file_path.c_str(),
-				error.message()
-			);
-		}
+	for (auto& file_path : file_paths) {
+		scans.push_back(jobs.submit([file_path = std::move(file_path), num_threads]() {
+			return load_3dtk_point_cloud(file_path, num_threads);
+		}));
+	}
 
-		if (basic_points.empty() and reflectance_points.empty()) {
-			warn<"Skipping file %: contains no m_vertices">(file_path.c_str());
-		} else if (not basic_points.empty()) {
-			basic_point_cloud.emplace_back(std::move(basic_points));
-		} else if (not reflectance_points.empty()) {
-			reflectance_point_cloud.emplace_back(std::move(reflectance_points));
+	for (auto& scan_future : scans) {
+		auto scan = jobs.wait(scan_future);
+		if (auto cloud = std::get_if<::basic_point_cloud>(&scan)) {
+			basic_point_cloud.push_back(std::move(*cloud));
+		} else if (auto cloud = std::get_if<::reflectance_point_cloud>(&scan)) {
+			reflectance_point_cloud.push_back(std::move(*cloud));
 		}
 	}
 
 	return {};
 }
 
-
-[[nodiscard]] inline std::error_code write_v1_c3d_file(
-	const std::filesystem::path& filename,
-	/*const glm::vec3& position,
-	const glm::vec3& direction,*/
-	const std::vector<reflectance_vertex>& points
+template<typename Sink>
+std::error_code load_from_3dtk_directory(
+	const std::filesystem::path& path,
+	Sink&& sink
 ) {
-	if (points.size() > ztu::u32_max) {
-		return std::make_error_code(std::errc::value_too_large);
-	}
+	using namespace point_cloud_loader_internal;
 
-	auto out = std::ofstream(filename);
-	if (not out.is_open()) {
-		return std::make_error_code(static_cast<std::errc>(errno));
+	std::vector<std::filesystem::path> file_paths;
+	if (const auto e = list_3dtk_scans(path, file_paths); e) {
+		return e;
 	}
 
-	const auto write_float = [&out](const float& f) {
-		out.write(reinterpret_cast<const char*>(&f), sizeof(float));
-	};
-
-	const auto write_float_vec = [&out](const glm::vec3& vec) {
-		static constexpr auto packed_size = 3 * sizeof(float);
-		static_assert(sizeof(vec) == packed_size);
-		out.write(reinterpret_cast<const char*>(&vec[0]), packed_size);
-	};
-
-	const auto write_be_int = [&out]<std::integral Int>(Int i) {
-		const auto bytes = reinterpret_cast<char*>(&i);
-		std::reverse(bytes, bytes + sizeof(Int));
-		out.write(bytes, sizeof(Int));
-	};
-
-	// magic bytes
-	out.put('3');
-	out.put('d');
-
-	// version
-	out.put(1);
+	auto& jobs = ztu::job_system::shared();
+	const auto num_threads = jobs.num_workers();
 
-	/*// position
-	write_float_vec(position);
+	std::vector<std::future<void>> scans;
+	scans.reserve(file_paths.size());
 
-	// direction
-	write_float_vec(direction);*/
-
-	// num components
-	out.put(4);
-
-	// num m_vertices
-	write_be_int(static_cast<ztu::u32>(points.size()));
+	for (auto& file_path : file_paths) {
+		scans.push_back(jobs.submit([&sink, file_path = std::move(file_path), num_threads]() {
+			auto scan = load_3dtk_point_cloud(file_path, num_threads);
+			if (auto cloud = std::get_if<basic_point_cloud>(&scan)) {
+				sink(std::move(*cloud));
+			} else if (auto cloud = std::get_if<reflectance_point_cloud>(&scan)) {
+				sink(std::move(*cloud));
+			}
+		}));
+	}
 
-	for (const auto& point : points) {
-		write_float_vec(std::get<0>(point)); // position
-		write_float(std::get<1>(point)[0]); // reflectance
+	for (auto& scan_future : scans) {
+		jobs.wait(scan_future);
 	}
 
 	return {};
 }
 
-std::error_code load_v1_c3d_file(
+template<vertex_component... Cs>
+std::error_code load_c3d_point_cloud(
 	const std::filesystem::path& filename,
-	std::vector<reflectance_vertex>& points
+	std::vector<point_cloud<Cs...>>& point_clouds
 ) {
-	auto in = std::ifstream(filename);
-	if (not in.is_open()) {
-		return std::make_error_code(static_cast<std::errc>(errno));
-	}
-
-	static constexpr auto header_size = std::streamoff(
-		sizeof(ztu::i8) * 2 + sizeof(ztu::u8) * 2 + sizeof(ztu::u32)
-	);
+	using namespace point_cloud_loader_internal;
 
-	in.seekg(0, std::ios::end);
-	const auto size = in.tellg();
+	const auto zone = ztu::trace::zone("load_c3d_point_cloud", filename);
 
-	if (size == 0 or size == std::numeric_limits<std::streamsize>::max()) {
-		return std::make_error_code(static_cast<std::errc>(errno));
-	}
+	static constexpr auto vertex_size = c3d_vertex_floats<Cs...> * sizeof(float);
+	static constexpr auto v1_payload_offset = ztu::usize{ 8 };
 
-	if (size < header_size) {
-		return std::make_error_code(std::errc::invalid_argument);
+	auto file = std::make_shared<ztu::mapped_file>();
+	if (const auto e = ztu::mapped_file::open(filename, *file, ztu::mapped_file::access_pattern::sequential); e) {
+		return e;
 	}
 
-	in.seekg(0, std::ios::beg);
-
-	static constexpr auto magic_bytes = std::array{ '3', 'd', static_cast<char>(1) };
-
-	auto actual_magic_bytes = std::array<char, 3>{};
-	in.read(actual_magic_bytes.data(), actual_magic_bytes.size());
-
-	if (actual_magic_bytes != magic_bytes) {
-		return std::make_error_code(std::errc::invalid_argument);
+	c3d::header header;
+	if (const auto e = parse_c3d_header({ file->data(), file->size() }, file->size(), header); e) {
+		return e;
 	}
 
-	const auto read_be_int = [&in]<std::integral Int>() {
-		Int value;
-		const auto bytes = reinterpret_cast<char*>(&value);
-		in.read(bytes, sizeof(Int));
-		std::reverse(bytes, bytes + sizeof(Int));
-		return value;
-	};
-
-	const auto num_comps = static_cast<ztu::u8>(in.get());
-	const auto num_vertices = read_be_int.template operator()<ztu::u32>();
-
-	const auto full_size = header_size + (
-		static_cast<std::streamoff>(num_comps) *
-			static_cast<std::streamoff>(num_vertices) *
-			static_cast<std::streamoff>(sizeof(float))
-	);
-
-	if (size != full_size) {
+	if (not matches_c3d_schema<Cs...>(header)) {
 		return std::make_error_code(std::errc::invalid_argument);
 	}
 
-	points.resize(num_vertices);
+	auto payload_offset = v1_payload_offset;
+	std::vector<point_cloud_chunk> chunks;
 
-#ifdef USE_MMAP_FOR_FILE_LOAD
-	in.close();
-	const auto fd = open(filename.c_str(), O_RDONLY);
-	if (fd == -1) {
-		return std::make_error_code(static_cast<std::errc>(errno));
-	}
+	if (header.version == c3d::version_1) {
+		if (file->size() != v1_payload_offset + header.num_points * vertex_size) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
 
-	const auto bytes = mmap(
-		nullptr,
-		full_size,
-		PROT_READ,
-		MAP_SHARED,
-		fd,
-		0
-	);
-	close(fd);
-
-	if (bytes == std::numeric_limits<decltype(bytes)>::max()) {
-		return std::make_error_code(static_cast<std::errc>(errno));
-	}
+		// Version 1 files have no chunks, so the points are split in file order to still get culling bounds.
+		const auto num_points = static_cast<ztu::isize>(header.num_points);
+		chunks.resize((num_points + point_cloud_chunk::max_points - 1) / point_cloud_chunk::max_points);
+		ztu::job_system::shared().parallel_for(
+			chunks.size(), [&](const ztu::usize i) {
+				auto& chunk = chunks[i];
+				chunk.offset = static_cast<ztu::isize>(i) * point_cloud_chunk::max_points;
+				chunk.num_points = std::min(point_cloud_chunk::max_points, num_points - chunk.offset);
+				const auto vertices = file->data() + payload_offset + chunk.offset * vertex_size;
+				for (ztu::isize j = 0; j < chunk.num_points; j++) {
+					glm::vec3 position;
+					std::memcpy(&position[0], vertices + j * vertex_size, sizeof(position));
+					chunk.bounds.min = glm::min(chunk.bounds.min, position);
+					chunk.bounds.max = glm::max(chunk.bounds.max, position);
+				}
+			}
+		);
+	} else {
+		std::vector<c3d::chunk_entry> chunk_table;
+		if (const auto e = read_c3d_chunk_table(*file, header, chunk_table); e) {
+			return e;
+		}
 
-	const auto data = reinterpret_cast<const float*>(static_cast<const ztu::u8*>(bytes) + header_size);
+		payload_offset = chunk_table.empty() ? file->size() : chunk_table.front().payload_offset;
+
+		// Only uncompressed payloads that follow each other can be uploaded as they are.
+		auto is_contiguous = header.codec == c3d::codec::none;
+		auto offset = payload_offset;
+		for (auto it = chunk_table.begin(); is_contiguous and it != chunk_table.end(); it++) {
+			is_contiguous = it->payload_offset == offset and it->payload_size == it->num_points * vertex_size;
+			chunks.emplace_back(
+				static_cast<ztu::isize>((offset - payload_offset) / vertex_size),
+				static_cast<ztu::isize>(it->num_points),
+				to_aabb(*it)
+			);
+			offset += it->payload_size;
+		}
 
-	for (ztu::usize i = 0; i < num_vertices; i++) {
-		auto& point = points[i];
-		const auto vertex = &data[i * ztu::usize(num_comps)];
-		std::copy_n(
-			vertex, 3,
-			reinterpret_cast<float*>(&std::get<0>(point))
-		);
-		std::get<1>(point) = glm::vec1{ vertex[3] };
+		if (not is_contiguous) {
+			file.reset();
+			std::vector<typename point_cloud<Cs...>::vertex_t> points;
+			auto pose = glm::identity<glm::mat4>();
+			chunks.clear();
+			if (const auto e = load_c3d_file<Cs...>(filename, points, chunks, pose); e) {
+				return e;
+			}
+			auto& cloud = point_clouds.emplace_back(std::move(points), std::move(chunks), pose);
+			cloud.set_source([filename](std::vector<typename point_cloud<Cs...>::vertex_t>& reloaded_points) {
+				std::vector<point_cloud_chunk> reloaded_chunks;
+				auto reloaded_pose = glm::identity<glm::mat4>();
+				return load_c3d_file<Cs...>(filename, reloaded_points, reloaded_chunks, reloaded_pose);
+			});
+			return {};
+		}
 	}
 
-	if (munmap(bytes, full_size) != 0) {
-		return std::make_error_code(static_cast<std::errc>(errno));
+	// The points are uploaded straight from the mapping, so they must not reach past its end.
+	if (
+		payload_offset > file->size() or
+		header.num_points > (file->size() - payload_offset) / vertex_size
+	) {
+		return std::make_error_code(std::errc::invalid_argument);
 	}
-#else
-	const auto read_float = [&in]() {
-		float value;
-		in.read(reinterpret_cast<char*>(&value), sizeof(float));
-		return value;
-	};
 
-	const auto read_float_vec3 = [&in]() {
-		glm::vec3 vec;
-		static constexpr auto packed_size = 3 * sizeof(float);
-		static_assert(sizeof(vec) == packed_size);
-		in.read(reinterpret_cast<char*>(&vec[0]), packed_size);
-		return vec;
-	};
+	auto pose = glm::identity<glm::mat4>();
+	std::copy_n(header.pose.begin(), header.pose.size(), &pose[0][0]);
 
-	for (auto& point : m_points) {
-		std::get<0>(point) = read_float_vec3();
-		std::get<1>(point) = glm::vec1{ read_float() };
-	}
-#endif
+	const auto num_points = static_cast<ztu::usize>(header.num_points);
+	point_clouds.emplace_back(std::move(file), payload_offset, num_points, std::move(chunks), pose);
 
 	return {};
 }
 
-} // namespace point_cloud_loader
\ No newline at end of file
+
+} // namespace point_cloud_loader
@@ -0,0 +1,242 @@
+#include "geometry/synthetic_data.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <glm/glm.hpp>
+#include "util/buffered_writer.hpp"
+
+
+namespace synthetic_data_internal {
+
+/**
+ * SplitMix64, unlike the standard distributions its output is the same everywhere.
+ */
+class split_mix {
+public:
+	explicit split_mix(const ztu::u64 seed) : m_state{ seed } {
+	}
+
+	ztu::u64 next() {
+		auto z = (m_state += 0x9e3779b97f4a7c15);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		return z ^ (z >> 31);
+	}
+
+	// Uniform in [0, 1)
+	float next_float() {
+		return static_cast<float>(next() >> 40) * 0x1p-24f;
+	}
+
+private:
+	ztu::u64 m_state;
+};
+
+glm::vec3 sphere_point(split_mix& rng) {
+	static constexpr auto two_pi = 2.0f * std::numbers::pi_v<float>;
+	const auto z = 2.0f * rng.next_float() - 1.0f;
+	const auto angle = two_pi * rng.next_float();
+	const auto ring_radius = std::sqrt(1.0f - z * z);
+	const auto distance = 5.0f + 45.0f * rng.next_float();
+	return distance * glm::vec3{ ring_radius * std::cos(angle), z, ring_radius * std::sin(angle) };
+}
+
+void write_line(ztu::buffered_writer& out, const char* line, const int length) {
+	out.write(line, static_cast<ztu::usize>(length));
+}
+
+} // namespace synthetic_data_internal
+
+
+namespace synthetic_data {
+
+std::error_code write_grid_obj(
+	const std::filesystem::path& filename,
+	const ztu::u32 grid_size,
+	const bool tex_coords,
+	const bool normals
+) {
+	using namespace synthetic_data_internal;
+
+	if (grid_size < 2) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	ztu::buffered_writer out;
+	if (const auto e = ztu::buffered_writer::open(filename, out); e) {
+		return e;
+	}
+
+	char line[256];
+
+	write_line(out, line, std::snprintf(line, sizeof(line), "# %u x %u grid\no grid\n", grid_size, grid_size));
+
+	const auto scale = 1.0f / static_cast<float>(grid_size - 1);
+	const auto height = [&](const ztu::u32 x, const ztu::u32 y) {
+		return 0.1f * std::sin(12.0f * static_cast<float>(x) * scale) * std::cos(8.0f * static_cast<float>(y) * scale);
+	};
+
+	for (ztu::u32 y = 0; y < grid_size; y++) {
+		for (ztu::u32 x = 0; x < grid_size; x++) {
+			write_line(out, line, std::snprintf(
+				line, sizeof(line), "v %.6f %.6f %.6f\n",
+				static_cast<float>(x) * scale, height(x, y), static_cast<float>(y) * scale
+			));
+		}
+	}
+
+	if (tex_coords) {
+		for (ztu::u32 y = 0; y < grid_size; y++) {
+			for (ztu::u32 x = 0; x < grid_size; x++) {
+				write_line(out, line, std::snprintf(
+					line, sizeof(line), "vt %.6f %.6f\n",
+					static_cast<float>(x) * scale, static_cast<float>(y) * scale
+				));
+			}
+		}
+	}
+
+	if (normals) {
+		for (ztu::u32 y = 0; y < grid_size; y++) {
+			for (ztu::u32 x = 0; x < grid_size; x++) {
+				// Central differences, clamped at the border.
+				const auto x0 = x == 0 ? x : x - 1, x1 = x + 1 == grid_size ? x : x + 1;
+				const auto y0 = y == 0 ? y : y - 1, y1 = y + 1 == grid_size ? y : y + 1;
+				const auto normal = glm::normalize(glm::vec3{
+					(height(x0, y) - height(x1, y)) / (static_cast<float>(x1 - x0) * scale),
+					1.0f,
+					(height(x, y0) - height(x, y1)) / (static_cast<float>(y1 - y0) * scale)
+				});
+				write_line(out, line, std::snprintf(
+					line, sizeof(line), "vn %.6f %.6f %.6f\n", normal.x, normal.y, normal.z
+				));
+			}
+		}
+	}
+
+	// Obj indices start at one, texture coordinates and normals share the index of their position.
+	const auto write_corner = [&](const char* prefix, const ztu::u32 index) {
+		if (tex_coords and normals) {
+			return std::snprintf(line, sizeof(line), "%s%u/%u/%u", prefix, index, index, index);
+		} else if (tex_coords) {
+			return std::snprintf(line, sizeof(line), "%s%u/%u", prefix, index, index);
+		} else if (normals) {
+			return std::snprintf(line, sizeof(line), "%s%u//%u", prefix, index, index);
+		}
+		return std::snprintf(line, sizeof(line), "%s%u", prefix, index);
+	};
+
+	for (ztu::u32 y = 0; y + 1 < grid_size; y++) {
+		for (ztu::u32 x = 0; x + 1 < grid_size; x++) {
+			const auto index = y * grid_size + x + 1;
+			write_line(out, line, write_corner("f ", index));
+			write_line(out, line, write_corner(" ", index + grid_size));
+			write_line(out, line, write_corner(" ", index + grid_size + 1));
+			write_line(out, line, write_corner(" ", index + 1));
+			out.write('\n');
+		}
+	}
+
+	return out.close();
+}
+
+std::error_code write_mtl(
+	const std::filesystem::path& filename,
+	const ztu::u32 num_materials
+) {
+	using namespace synthetic_data_internal;
+
+	ztu::buffered_writer out;
+	if (const auto e = ztu::buffered_writer::open(filename, out); e) {
+		return e;
+	}
+
+	auto rng = split_mix(num_materials);
+	char line[256];
+
+	for (ztu::u32 i = 0; i < num_materials; i++) {
+		write_line(out, line, std::snprintf(
+			line, sizeof(line), "newmtl material_%u\nKd %.6f %.6f %.6f\n",
+			i, rng.next_float(), rng.next_float(), rng.next_float()
+		));
+		if (i % 4 == 0) {
+			write_line(out, line, std::snprintf(line, sizeof(line), "d %.6f\n", 0.25f + 0.75f * rng.next_float()));
+		}
+		out.write('\n');
+	}
+
+	return out.close();
+}
+
+std::error_code write_3dtk_scan(
+	const std::filesystem::path& base_filename,
+	const ztu::u64 num_points,
+	const bool reflectance,
+	const bool hex,
+	const ztu::u32 seed
+) {
+	using namespace synthetic_data_internal;
+
+	auto pose_filename = base_filename, point_filename = base_filename;
+	pose_filename.replace_extension(".pose");
+	point_filename.replace_extension(".3d");
+
+	auto rng = split_mix(seed);
+	char line[256];
+
+	{
+		ztu::buffered_writer out;
+		if (const auto e = ztu::buffered_writer::open(pose_filename, out, 4096); e) {
+			return e;
+		}
+		write_line(out, line, std::snprintf(
+			line, sizeof(line), "%.6f %.6f %.6f\n%.6f %.6f %.6f\n",
+			100.0f * rng.next_float(), rng.next_float(), 100.0f * rng.next_float(),
+			0.0f, 360.0f * rng.next_float(), 0.0f
+		));
+		if (const auto e = out.close(); e) {
+			return e;
+		}
+	}
+
+	ztu::buffered_writer out;
+	if (const auto e = ztu::buffered_writer::open(point_filename, out); e) {
+		return e;
+	}
+
+	// 3dtk writes hexadecimal floats with '%a' as well.
+	const auto format = hex
+		? (reflectance ? "%a %a %a %a\n" : "%a %a %a\n")
+		: (reflectance ? "%.6f %.6f %.6f %.6f\n" : "%.6f %.6f %.6f\n");
+
+	for (ztu::u64 i = 0; i < num_points; i++) {
+		const auto position = sphere_point(rng);
+		// Raw 3dtk reflectance lies in [-20, 20].
+		const auto value = 40.0f * rng.next_float() - 20.0f;
+		const auto length = reflectance
+			? std::snprintf(line, sizeof(line), format, position.x, position.y, position.z, value)
+			: std::snprintf(line, sizeof(line), format, position.x, position.y, position.z);
+		write_line(out, line, length);
+	}
+
+	return out.close();
+}
+
+void generate_points(
+	const ztu::u64 num_points,
+	std::vector<point_cloud_loader::reflectance_vertex>& points,
+	const ztu::u32 seed
+) {
+	using namespace synthetic_data_internal;
+
+	auto rng = split_mix(seed);
+
+	points.reserve(points.size() + num_points);
+	for (ztu::u64 i = 0; i < num_points; i++) {
+		const auto position = sphere_point(rng);
+		points.emplace_back(position, glm::vec1{ rng.next_float() });
+	}
+}
+
+} // namespace synthetic_data
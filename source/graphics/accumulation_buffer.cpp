@@ -0,0 +1,77 @@
+#include "graphics/accumulation_buffer.hpp"
+
+#include "util/logger.hpp"
+
+
+accumulation_buffer::~accumulation_buffer() {
+	release();
+}
+
+std::error_code accumulation_buffer::create(const ztu::u32 width, const ztu::u32 height, accumulation_buffer& dst) {
+	dst.release();
+
+	GLint num_samples{};
+	glGetIntegerv(GL_SAMPLES, &num_samples);
+
+	dst.m_width = width;
+	dst.m_height = height;
+
+	const auto w = static_cast<GLsizei>(width), h = static_cast<GLsizei>(height);
+
+	glGenRenderbuffers(1, &dst.m_color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, dst.m_color_buffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, num_samples, GL_RGBA8, w, h);
+
+	glGenRenderbuffers(1, &dst.m_depth_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, dst.m_depth_buffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, num_samples, GL_DEPTH24_STENCIL8, w, h);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &dst.m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, dst.m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, dst.m_color_buffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, dst.m_depth_buffer);
+
+	const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		error<"Accumulation framebuffer is incomplete: 0x%%">(std::hex, status);
+		dst.release();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	// Multisampled blits need matching formats, which the window does not guarantee, so it is tried once up front.
+	while (glGetError() != GL_NO_ERROR) {}
+	dst.present();
+	if (const auto gl_error = glGetError(); gl_error != GL_NO_ERROR) {
+		error<"Accumulation framebuffer cannot be blitted to the window: 0x%%">(std::hex, gl_error);
+		dst.release();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	return {};
+}
+
+void accumulation_buffer::bind() const {
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+}
+
+void accumulation_buffer::present() const {
+	const auto w = static_cast<GLint>(m_width), h = static_cast<GLint>(m_height);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void accumulation_buffer::release() {
+	if (m_framebuffer != 0) {
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_color_buffer);
+		glDeleteRenderbuffers(1, &m_depth_buffer);
+	}
+	m_framebuffer = m_color_buffer = m_depth_buffer = 0;
+	m_width = m_height = 0;
+}
@@ -0,0 +1,69 @@
+#include "graphics/camera_path.hpp"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+
+std::error_code camera_path::load(const std::filesystem::path& filename, camera_path& dst) {
+	auto in = std::ifstream(filename);
+	if (not in.is_open()) {
+		return std::make_error_code(std::errc::no_such_file_or_directory);
+	}
+
+	dst.inputs.clear();
+
+	auto has_header = false;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() or line.front() == '#') {
+			continue;
+		}
+
+		auto line_stream = std::istringstream(line);
+		if (not has_header) {
+			if (not (line_stream >> dst.delta_time >> dst.spawn.x >> dst.spawn.y >> dst.spawn.z)) {
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+			has_header = true;
+			continue;
+		}
+
+		// Read as a number, as 'u8' would be read as a character.
+		auto keys = unsigned{ 0 };
+		auto& current = dst.inputs.emplace_back();
+		if (not (line_stream >> current.dx >> current.dy >> keys) or keys > 0xFF) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+		current.keys = static_cast<ztu::u8>(keys);
+	}
+
+	if (not has_header or in.bad()) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	return {};
+}
+
+std::error_code camera_path::save(const std::filesystem::path& filename) const {
+	auto out = std::ofstream(filename, std::ios::trunc);
+	if (not out.is_open()) {
+		return std::make_error_code(std::errc::permission_denied);
+	}
+
+	// Exact values, so replays take the very same steps as the recording.
+	out.precision(std::numeric_limits<float>::max_digits10);
+	out << "# delta_time_ms spawn_x spawn_y spawn_z\n";
+	out << delta_time << ' ' << spawn.x << ' ' << spawn.y << ' ' << spawn.z << '\n';
+	out << "# dx dy keys (forward 1, backward 2, right 4, left 8, up 16, down 32, boost 64)\n";
+	for (const auto& current : inputs) {
+		out << current.dx << ' ' << current.dy << ' ' << static_cast<unsigned>(current.keys) << '\n';
+	}
+
+	if (not out.flush()) {
+		return std::make_error_code(std::errc::io_error);
+	}
+
+	return {};
+}
@@ -4,21 +4,52 @@
 #include <SFML/Window/Mouse.hpp>
 #include <cmath>
 #include <numbers>
+#include <utility>
 
 
 flying_camera::flying_camera(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& world_up) :
 	camera(position, direction, world_up) {
 }
 
+bool flying_camera::input::empty() const {
+	return dx == 0 and dy == 0 and keys == 0;
+}
+
+flying_camera::input flying_camera::poll_input(const int dx, const int dy) {
+	using kb = sf::Keyboard;
+	auto keys = ztu::u8{ 0 };
+	for (const auto& [code, key] : {
+		std::pair{ kb::W, input::forward },
+		std::pair{ kb::S, input::backward },
+		std::pair{ kb::D, input::right },
+		std::pair{ kb::A, input::left },
+		std::pair{ kb::Space, input::up },
+		std::pair{ kb::LControl, input::down },
+		std::pair{ kb::LShift, input::boost }
+	}) {
+		if (kb::isKeyPressed(code)) {
+			keys |= key;
+		}
+	}
+	return { .dx = dx, .dy = dy, .keys = keys };
+}
+
 void flying_camera::update(float deltaT, int dx, int dy) {
+	update(deltaT, poll_input(dx, dy));
+}
+
+void flying_camera::update(float deltaT, const input& current) {
 
 	static constexpr auto maxSpeed = 0.01f;
-	static constexpr auto mouseSensitivity = 0.0001f;
+	static constexpr auto minSpeed = 1e-7f;
+	// The mouse delta already covers the whole update, so rotation does not scale with 'deltaT'.
+	// Matches the previous sensitivity at the 60 fps time step.
+	static constexpr auto mouseSensitivity = 0.0001f * (1000.0f / 60.0f);
 	static constexpr auto friction = 1.0f - 0.6f;
 	static constexpr auto pi = std::numbers::pi_v<float>;
 
-	yaw += dx * mouseSensitivity * deltaT;
-	pitch -= dy * mouseSensitivity * deltaT;
+	yaw += current.dx * mouseSensitivity;
+	pitch -= current.dy * mouseSensitivity;
 
 	yaw = std::fmod(yaw, 2.0f * pi);
 	static constexpr float maxAngle = (pi / 2.0f) - std::numeric_limits<float>::epsilon();
@@ -26,11 +57,11 @@ void flying_camera::update(float deltaT, int dx, int dy) {
 
 	glm::vec3 acceleration(0.f, 0.f, 0.f);
 
-	using kb = sf::Keyboard;
+	const auto pressed = [&](const input::key key) { return (current.keys & key) != 0; };
 	static const glm::vec3 noMove{ 0, 0, 0 };
-	acceleration += kb::isKeyPressed(kb::W) ? front : kb::isKeyPressed(kb::S) ? -front : noMove;
-	acceleration += kb::isKeyPressed(kb::D) ? right : kb::isKeyPressed(kb::A) ? -right : noMove;
-	acceleration += kb::isKeyPressed(kb::Space) ? worldUp : kb::isKeyPressed(kb::LControl) ? -worldUp : noMove;
+	acceleration += pressed(input::forward) ? front : pressed(input::backward) ? -front : noMove;
+	acceleration += pressed(input::right) ? right : pressed(input::left) ? -right : noMove;
+	acceleration += pressed(input::up) ? worldUp : pressed(input::down) ? -worldUp : noMove;
 
 	if (glm::length(acceleration) > std::numeric_limits<float>::epsilon()) {
 		velocity += glm::normalize(acceleration);
@@ -41,10 +72,17 @@ void flying_camera::update(float deltaT, int dx, int dy) {
 	const float speed = glm::length(velocity);
 	if (speed > maxSpeed) {
 		velocity *= maxSpeed / speed;
+	} else if (speed < minSpeed) {
+		// Friction alone never brings the camera to a halt.
+		velocity = noMove;
 	}
 
-	const float speedBonus = kb::isKeyPressed(kb::LShift) ? 2.f : 1.f;
+	const float speedBonus = pressed(input::boost) ? 2.f : 1.f;
 	position += velocity * speedBonus * deltaT;
 
 	update_view_matrix();
 }
+
+bool flying_camera::at_rest() const {
+	return velocity == glm::vec3{ 0, 0, 0 };
+}
@@ -0,0 +1,86 @@
+#include "graphics/frame_latency.hpp"
+
+#include <algorithm>
+
+
+frame_latency::frame_latency(ztu::perf_stats::samples& target, const ztu::usize max_frames_in_flight) :
+	m_target{ target },
+	m_max_frames_in_flight{ std::min(max_frames_in_flight, max_pending) } {
+}
+
+frame_latency::~frame_latency() {
+	while (m_size != 0) {
+		pop_oldest();
+	}
+}
+
+void frame_latency::wait() {
+	collect();
+	if (m_max_frames_in_flight == 0) {
+		return;
+	}
+	while (m_size >= m_max_frames_in_flight) {
+		wait_oldest();
+	}
+}
+
+void frame_latency::finish() {
+	while (m_size != 0) {
+		wait_oldest();
+	}
+}
+
+void frame_latency::input_sampled() {
+	m_input_time = clock::now();
+}
+
+void frame_latency::frame_submitted() {
+	if (m_size == max_pending) {
+		pop_oldest();
+		m_num_dropped++;
+	}
+	m_pending[(m_first + m_size) % max_pending] = {
+		.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+		.input_time = m_input_time
+	};
+	m_size++;
+}
+
+void frame_latency::collect() {
+	// Oldest first, frames finish in order.
+	while (m_size != 0) {
+		const auto& oldest = m_pending[m_first];
+		const auto status = glClientWaitSync(oldest.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED and status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		m_target.add(clock::now() - oldest.input_time);
+		pop_oldest();
+	}
+}
+
+void frame_latency::wait_oldest() {
+	static constexpr auto timeout_ns = GLuint64{ 100'000'000 };
+
+	const auto& oldest = m_pending[m_first];
+	// The first wait flushes, otherwise the fence might never reach the GPU.
+	auto flags = GLbitfield{ GL_SYNC_FLUSH_COMMANDS_BIT };
+	GLenum status;
+	while ((status = glClientWaitSync(oldest.fence, flags, timeout_ns)) == GL_TIMEOUT_EXPIRED) {
+		flags = 0;
+	}
+	if (status != GL_WAIT_FAILED) {
+		m_target.add(clock::now() - oldest.input_time);
+	}
+	pop_oldest();
+}
+
+void frame_latency::pop_oldest() {
+	glDeleteSync(m_pending[m_first].fence);
+	m_first = (m_first + 1) % max_pending;
+	m_size--;
+}
+
+ztu::usize frame_latency::num_dropped() const {
+	return m_num_dropped;
+}
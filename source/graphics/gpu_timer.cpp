@@ -0,0 +1,70 @@
+#include "graphics/gpu_timer.hpp"
+
+
+gpu_timer::scope::scope(gpu_timer& timer) : m_timer{ timer } {
+	m_timer.begin();
+}
+
+gpu_timer::scope::~scope() {
+	m_timer.end();
+}
+
+
+gpu_timer::gpu_timer(ztu::perf_stats::samples& target) : m_target{ target } {
+	glGenQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+gpu_timer::~gpu_timer() {
+	glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+void gpu_timer::begin() {
+	// The query is about to be reused, so its result is either read now or never.
+	if (not read_result(m_index) and m_pending[m_index]) {
+		m_num_dropped++;
+	}
+	m_pending[m_index] = false;
+
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_index]);
+}
+
+void gpu_timer::end() {
+	glEndQuery(GL_TIME_ELAPSED);
+	m_pending[m_index] = true;
+	m_index = (m_index + 1) % num_buffers;
+}
+
+void gpu_timer::collect() {
+	// Oldest first, so the samples stay in frame order.
+	for (ztu::usize i = 0; i < num_buffers; i++) {
+		const auto index = (m_index + i) % num_buffers;
+		if (m_pending[index]) {
+			if (not read_result(index)) {
+				break;
+			}
+			m_pending[index] = false;
+		}
+	}
+}
+
+bool gpu_timer::read_result(const ztu::usize index) {
+	if (not m_pending[index]) {
+		return false;
+	}
+
+	GLint available{};
+	glGetQueryObjectiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (not available) {
+		return false;
+	}
+
+	GLuint64 nanoseconds{};
+	glGetQueryObjectui64v(m_queries[index], GL_QUERY_RESULT, &nanoseconds);
+	m_target.add(static_cast<float>(nanoseconds) / 1'000'000.0f);
+
+	return true;
+}
+
+ztu::usize gpu_timer::num_dropped() const {
+	return m_num_dropped;
+}
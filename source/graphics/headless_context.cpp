@@ -0,0 +1,127 @@
+#include "graphics/headless_context.hpp"
+
+#include <array>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "util/logger.hpp"
+
+
+headless_context::~headless_context() {
+	release();
+}
+
+std::error_code headless_context::create(const ztu::u32 width, const ztu::u32 height, headless_context& dst) {
+	dst.release();
+
+	const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT")
+	);
+	if (not get_platform_display) {
+		error<"EGL does not support platform displays">();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	const auto display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY or not eglInitialize(display, nullptr, nullptr)) {
+		error<"Could not initialize surfaceless EGL display: 0x%%">(std::hex, eglGetError());
+		return std::make_error_code(std::errc::not_supported);
+	}
+	dst.m_display = display;
+
+	if (not eglBindAPI(EGL_OPENGL_API)) {
+		error<"EGL does not support desktop OpenGL">();
+		dst.release();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	// Compatibility profile like the viewer's window, llvmpipe only goes up to 4.5.
+	for (const auto& [major, minor] : std::array{ std::pair{ 4, 6 }, std::pair{ 4, 5 } }) {
+		const auto attributes = std::array<EGLint, 7>{
+			EGL_CONTEXT_MAJOR_VERSION, major,
+			EGL_CONTEXT_MINOR_VERSION, minor,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+			EGL_NONE
+		};
+		dst.m_context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes.data());
+		if (dst.m_context != EGL_NO_CONTEXT) {
+			break;
+		}
+	}
+	if (dst.m_context == EGL_NO_CONTEXT) {
+		dst.m_context = nullptr;
+		error<"Could not create OpenGL 4.5 context: 0x%%">(std::hex, eglGetError());
+		dst.release();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	if (not eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, dst.m_context)) {
+		error<"Could not make surfaceless context current: 0x%%">(std::hex, eglGetError());
+		dst.release();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	// 'glewInit' would also look for a GLX display, which does not exist here.
+	glewExperimental = GL_TRUE;
+	if (glewContextInit() != GLEW_OK) {
+		error<"Glew initialization failed">();
+		dst.release();
+		return std::make_error_code(std::errc::not_supported);
+	}
+
+	dst.m_width = width;
+	dst.m_height = height;
+
+	glGenRenderbuffers(1, &dst.m_color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, dst.m_color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+
+	glGenRenderbuffers(1, &dst.m_depth_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, dst.m_depth_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+
+	glGenFramebuffers(1, &dst.m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, dst.m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, dst.m_color_buffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, dst.m_depth_buffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		error<"Offscreen framebuffer is incomplete">();
+		dst.release();
+		return std::make_error_code(std::errc::io_error);
+	}
+
+	glViewport(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+
+	return {};
+}
+
+ztu::u32 headless_context::width() const {
+	return m_width;
+}
+
+ztu::u32 headless_context::height() const {
+	return m_height;
+}
+
+void headless_context::release() {
+	// The ids are only non-zero once glew loaded the functions to delete them.
+	if (m_framebuffer != 0) {
+		glDeleteFramebuffers(1, &m_framebuffer);
+	}
+	if (m_color_buffer != 0) {
+		glDeleteRenderbuffers(1, &m_color_buffer);
+	}
+	if (m_depth_buffer != 0) {
+		glDeleteRenderbuffers(1, &m_depth_buffer);
+	}
+	if (m_context) {
+		eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_display, m_context);
+	}
+	if (m_display) {
+		eglTerminate(m_display);
+	}
+	m_display = m_context = nullptr;
+	m_framebuffer = m_color_buffer = m_depth_buffer = 0;
+	m_width = m_height = 0;
+}
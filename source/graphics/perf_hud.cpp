@@ -0,0 +1,78 @@
+#include "graphics/perf_hud.hpp"
+
+#include <cstdio>
+#include <string>
+
+
+perf_hud::perf_hud(const sf::Font& font) {
+	m_text.setFont(font);
+	m_text.setCharacterSize(14);
+	m_text.setFillColor(sf::Color::White);
+	m_text.setPosition(12.0f, 8.0f);
+	m_background.setFillColor(sf::Color{ 0, 0, 0, 160 });
+	m_background.setPosition(4.0f, 4.0f);
+}
+
+void perf_hud::toggle() {
+	m_visible = not m_visible;
+	// Show current numbers right away instead of the ones from when it was hidden.
+	m_last_update = {};
+}
+
+bool perf_hud::visible() const {
+	return m_visible;
+}
+
+void perf_hud::draw(sf::RenderWindow& window, const ztu::perf_stats& stats) {
+	if (not m_visible) {
+		return;
+	}
+
+	const auto now = ztu::perf_stats::clock::now();
+	if (now - m_last_update >= refresh_interval) {
+		update_text(stats);
+		m_last_update = now;
+	}
+
+	const auto [width, height] = window.getSize();
+
+	window.pushGLStates();
+	window.setView(sf::View(sf::FloatRect(0.0f, 0.0f, float(width), float(height))));
+	window.draw(m_background);
+	window.draw(m_text);
+	window.popGLStates();
+}
+
+void perf_hud::update_text(const ztu::perf_stats& stats) {
+	char line[128];
+	std::string str;
+
+	std::snprintf(
+		line, sizeof(line), "%-12s %8s %6s %6s %8s %6s %6s\n",
+		"ms", "CPU avg", "p95", "p99", "GPU avg", "p95", "p99"
+	);
+	str += line;
+
+	for (const auto& section : stats.sections()) {
+		const auto cpu = section.cpu.summarize();
+		auto length = std::snprintf(
+			line, sizeof(line), "%-12.12s %8.2f %6.2f %6.2f",
+			section.name.c_str(), cpu.average_ms, cpu.p95_ms, cpu.p99_ms
+		);
+		if (section.gpu.size() != 0) {
+			const auto gpu = section.gpu.summarize();
+			std::snprintf(
+				line + length, sizeof(line) - length, " %8.2f %6.2f %6.2f",
+				gpu.average_ms, gpu.p95_ms, gpu.p99_ms
+			);
+		}
+		str += line;
+		str += '\n';
+	}
+	str.pop_back();
+
+	m_text.setString(str);
+
+	const auto bounds = m_text.getGlobalBounds();
+	m_background.setSize({ bounds.left + bounds.width + 4.0f, bounds.top + bounds.height + 4.0f });
+}
@@ -0,0 +1,32 @@
+#include "graphics/point_budget.hpp"
+
+#include <algorithm>
+
+
+point_budget::point_budget(const ztu::usize max_points, const float target_ms) :
+	m_max_points{ max_points },
+	m_min_points{ std::min(max_points, ztu::usize{ 100'000 }) },
+	m_target_ms{ target_ms },
+	m_points{ static_cast<double>(max_points) } {
+}
+
+ztu::usize point_budget::points() const {
+	return static_cast<ztu::usize>(m_points);
+}
+
+void point_budget::update(const ztu::usize num_drawn, const float points_ms, const float other_ms) {
+	if (num_drawn == 0 or points_ms <= 0.0f) {
+		return;
+	}
+
+	const auto drawn = static_cast<double>(num_drawn);
+	auto affordable = drawn * std::max(m_target_ms - other_ms, 0.0f) / points_ms;
+	if (drawn < m_points and affordable >= drawn) {
+		affordable = std::max(affordable, m_points);
+	}
+
+	// Measurements are noisy and arrive a few frames late, so the budget only moves part of the way.
+	static constexpr auto rate = 0.25;
+	m_points += rate * (affordable - m_points);
+	m_points = std::clamp(m_points, static_cast<double>(m_min_points), static_cast<double>(m_max_points));
+}
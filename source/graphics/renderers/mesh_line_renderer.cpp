@@ -1,4 +1,5 @@
 #include "graphics/renderers/mesh_line_renderer.hpp"
+#include "util/trace.hpp"
 #include <util/logger.hpp>
 
 
@@ -7,6 +8,8 @@ void mesh_line_renderer::render(
 	const glm::mat4& proj_matrix,
 	const glm::mat4& view_matrix
 ) {
+	const auto zone = ztu::trace::zone("mesh_line_renderer::render");
+	const auto& gl = gl_api::current();
 	m_line_shader->bind();
 	m_line_shader->set<"proj_mat">(proj_matrix);
 	m_line_shader->set<"view_mat">(view_matrix);
@@ -16,22 +19,22 @@ void mesh_line_renderer::render(
 		m_line_shader->bind();
 		m_line_shader->set<"model_mat">(mesh.transform);
 
-		glBindVertexArray(mesh.vba);
+		gl.bind_vertex_array(mesh.vba);
 
 		for (auto& attribute : mesh.attributes) {
 			attribute.pre_render(*m_line_shader);
 		}
 
-		glPolygonMode(GL_FRONT, GL_LINE);
-		glPolygonMode(GL_BACK, GL_LINE);
-		glDrawElements(GL_TRIANGLES, mesh.num_indices, GL_UNSIGNED_INT, 0);
-		glPolygonMode(GL_FRONT, GL_FILL);
-		glPolygonMode(GL_BACK, GL_FILL);
+		gl.polygon_mode(GL_FRONT, GL_LINE);
+		gl.polygon_mode(GL_BACK, GL_LINE);
+		gl.draw_elements(GL_TRIANGLES, mesh.num_indices, GL_UNSIGNED_INT, 0);
+		gl.polygon_mode(GL_FRONT, GL_FILL);
+		gl.polygon_mode(GL_BACK, GL_FILL);
 
 		for (auto& attribute : mesh.attributes) {
 			attribute.post_render(*m_line_shader);
 		}
 
-		glBindVertexArray(0);
+		gl.bind_vertex_array(0);
 	}
 }
\ No newline at end of file
@@ -1,33 +1,36 @@
 #include "graphics/renderers/mesh_renderer.hpp"
+#include "util/trace.hpp"
 
 void mesh_renderer::render(
 	const std::span<mesh_instance> meshes,
 	const glm::mat4& proj_matrix,
 	const glm::mat4& view_matrix
 ) {
+	const auto zone = ztu::trace::zone("mesh_renderer::render");
+	const auto& gl = gl_api::current();
 	m_mesh_shader->bind();
 	m_mesh_shader->set<"proj_mat">(proj_matrix);
 	m_mesh_shader->set<"view_mat">(view_matrix);
 
 	for (auto& mesh : meshes) {
 		m_mesh_shader->bind();
-		glActiveTexture(GL_TEXTURE0);
+		gl.active_texture(GL_TEXTURE0);
 		
 		m_mesh_shader->set<"model_mat">(mesh.transform);
 
-		glBindVertexArray(mesh.vba);
+		gl.bind_vertex_array(mesh.vba);
 
 		for (auto& attribute : mesh.attributes) {
 			attribute.pre_render(*m_mesh_shader);
 		}
 
-		glDrawElements(GL_TRIANGLES, mesh.num_indices, GL_UNSIGNED_INT, 0);
+		gl.draw_elements(GL_TRIANGLES, mesh.num_indices, GL_UNSIGNED_INT, 0);
 
 		for (auto& attribute : mesh.attributes) {
 			attribute.post_render(*m_mesh_shader);
 		}
 
-		glActiveTexture(0);
-		glBindVertexArray(0);
+		gl.active_texture(0);
+		gl.bind_vertex_array(0);
 	}
 }
\ No newline at end of file
@@ -1,42 +1,298 @@
 #include <graphics/renderers/point_cloud_renderer.hpp>
+#include "geometry/frustum.hpp"
+#include "util/trace.hpp"
 
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
 
-void point_cloud_renderer::render(
+
+point_cloud_renderer::~point_cloud_renderer() {
+	if (m_permutation != 0) {
+		gl_api::current().delete_buffers(1, &m_permutation);
+	}
+}
+
+template<typename DrawVisible>
+void point_cloud_renderer::render_visible(
 	const std::span<point_cloud_instance> point_clouds,
 	const glm::mat4& proj_matrix,
-	const glm::mat4& view_matrix
+	const glm::mat4& view_matrix,
+	const DrawVisible& draw_visible
 ) {
+	const auto& gl = gl_api::current();
 	m_point_shader->bind();
 	m_point_shader->set<"proj_mat">(proj_matrix);
 	m_point_shader->set<"view_mat">(view_matrix);
 
-	glEnable(GL_PROGRAM_POINT_SIZE);
-	glEnable(GL_POINT_SMOOTH);
+	gl.enable(GL_PROGRAM_POINT_SIZE);
+	gl.enable(GL_POINT_SMOOTH);
+
+	const auto view_proj_matrix = proj_matrix * view_matrix;
 
 	for (auto& point_cloud : point_clouds) {
 		m_point_shader->bind();
 		m_point_shader->set<"model_mat">(point_cloud.transform);
 
-		glBindVertexArray(point_cloud.vba);
+		gl.bind_vertex_array(point_cloud.vba);
 
 		for (auto& attribute : point_cloud.attributes) {
 			attribute.pre_render(*m_point_shader);
 		}
 
-		for (ztu::isize i = 0; i < point_cloud.num_points; i += ztu::u16_max) {
-			const auto elements_left = ztu::isize(point_cloud.num_points) - i;
-			glDrawArrays(
+		// Chunks are culled in model space.
+		draw_visible(point_cloud, frustum(view_proj_matrix * point_cloud.transform));
+
+		for (auto& attribute : point_cloud.attributes) {
+			attribute.post_render(*m_point_shader);
+		}
+
+		gl.active_texture(0);
+		gl.bind_vertex_array(0);
+	}
+}
+
+void point_cloud_renderer::render(
+	const std::span<point_cloud_instance> point_clouds,
+	const glm::mat4& proj_matrix,
+	const glm::mat4& view_matrix
+) {
+	const auto zone = ztu::trace::zone("point_cloud_renderer::render");
+	const auto& gl = gl_api::current();
+
+	const auto draw_range = [&gl](const ztu::isize first, const ztu::isize count) {
+		for (ztu::isize i = first; i < first + count; i += ztu::u16_max) {
+			const auto elements_left = first + count - i;
+			gl.draw_arrays(
 				GL_POINTS,
 				static_cast<ztu::i32>(i),
 				static_cast<ztu::u16>(std::min(ztu::isize(ztu::u16_max), elements_left))
 			);
 		}
+	};
 
-		for (auto& attribute : point_cloud.attributes) {
-			attribute.post_render(*m_point_shader);
+	render_visible(
+		point_clouds, proj_matrix, view_matrix,
+		[&](const point_cloud_instance& point_cloud, const frustum& view_volume) {
+			if (point_cloud.chunks.empty()) {
+				draw_range(0, point_cloud.num_points);
+				return;
+			}
+			// Visible neighbours are merged into one draw range.
+			ztu::isize range_begin = 0, range_end = 0;
+			for (const auto& chunk : point_cloud.chunks) {
+				if (not view_volume.intersects(chunk.bounds)) {
+					continue;
+				}
+				if (chunk.offset != range_end) {
+					draw_range(range_begin, range_end - range_begin);
+					range_begin = chunk.offset;
+				}
+				range_end = chunk.offset + chunk.num_points;
+			}
+			draw_range(range_begin, range_end - range_begin);
 		}
+	);
+}
 
-		glActiveTexture(0);
-		glBindVertexArray(0);
+void point_cloud_renderer::enable_slices(const ztu::u32 num_slices) {
+	m_num_slices = std::clamp(num_slices, ztu::u32{ 1 }, static_cast<ztu::u32>(point_cloud_chunk::max_points));
+	if (m_permutation == 0) {
+		create_permutation();
 	}
 }
+
+void point_cloud_renderer::create_permutation() {
+	// Points inside a chunk are sorted along a z-order curve, so every prefix of a random permutation
+	// picks points spread evenly over the chunk. The fixed seed keeps the slices the same between runs.
+	std::vector<ztu::u16> permutation(point_cloud_chunk::max_points);
+	std::iota(permutation.begin(), permutation.end(), ztu::u16{ 0 });
+	std::shuffle(permutation.begin(), permutation.end(), std::mt19937(0x5eed));
+
+	const auto& gl = gl_api::current();
+	gl.gen_buffers(1, &m_permutation);
+	gl.bind_buffer(GL_COPY_WRITE_BUFFER, m_permutation);
+	gl.buffer_data(
+		GL_COPY_WRITE_BUFFER,
+		static_cast<GLsizeiptr>(permutation.size() * sizeof(ztu::u16)),
+		permutation.data(),
+		GL_STATIC_DRAW
+	);
+	gl.bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+ztu::u32 point_cloud_renderer::num_slices() const {
+	return m_num_slices;
+}
+
+void point_cloud_renderer::render_slices(
+	const std::span<point_cloud_instance> point_clouds,
+	const glm::mat4& proj_matrix,
+	const glm::mat4& view_matrix,
+	const ztu::u32 first_slice,
+	const ztu::u32 count
+) {
+	const auto zone = ztu::trace::zone("point_cloud_renderer::render_slices");
+	const auto& gl = gl_api::current();
+
+	const auto slice_begin = [&](const ztu::u32 slice) {
+		return static_cast<ztu::isize>(std::min(slice, m_num_slices)) * point_cloud_chunk::max_points / m_num_slices;
+	};
+	const auto begin = slice_begin(first_slice);
+	const auto end = slice_begin(first_slice + count);
+	if (begin == end) {
+		return;
+	}
+
+	const auto draw_chunk = [&](const ztu::isize offset, const ztu::isize num_points) {
+		if (num_points == point_cloud_chunk::max_points) {
+			gl.draw_elements_base_vertex(
+				GL_POINTS,
+				static_cast<GLsizei>(end - begin),
+				GL_UNSIGNED_SHORT,
+				reinterpret_cast<const void*>(begin * sizeof(ztu::u16)),
+				static_cast<GLint>(offset)
+			);
+		} else if (first_slice == 0) {
+			gl.draw_arrays(GL_POINTS, static_cast<GLint>(offset), static_cast<GLsizei>(num_points));
+		}
+	};
+
+	render_visible(
+		point_clouds, proj_matrix, view_matrix,
+		[&](const point_cloud_instance& point_cloud, const frustum& view_volume) {
+			gl.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_permutation);
+			if (point_cloud.chunks.empty()) {
+				for (ztu::isize offset = 0; offset < point_cloud.num_points; offset += point_cloud_chunk::max_points) {
+					draw_chunk(offset, std::min(point_cloud_chunk::max_points, point_cloud.num_points - offset));
+				}
+				return;
+			}
+			for (const auto& chunk : point_cloud.chunks) {
+				if (view_volume.intersects(chunk.bounds)) {
+					draw_chunk(chunk.offset, chunk.num_points);
+				}
+			}
+		}
+	);
+}
+
+ztu::usize point_cloud_renderer::render_budget(
+	const std::span<point_cloud_instance> point_clouds,
+	const glm::mat4& proj_matrix,
+	const glm::mat4& view_matrix,
+	const ztu::usize max_points
+) {
+	const auto zone = ztu::trace::zone("point_cloud_renderer::render_budget");
+	const auto& gl = gl_api::current();
+
+	if (m_permutation == 0) {
+		create_permutation();
+	}
+
+	const auto view_proj_matrix = proj_matrix * view_matrix;
+
+	// The projected size of a chunk shrinks with the square of its distance. Both are compared in model space,
+	// where the ratio stays the same as long as the transform scales uniformly.
+	m_budget_chunks.clear();
+	for (ztu::usize i = 0; i != point_clouds.size(); ++i) {
+		const auto& point_cloud = point_clouds[i];
+
+		// Clouds without chunks are split like chunks, but without bounds they all get the same weight.
+		if (point_cloud.chunks.empty()) {
+			for (ztu::isize offset = 0; offset < point_cloud.num_points; offset += point_cloud_chunk::max_points) {
+				m_budget_chunks.push_back({
+					.point_cloud = i,
+					.offset = offset,
+					.num_points = std::min(point_cloud_chunk::max_points, point_cloud.num_points - offset),
+					.weight = 1.0f,
+					.num_drawn = 0
+				});
+			}
+			continue;
+		}
+
+		const auto view_volume = frustum(view_proj_matrix * point_cloud.transform);
+		const auto camera_position = glm::vec3(glm::inverse(view_matrix * point_cloud.transform)[3]);
+
+		for (const auto& chunk : point_cloud.chunks) {
+			if (not view_volume.intersects(chunk.bounds)) {
+				continue;
+			}
+			const auto radius = 0.5f * glm::length(chunk.bounds.size());
+			const auto center = 0.5f * (chunk.bounds.min + chunk.bounds.max);
+			const auto distance = std::max(glm::distance(camera_position, center), radius);
+			m_budget_chunks.push_back({
+				.point_cloud = i,
+				.offset = chunk.offset,
+				.num_points = chunk.num_points,
+				// Chunks without extent still get a share.
+				.weight = distance > 0.0f ? std::max((radius * radius) / (distance * distance), 1e-9f) : 1.0f,
+				.num_drawn = 0
+			});
+		}
+	}
+
+	// The budget is handed out in proportion to the weights. Chunks that need fewer points than their share
+	// are served first, whatever they leave is split among the rest.
+	m_budget_order.resize(m_budget_chunks.size());
+	std::iota(m_budget_order.begin(), m_budget_order.end(), ztu::u32{ 0 });
+	std::sort(
+		m_budget_order.begin(), m_budget_order.end(), [&](const ztu::u32 a, const ztu::u32 b) {
+			const auto& lhs = m_budget_chunks[a];
+			const auto& rhs = m_budget_chunks[b];
+			return static_cast<float>(lhs.num_points) * rhs.weight < static_cast<float>(rhs.num_points) * lhs.weight;
+		}
+	);
+
+	auto weight_left = 0.0;
+	for (const auto& chunk : m_budget_chunks) {
+		weight_left += chunk.weight;
+	}
+
+	auto points_left = static_cast<double>(max_points);
+	for (const auto index : m_budget_order) {
+		auto& chunk = m_budget_chunks[index];
+		const auto share = weight_left > 0.0 ? points_left * chunk.weight / weight_left : 0.0;
+		if (chunk.num_points == point_cloud_chunk::max_points) {
+			chunk.num_drawn = std::min(chunk.num_points, static_cast<ztu::isize>(share));
+		} else {
+			// Smaller chunks are not permuted, so they are drawn completely or not at all, whichever is closer.
+			chunk.num_drawn = 2.0 * share >= static_cast<double>(chunk.num_points) ? chunk.num_points : 0;
+		}
+		points_left = std::max(points_left - static_cast<double>(chunk.num_drawn), 0.0);
+		weight_left -= chunk.weight;
+	}
+
+	// Chunks were collected in the order of the clouds, so every cloud draws the next ones.
+	auto num_drawn = ztu::usize{ 0 };
+	auto next_chunk = m_budget_chunks.cbegin();
+	render_visible(
+		point_clouds, proj_matrix, view_matrix,
+		[&](const point_cloud_instance& point_cloud, const frustum&) {
+			const auto index = static_cast<ztu::usize>(&point_cloud - point_clouds.data());
+			gl.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_permutation);
+			for (; next_chunk != m_budget_chunks.cend() and next_chunk->point_cloud == index; ++next_chunk) {
+				const auto& chunk = *next_chunk;
+				if (chunk.num_drawn == 0) {
+					continue;
+				}
+				if (chunk.num_points == point_cloud_chunk::max_points) {
+					gl.draw_elements_base_vertex(
+						GL_POINTS,
+						static_cast<GLsizei>(chunk.num_drawn),
+						GL_UNSIGNED_SHORT,
+						nullptr,
+						static_cast<GLint>(chunk.offset)
+					);
+				} else {
+					gl.draw_arrays(GL_POINTS, static_cast<GLint>(chunk.offset), static_cast<GLsizei>(chunk.num_drawn));
+				}
+				num_drawn += static_cast<ztu::usize>(chunk.num_drawn);
+			}
+		}
+	);
+
+	return num_drawn;
+}
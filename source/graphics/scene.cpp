@@ -0,0 +1,263 @@
+#include "graphics/scene.hpp"
+
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "util/logger.hpp"
+#include "util/job_system.hpp"
+#include "util/rgba_color.hpp"
+#include "geometry/mesh_loader.hpp"
+
+
+scene::scene(const options& opts) :
+	m_options{ opts },
+	m_fallback_color_attr{ std::make_shared<renderable_attributes::color>(glm::vec4(1, 0, 1, 1)) },
+	m_fallback_point_size_attr{ std::make_shared<renderable_attributes::point_size>(3.0f) } {
+	for (auto& attr_ptr : m_colors) {
+		attr_ptr = std::make_shared<renderable_attributes::color>(rgba_colors::random());
+	}
+}
+
+scene::~scene() {
+	auto& jobs = ztu::job_system::shared();
+	for (auto& pending_input : m_pending_inputs) {
+		jobs.wait(pending_input);
+	}
+}
+
+void scene::load(const std::vector<std::filesystem::path>& inputs) {
+	auto& jobs = ztu::job_system::shared();
+
+	m_num_inputs += inputs.size();
+	m_num_inputs_left += inputs.size();
+	m_loaded = false;
+
+	for (const auto& path : inputs) {
+		info<"Loading: %">(path);
+		m_pending_inputs.push_back(jobs.submit(
+			[this, path]() {
+				load_input(path);
+				m_num_inputs_left--;
+			}
+		));
+	}
+}
+
+void scene::load_input(const std::filesystem::path& path) {
+	namespace fs = std::filesystem;
+
+	if (fs::is_directory(path)) {
+		if (const auto e = point_cloud_loader::load_from_3dtk_directory(
+				path, [this](auto&& point_cloud) {
+					m_loaded_assets.push(loaded_asset{ std::move(point_cloud) });
+				}
+			); e) {
+			warn<"Cannot parse directory %: %">(path, e.message());
+		}
+	} else if (path.extension() == ".c3d") {
+		const auto load = [&]<typename PointCloud>() {
+			std::vector<PointCloud> point_clouds;
+			if (const auto e = point_cloud_loader::load_c3d_point_cloud(path, point_clouds); e) {
+				warn<"Cannot read from %: %">(path, e.message());
+			}
+			for (auto& point_cloud : point_clouds) {
+				m_loaded_assets.push(loaded_asset{ std::move(point_cloud) });
+			}
+		};
+		// Scans without reflectance are stored with the position only.
+		c3d::header header;
+		if (const auto e = point_cloud_loader::read_c3d_header(path, header); e) {
+			warn<"Cannot read from %: %">(path, e.message());
+		} else if (point_cloud_loader::has_c3d_schema<>(header)) {
+			load.template operator()<basic_point_cloud>();
+		} else {
+			load.template operator()<reflectance_point_cloud>();
+		}
+	} else if (path.extension() == ".obj" or path.extension() == ".cobj") {
+		mesh_asset asset;
+		if (path.extension() == ".obj") {
+			if (const auto e = mesh_loader::load_from_obj(path, asset.meshes, asset.materials, m_options.pedantic); e) {
+				info<"Cannot parse obj %: %">(path, e.message());
+			}
+		} else {
+			if (const auto e = mesh_loader::load_from_cobj(path, asset.meshes, asset.materials, m_options.pedantic); e) {
+				info<"Cannot read cobj %: %">(path, e.message());
+			}
+		}
+		if (not asset.meshes.empty()) {
+			m_loaded_assets.push(loaded_asset{ std::move(asset) });
+		}
+	} else {
+		warn<"Skipping %">(path);
+	}
+}
+
+bool scene::stream(const upload_scheduler::budget& frame_budget) {
+	if (m_loaded) {
+		return true;
+	}
+
+	// Read the counter first, so all assets of finished inputs are already in the queue.
+	const auto inputs_left = m_num_inputs_left.load();
+
+	m_arrived_assets.clear();
+	m_loaded_assets.take_all(m_arrived_assets);
+
+	for (auto& asset : m_arrived_assets) {
+		if (auto meshes_ptr = std::get_if<mesh_asset>(&asset)) {
+			add_mesh_asset(*meshes_ptr);
+		} else if (auto cloud = std::get_if<basic_point_cloud>(&asset)) {
+			add_point_cloud(m_basic_point_clouds, std::move(*cloud));
+		} else if (auto cloud = std::get_if<reflectance_point_cloud>(&asset)) {
+			add_point_cloud(m_reflectance_point_clouds, std::move(*cloud));
+		}
+	}
+
+	if (not m_arrived_assets.empty()) {
+		if (not m_upload_phase) {
+			m_upload_phase.emplace(ztu::memory_stats::phase::upload);
+		}
+		update_model_transform();
+	}
+
+	m_uploads.run(frame_budget);
+
+	if (inputs_left == 0 and m_uploads.idle()) {
+		m_loaded = true;
+		m_upload_phase.reset();
+
+		debug<"num m_points: %">(m_num_points);
+		debug<"num m_vertices: %">(m_num_vertices);
+		const auto model_size = m_model_box.size();
+		debug<"model size: % % %">(model_size.x, model_size.y, model_size.z);
+		ztu::memory_stats::log_report<logger::level::DBG>();
+		info<"Loading complete">();
+	}
+
+	return m_loaded;
+}
+
+void scene::finish_loading() {
+	auto& jobs = ztu::job_system::shared();
+	for (auto& pending_input : m_pending_inputs) {
+		if (pending_input.valid()) {
+			jobs.wait(pending_input);
+		}
+	}
+	m_pending_inputs.clear();
+
+	static constexpr auto unlimited = upload_scheduler::budget{
+		.max_bytes = ~ztu::usize{ 0 },
+		.max_time = std::chrono::microseconds::max()
+	};
+	while (not stream(unlimited));
+}
+
+bool scene::loaded() const {
+	return m_loaded;
+}
+
+ztu::usize scene::num_inputs() const {
+	return m_num_inputs;
+}
+
+ztu::usize scene::num_inputs_left() const {
+	return m_num_inputs_left.load();
+}
+
+ztu::usize scene::num_pending_upload_bytes() const {
+	return m_uploads.num_pending_bytes();
+}
+
+std::span<mesh_instance> scene::mesh_instances() {
+	return m_mesh_instances;
+}
+
+std::span<point_cloud_instance> scene::point_cloud_instances() {
+	return m_point_cloud_instances;
+}
+
+const glm::mat4& scene::model_transform() const {
+	return m_model_transform;
+}
+
+void scene::log_asset_memory() const {
+	static constexpr auto to_kib = [](const ztu::usize bytes) { return bytes >> 10; };
+	ztu::usize index = 0;
+	for (const auto& mesh : m_meshes) {
+		info<"memory: mesh % (% vertices): % KiB CPU, % KiB GPU">(
+			index++, mesh.num_vertices(), to_kib(mesh.cpu_bytes()), to_kib(mesh.gpu_bytes())
+		);
+	}
+	index = 0;
+	const auto log_point_clouds = [&](const auto& point_clouds) {
+		for (const auto& point_cloud : point_clouds) {
+			info<"memory: point cloud % (% points): % KiB CPU, % KiB GPU">(
+				index++, point_cloud.num_points(), to_kib(point_cloud.cpu_bytes()), to_kib(point_cloud.gpu_bytes())
+			);
+		}
+	};
+	log_point_clouds(m_basic_point_clouds);
+	log_point_clouds(m_reflectance_point_clouds);
+}
+
+void scene::add_mesh_asset(mesh_asset& asset) {
+	m_materials.push_back(std::move(asset.materials));
+	for (auto& loaded_mesh : asset.meshes) {
+		auto& mesh = m_meshes.emplace_back(std::move(loaded_mesh));
+		m_model_box.join(mesh.bounding_box());
+		m_num_vertices += mesh.num_vertices();
+
+		mesh.init_vao(m_uploads);
+		m_uploads.enqueue_callback([this, mesh_ptr = &mesh]() {
+			auto& instance = m_mesh_instances.emplace_back(mesh_ptr->create_instance().value());
+			bool found_color_attr = false;
+			for (auto& attribute : instance.attributes) {
+				if (attribute.index() == 0) {
+					std::get<0>(attribute.attributes) = m_fallback_color_attr;
+					found_color_attr = true;
+				}
+			}
+			if (not found_color_attr) {
+				instance.attributes.emplace_back(m_fallback_color_attr);
+			}
+			instance.attributes.emplace_back(m_fallback_point_size_attr);
+			if (not m_options.keep_geometry) {
+				mesh_ptr->release_cpu_data();
+			}
+		});
+	}
+}
+
+template<class PointCloud>
+void scene::add_point_cloud(std::deque<PointCloud>& point_clouds, PointCloud&& loaded_point_cloud) {
+	auto& point_cloud = point_clouds.emplace_back(std::move(loaded_point_cloud));
+	m_model_box.join(point_cloud.bounding_box());
+	m_num_points += point_cloud.num_points();
+
+	point_cloud.init_vao(m_uploads);
+	m_uploads.enqueue_callback([this, point_cloud_ptr = &point_cloud]() {
+		auto& instance = m_point_cloud_instances.emplace_back(point_cloud_ptr->create_instance().value());
+		instance.attributes.emplace_back(m_fallback_point_size_attr);
+		instance.attributes.emplace_back(m_colors[(m_point_cloud_instances.size() - 1) % 3]);
+		if (not m_options.keep_geometry) {
+			point_cloud_ptr->release_cpu_data();
+		}
+	});
+}
+
+void scene::update_model_transform() {
+	const auto model_size = m_model_box.size();
+	const auto& outer_box = m_options.outer_box;
+	const auto model_scale = std::min(
+		{
+			std::abs(model_size.x) < glm::epsilon<float>() ? 1 : (outer_box.x / model_size.x),
+			std::abs(model_size.y) < glm::epsilon<float>() ? 1 : (outer_box.y / model_size.y),
+			std::abs(model_size.z) < glm::epsilon<float>() ? 1 : (outer_box.z / model_size.z),
+		}
+	);
+
+	m_model_transform = glm::scale(
+		glm::identity<glm::mat4x4>(),
+		{ model_scale, model_scale, model_scale }
+	);
+}
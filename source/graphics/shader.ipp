@@ -16,7 +16,7 @@ void shader<Parameters...>::init(GLuint program_id) {
 	this->m_id = program_id;
 	ztu::for_each::indexed_value<Parameters...>(
 		[&]<auto Index, auto Parameter>() {
-			valueIDs[Index] = glGetUniformLocation(m_id, Parameter.c_str());
+			valueIDs[Index] = gl_api::current().get_uniform_location(m_id, Parameter.c_str());
 			return false;
 		}
 	);
@@ -66,31 +66,35 @@ std::error_code shader<Parameters...>::load_source(const std::filesystem::path&
 
 
 template<ztu::string_literal... Parameters>
-std::error_code shader<Parameters...>::compile(GLenum type, const std::string& source, GLuint& shader_id) {
-	shader_id = glCreateShader(type);
-
-	// Curious choice to take lists as parameters...
-	const auto first_list_element = source.c_str();
-	const auto first_list_element_len = static_cast<GLint>(source.length());
-	glShaderSource(shader_id, 1, &first_list_element, &first_list_element_len);
-	glCompileShader(shader_id);
-
-	GLint success;
-	glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
-	if (not success) {
-		return std::make_error_code(std::errc::invalid_argument);
-	}
+std::error_code shader<Parameters...>::from_files(
+	const std::filesystem::path& vertex_file,
+	const std::filesystem::path& geometry_file,
+	const std::filesystem::path& fragment_file,
+	shader<Parameters...>& dst
+) {
+	auto program = begin_from_files(vertex_file, geometry_file, fragment_file);
+	return dst.finish(program);
+}
 
-	return {};
+
+template<ztu::string_literal... Parameters>
+std::error_code shader<Parameters...>::from_sources(
+	const std::string& vertexSrc,
+	const std::string& geometrySrc,
+	const std::string& fragmentSrc,
+	shader<Parameters...>& dst
+) {
+	auto program = shader_program::begin({ vertexSrc, geometrySrc, fragmentSrc });
+	return dst.finish(program);
 }
 
 
 template<ztu::string_literal... Parameters>
-std::error_code shader<Parameters...>::from_files(
+pending_program shader<Parameters...>::begin_from_files(
 	const std::filesystem::path& vertex_file,
 	const std::filesystem::path& geometry_file,
 	const std::filesystem::path& fragment_file,
-	shader<Parameters...>& dst
+	const program_binary_cache* cache
 ) {
 	std::string vertex_src, geometry_src, fragment_src;
 	for (auto& [file, src] : {
@@ -102,96 +106,49 @@ std::error_code shader<Parameters...>::from_files(
 			warn<"Could not load shader source file %: %">(file, e.message());
 		}
 	}
-	return from_sources(vertex_src, geometry_src, fragment_src, dst);
+	return shader_program::begin({ std::move(vertex_src), std::move(geometry_src), std::move(fragment_src) }, cache);
 }
 
 
 template<ztu::string_literal... Parameters>
-std::error_code shader<Parameters...>::from_sources(
-	const std::string& vertexSrc,
-	const std::string& geometrySrc,
-	const std::string& fragmentSrc,
-	shader<Parameters...>& dst
-) {
-	GLuint vertex_id{}, geometry_id{}, fragment_id{};
-	static constexpr auto
-		vertex_type{ GL_VERTEX_SHADER },
-		geometry_type{ GL_GEOMETRY_SHADER },
-		fragment_type{ GL_FRAGMENT_SHADER };
-
-	const auto program_id = glCreateProgram();
-
-	for (auto& [src, type, id, name] : {
-		std::tie(vertexSrc, vertex_type, vertex_id, "vertex  "),
-		std::tie(geometrySrc, geometry_type, geometry_id, "geometry"),
-		std::tie(fragmentSrc, fragment_type, fragment_id, "fragment")
-	}) {
-		if (src.empty()) {
-			warn<"Proceeding with default % shader">(name);
-		} else if (const auto e = compile(type, src, id); e) {
-			GLint log_length{};
-			glGetShaderiv(id, GL_INFO_LOG_LENGTH, &log_length);
-			auto log = std::string(log_length, ' ');
-			glGetShaderInfoLog(id, log_length, nullptr, log.data());
-			warn<"Failed compiling % shader:\n%\n">(name, log);
-			warn<"Proceeding with default shader.">();
-		} else {
-			glAttachShader(program_id, id);
-		}
-	}
-
-	glLinkProgram(program_id);
-
-	GLint success;
-	glGetProgramiv(program_id, GL_LINK_STATUS, &success);
-	if (not success) {
-		GLint log_length{};
-		glGetShaderiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
-		auto log = std::string(log_length, ' ');
-		glGetProgramInfoLog(program_id, log_length, nullptr, log.data());
-		return std::make_error_code(std::errc::io_error);
+std::error_code shader<Parameters...>::finish(pending_program& program, const program_binary_cache* cache) {
+	GLuint program_id;
+	if (const auto e = shader_program::finish(program, program_id, cache); e) {
+		return e;
 	}
-
-	glUseProgram(0);
-
-	for (const auto& id : { vertex_id, geometry_id, fragment_id }) {
-		if (id) {
-			glDeleteShader(id);
-		}
-	}
-
-	dst.init(program_id);
-
+	init(program_id);
 	return {};
 }
 
 template<ztu::string_literal... Parameters>
 template<ztu::string_literal Parameter, typename T>
 void shader<Parameters...>::set(const T& value) {
+	const auto& gl = gl_api::current();
+
 	constexpr auto value_index_opt = indexer.index_of(Parameter);
 	GLint valueID;
 	if constexpr (value_index_opt) {
 		valueID = valueIDs[value_index_opt.value()];
 	} else {
 		// constexpr auto _using_uncached_uniform = Parameter.c_str(); // warning
-		valueID = glGetUniformLocation(m_id, Parameter.c_str());
+		valueID = gl.get_uniform_location(m_id, Parameter.c_str());
 	}
 
 	//bind();
 	if constexpr (std::same_as<T, glm::mat4x4>)
-		glUniformMatrix4fv(valueID, 1, false, glm::value_ptr(value));
+		gl.uniform_matrix4fv(valueID, 1, false, glm::value_ptr(value));
 	else if constexpr (std::same_as<T, glm::mat3x3>)
-		glUniformMatrix3fv(valueID, 1, false, glm::value_ptr(value));
+		gl.uniform_matrix3fv(valueID, 1, false, glm::value_ptr(value));
 	else if constexpr (std::same_as<T, glm::fvec4>)
-		glUniform4fv(valueID, 1, glm::value_ptr(value));
+		gl.uniform4fv(valueID, 1, glm::value_ptr(value));
 	else if constexpr (std::same_as<T, glm::fvec3>)
-		glUniform3fv(valueID, 1, glm::value_ptr(value));
+		gl.uniform3fv(valueID, 1, glm::value_ptr(value));
 	else if constexpr (std::same_as<T, glm::fvec2>)
-		glUniform2fv(valueID, 1, glm::value_ptr(value));
+		gl.uniform2fv(valueID, 1, glm::value_ptr(value));
 	else if constexpr (std::same_as<T, float>)
-		glUniform1f(valueID, value);
+		gl.uniform1f(valueID, value);
 	else if constexpr (std::same_as<T, int>)
-		glUniform1i(valueID, value);
+		gl.uniform1i(valueID, value);
 	else {
 		T::_unknown_shader_uniform;
 	}
@@ -201,16 +158,16 @@ void shader<Parameters...>::set(const T& value) {
 template<ztu::string_literal... Parameters>
 shader<Parameters...>::~shader() {
 	if (m_id) {
-		glDeleteProgram(m_id);
+		gl_api::current().delete_program(m_id);
 	}
 }
 
 template<ztu::string_literal... Parameters>
 void shader<Parameters...>::bind() {
-	glUseProgram(m_id);
+	gl_api::current().use_program(m_id);
 }
 
 template<ztu::string_literal... Parameters>
 void shader<Parameters...>::unbind() {
-	glUseProgram(0);
+	gl_api::current().use_program(0);
 }
@@ -0,0 +1,293 @@
+#include "graphics/shader_program.hpp"
+
+#include <cstdio>
+#include <vector>
+#include <fstream>
+#include <utility>
+#include "util/uix.hpp"
+#include "util/logger.hpp"
+#include "util/trace.hpp"
+
+
+namespace shader_program_internal {
+
+static constexpr std::array<GLenum, 3> stage_types{ GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+static constexpr std::array<const char*, 3> stage_names{ "vertex  ", "geometry", "fragment" };
+
+// FNV-1a, the key only has to change with the sources and the driver.
+ztu::u64 hash(const std::string_view& str, ztu::u64 value = 0xcbf29ce484222325) {
+	for (const auto c : str) {
+		value = (value ^ static_cast<ztu::u8>(c)) * 0x100000001b3;
+	}
+	return value;
+}
+
+std::string get_string(const GLenum name) {
+	const auto str = glGetString(name);
+	return str ? reinterpret_cast<const char*>(str) : "";
+}
+
+std::string shader_log(const GLuint shader_id) {
+	GLint log_length{};
+	glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
+	auto log = std::string(log_length, ' ');
+	glGetShaderInfoLog(shader_id, log_length, nullptr, log.data());
+	return log;
+}
+
+std::string program_log(const GLuint program_id) {
+	GLint log_length{};
+	glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
+	auto log = std::string(log_length, ' ');
+	glGetProgramInfoLog(program_id, log_length, nullptr, log.data());
+	return log;
+}
+
+bool is_linked(const GLuint program_id) {
+	GLint success;
+	glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+	return success;
+}
+
+void delete_shaders(pending_program& program) {
+	for (auto& id : program.shader_ids) {
+		if (id) {
+			glDetachShader(program.program_id, id);
+			glDeleteShader(id);
+			id = 0;
+		}
+	}
+}
+
+/**
+ * Issues the compile and link commands, linking right away is fine as a failed stage only shows in the link status.
+ */
+void compile_and_link(pending_program& program, const bool retrievable) {
+	if (retrievable) {
+		glProgramParameteri(program.program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	for (ztu::usize i = 0; i < stage_types.size(); i++) {
+		const auto& source = program.sources[i];
+		if (source.empty()) {
+			warn<"Proceeding with default % shader">(stage_names[i]);
+			continue;
+		}
+
+		const auto id = glCreateShader(stage_types[i]);
+		const auto source_ptr = source.c_str();
+		const auto source_length = static_cast<GLint>(source.length());
+		glShaderSource(id, 1, &source_ptr, &source_length);
+		glCompileShader(id);
+		glAttachShader(program.program_id, id);
+		program.shader_ids[i] = id;
+	}
+
+	glLinkProgram(program.program_id);
+}
+
+} // namespace shader_program_internal
+
+
+program_binary_cache::program_binary_cache(std::filesystem::path directory) : m_directory{ std::move(directory) } {
+	using namespace shader_program_internal;
+
+	GLint num_formats{};
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+	auto error = std::error_code{};
+	std::filesystem::create_directories(m_directory, error);
+
+	m_enabled = num_formats > 0 and not error;
+
+	// Binaries are only valid for the exact driver, which usually shows in its version string.
+	m_driver = (
+		get_string(GL_VENDOR) + '\n' +
+			get_string(GL_RENDERER) + '\n' +
+			get_string(GL_VERSION) + '\n' +
+			get_string(GL_SHADING_LANGUAGE_VERSION)
+	);
+}
+
+bool program_binary_cache::enabled() const {
+	return m_enabled;
+}
+
+std::string program_binary_cache::key(const std::array<std::string, 3>& sources) const {
+	using namespace shader_program_internal;
+
+	auto value = hash(m_driver);
+	for (const auto& source : sources) {
+		// Include the size, so moving text between stages changes the key.
+		value = hash(std::to_string(source.size()), value);
+		value = hash(source, value);
+	}
+
+	char key[17];
+	std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(value));
+	return key;
+}
+
+bool program_binary_cache::load(const std::string& key, const GLuint program_id) const {
+	if (not m_enabled) {
+		return false;
+	}
+
+	auto file = std::ifstream(m_directory / (key + ".bin"), std::ios::binary | std::ios::ate);
+	if (not file.is_open()) {
+		return false;
+	}
+
+	const auto size = static_cast<ztu::isize>(file.tellg()) - static_cast<ztu::isize>(sizeof(GLenum));
+	if (size <= 0) {
+		return false;
+	}
+
+	GLenum format;
+	std::vector<char> binary(size);
+	file.seekg(0);
+	if (not file.read(reinterpret_cast<char*>(&format), sizeof(format)) or not file.read(binary.data(), size)) {
+		return false;
+	}
+
+	glProgramBinary(program_id, format, binary.data(), static_cast<GLsizei>(size));
+
+	return true;
+}
+
+void program_binary_cache::store(const std::string& key, const GLuint program_id) const {
+	if (not m_enabled) {
+		return;
+	}
+
+	GLint size{};
+	glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0) {
+		return;
+	}
+
+	GLenum format;
+	std::vector<char> binary(size);
+	glGetProgramBinary(program_id, size, nullptr, &format, binary.data());
+
+	// Written under a temporary name first, so other instances never read a partial binary.
+	const auto filename = m_directory / (key + ".bin");
+	auto temp_filename = filename;
+	temp_filename += ".tmp";
+	{
+		auto file = std::ofstream(temp_filename, std::ios::binary | std::ios::trunc);
+		if (
+			not file.is_open() or
+			not file.write(reinterpret_cast<const char*>(&format), sizeof(format)) or
+			not file.write(binary.data(), size)
+		) {
+			warn<"Could not write shader cache file %">(temp_filename);
+			return;
+		}
+	}
+
+	auto error = std::error_code{};
+	std::filesystem::rename(temp_filename, filename, error);
+	if (error) {
+		warn<"Could not write shader cache file %: %">(filename, error.message());
+	}
+}
+
+
+void shader_program::enable_parallel_compile() {
+#ifdef GL_KHR_parallel_shader_compile
+	if (glewIsSupported("GL_KHR_parallel_shader_compile")) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		return;
+	}
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+	if (glewIsSupported("GL_ARB_parallel_shader_compile")) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+#endif
+}
+
+pending_program shader_program::begin(std::array<std::string, 3> sources, const program_binary_cache* cache) {
+	const auto zone = ztu::trace::zone("shader_program::begin");
+	using namespace shader_program_internal;
+
+	pending_program program;
+	program.sources = std::move(sources);
+	program.program_id = glCreateProgram();
+
+	const auto use_cache = cache and cache->enabled();
+	if (use_cache) {
+		program.cache_key = cache->key(program.sources);
+		if (cache->load(program.cache_key, program.program_id)) {
+			program.from_cache = true;
+			return program;
+		}
+	}
+
+	compile_and_link(program, use_cache);
+
+	return program;
+}
+
+std::error_code shader_program::finish(pending_program& program, GLuint& program_id, const program_binary_cache* cache) {
+	const auto zone = ztu::trace::zone("shader_program::finish");
+	using namespace shader_program_internal;
+
+	if (program.from_cache) {
+		if (is_linked(program.program_id)) {
+			program_id = std::exchange(program.program_id, 0);
+			return {};
+		}
+
+		// The driver rejected the binary (for example after an update), so the program is built as usual.
+		debug<"Cached shader binary % is outdated">(program.cache_key);
+		glDeleteProgram(program.program_id);
+		program.program_id = glCreateProgram();
+		program.from_cache = false;
+		compile_and_link(program, true);
+	}
+
+	auto relink = false;
+	if (not is_linked(program.program_id)) {
+		for (ztu::usize i = 0; i < stage_types.size(); i++) {
+			auto& id = program.shader_ids[i];
+			if (not id) {
+				continue;
+			}
+			GLint success;
+			glGetShaderiv(id, GL_COMPILE_STATUS, &success);
+			if (not success) {
+				warn<"Failed compiling % shader:\n%\n">(stage_names[i], shader_log(id));
+				warn<"Proceeding with default shader.">();
+				glDetachShader(program.program_id, id);
+				glDeleteShader(id);
+				id = 0;
+				relink = true;
+			}
+		}
+
+		if (relink) {
+			glLinkProgram(program.program_id);
+		}
+
+		if (not relink or not is_linked(program.program_id)) {
+			warn<"Failed linking shader program:\n%\n">(program_log(program.program_id));
+			delete_shaders(program);
+			glDeleteProgram(program.program_id);
+			program.program_id = 0;
+			return std::make_error_code(std::errc::io_error);
+		}
+	}
+
+	delete_shaders(program);
+
+	// A program missing a broken stage would otherwise load from the cache next time, without the warning.
+	if (cache and not program.cache_key.empty() and not relink) {
+		cache->store(program.cache_key, program.program_id);
+	}
+
+	program_id = std::exchange(program.program_id, 0);
+
+	return {};
+}
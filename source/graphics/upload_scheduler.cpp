@@ -0,0 +1,141 @@
+#include "graphics/upload_scheduler.hpp"
+#include "util/trace.hpp"
+#include <algorithm>
+
+
+void upload_scheduler::enqueue_buffer(
+	const GLuint buffer,
+	const void* data,
+	const ztu::usize size,
+	slice_callback on_slice_uploaded
+) {
+	if (size == 0) {
+		return;
+	}
+	m_tasks.push_back({
+		.type = task_type::buffer,
+		.id = buffer,
+		.data = static_cast<const char*>(data),
+		.size = size,
+		.row_size = 1,
+		.offset = 0,
+		.on_slice_uploaded = std::move(on_slice_uploaded)
+	});
+	m_num_pending_bytes += size;
+}
+
+void upload_scheduler::enqueue_texture(
+	const GLuint texture,
+	const ztu::usize width,
+	const ztu::usize height,
+	const void* data
+) {
+	if (width == 0 or height == 0) {
+		return;
+	}
+	const auto row_size = width * 4;
+	m_tasks.push_back({
+		.type = task_type::texture,
+		.id = texture,
+		.data = static_cast<const char*>(data),
+		.size = row_size * height,
+		.row_size = row_size,
+		.offset = 0
+	});
+	m_num_pending_bytes += row_size * height;
+}
+
+void upload_scheduler::enqueue_callback(std::function<void()> callback) {
+	m_tasks.push_back({ .type = task_type::callback, .callback = std::move(callback) });
+}
+
+void upload_scheduler::run(const budget& frame_budget) {
+	const auto zone = ztu::trace::zone("upload_scheduler::run");
+	const auto start = std::chrono::steady_clock::now();
+	ztu::usize num_bytes = 0;
+
+	while (not m_tasks.empty()) {
+		num_bytes += upload_slice();
+		if (
+			num_bytes >= frame_budget.max_bytes or
+			std::chrono::steady_clock::now() - start >= frame_budget.max_time
+		) {
+			break;
+		}
+	}
+
+	// Callbacks that are due do not cost any upload time.
+	while (not m_tasks.empty() and m_tasks.front().type == task_type::callback) {
+		upload_slice();
+	}
+}
+
+void upload_scheduler::flush() {
+	while (not m_tasks.empty()) {
+		upload_slice();
+	}
+}
+
+bool upload_scheduler::idle() const {
+	return m_tasks.empty();
+}
+
+ztu::usize upload_scheduler::num_pending_bytes() const {
+	return m_num_pending_bytes;
+}
+
+ztu::usize upload_scheduler::upload_slice() {
+	auto& current = m_tasks.front();
+
+	if (current.type == task_type::callback) {
+		const auto callback = std::move(current.callback);
+		m_tasks.pop_front();
+		callback();
+		return 0;
+	}
+
+	// Texture slices are cut at row boundaries.
+	const auto max_size = std::max(slice_size / current.row_size, ztu::usize{ 1 }) * current.row_size;
+	const auto size = std::min(max_size, current.size - current.offset);
+	const auto data = current.data + current.offset;
+
+	if (current.type == task_type::buffer) {
+		// The copy target keeps the vertex array bindings untouched.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, current.id);
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			static_cast<GLintptr>(current.offset),
+			static_cast<GLsizeiptr>(size),
+			data
+		);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	} else {
+		const auto width = current.row_size / 4;
+		glBindTexture(GL_TEXTURE_2D, current.id);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(
+			GL_TEXTURE_2D, 0,
+			0, static_cast<GLint>(current.offset / current.row_size),
+			static_cast<GLsizei>(width), static_cast<GLsizei>(size / current.row_size),
+			GL_RGBA, GL_UNSIGNED_BYTE, data
+		);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		if (current.offset + size == current.size) {
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	if (current.on_slice_uploaded) {
+		current.on_slice_uploaded(data, size);
+	}
+
+	current.offset += size;
+	m_num_pending_bytes -= size;
+
+	if (current.offset == current.size) {
+		m_tasks.pop_front();
+	}
+
+	return size;
+}